@@ -37,6 +37,8 @@ export default function handler(req, res) {
           'GET /api/screen - Full dashboard PNG',
           'GET /api/zones - Zone-based BMP refresh',
           'GET /api/zones-tiered - Tiered refresh zones',
+          'GET /api/zones-bundle - Multi-zone BMP bundle',
+          'GET /api/zones-sync - Zones changed since a sync cursor',
           'GET /api/zonedata - Zone metadata',
           'GET /api/fullscreen - Full screen PNG',
           'GET /api/livedash - Multi-device renderer'
@@ -0,0 +1,234 @@
+/**
+ * /api/zones-bundle - Multi-Zone BMP Bundle API
+ *
+ * Returns several zone BMPs in one response so a refresh costs one
+ * request instead of one per zone. The firmware reads it as a stream,
+ * one zone at a time, without buffering the whole body.
+ *
+ * Query params (one of ids/tier):
+ * - ids=header,summary,legs: Zone IDs (composite or granular)
+ * - tier=1|2|3|all: All granular zones of a refresh tier
+ * - demo=<scenario>: Use demo scenario data
+ * - force=true: Send every zone, ignoring X-Zone-ETags
+ *
+ * Conditional fetch: the X-Zone-ETags request header lists the ETag the
+ * device holds per zone (`header="abc",legs="def"`). A zone whose ETag
+ * still matches is sent as an unchanged frame with no BMP.
+ *
+ * Request header X-Zone-Codec: rle1 makes every frame payload an rle1
+ * stream instead of a BMP (see src/services/zone-codec.js). ETags are
+ * always those of the BMP, so they stay valid across codecs.
+ *
+ * Response headers X-Next-Change and X-Zone-Next-Change give the seconds
+ * until the zones are next expected to change (src/services/zone-hints.js).
+ *
+ * Request header X-Zone-Delta: rect makes the response version 3. A
+ * changed zone whose X-Zone-ETags base is still known to the server is
+ * then sent as a delta frame: only the changed rectangle, placed at
+ * (x + dx, y + dy) (see src/services/zone-delta.js).
+ *
+ * Response (application/octet-stream, little-endian):
+ *   "CCZB"  u8 version (2, or 3 with deltas)  u8 zoneCount
+ *   per zone:
+ *     u8 idLen, id (ASCII)
+ *     i16 x, i16 y, u16 w, u16 h
+ *     u8 flags (bit 0: changed, bit 1: delta, bit 2: deferred - changed
+ *              but not inlined, fetch /api/zone/:id; only from /api/zones-sync;
+ *              bits 4-5: refresh tier 1-3, 0 if the zone is in none)
+ *     u8 etagLen, etag (ASCII, quoted)       [version 2+]
+ *     i16 dx, i16 dy, u16 dw, u16 dh         [version 3+, delta frames only]
+ *     u32 length, then `length` bytes of 1-bit BMP or rle1 (0 if unchanged)
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+import {
+  generateETag,
+  buildZoneDashboardData,
+  renderZoneBmp,
+  getZoneGeometry,
+  isKnownZone,
+  getKnownZoneIds,
+  getMelbourneTime
+} from '../src/services/zone-bmp.js';
+import { setZoneHintHeaders } from '../src/services/zone-hints.js';
+import {
+  ZONE_CODEC,
+  wantsZoneCodec,
+  encodeZoneRle,
+  encodeRowsRle,
+  rowsToBmp
+} from '../src/services/zone-codec.js';
+import { wantsZoneDelta, rememberZone, planZoneDelta } from '../src/services/zone-delta.js';
+import { ZONES, getZonesForTier, getTierForZone } from '../src/services/ccdash-renderer.js';
+
+export const BUNDLE_MAGIC = 'CCZB';
+export const BUNDLE_VERSION = 2;
+export const BUNDLE_VERSION_DELTA = 3;
+export const BUNDLE_FLAG_CHANGED = 0x01;
+export const BUNDLE_FLAG_DELTA = 0x02;
+export const BUNDLE_FLAG_DEFERRED = 0x04;
+export const BUNDLE_TIER_SHIFT = 4;
+const MAX_BUNDLE_ZONES = 16;
+
+/**
+ * Encode one zone frame header
+ */
+function encodeFrameHeader(id, zone, length, changed = true, etag = '', delta = null, deferred = false, tier = 0) {
+  const idBytes = Buffer.from(id, 'ascii');
+  const etagBytes = Buffer.from(etag, 'ascii');
+  const header = Buffer.alloc(1 + idBytes.length + 8 + 1 + 1 + etagBytes.length + (delta ? 8 : 0) + 4);
+  let o = 0;
+  header.writeUInt8(idBytes.length, o); o += 1;
+  idBytes.copy(header, o); o += idBytes.length;
+  header.writeInt16LE(zone.x, o); o += 2;
+  header.writeInt16LE(zone.y, o); o += 2;
+  header.writeUInt16LE(zone.w, o); o += 2;
+  header.writeUInt16LE(zone.h, o); o += 2;
+  header.writeUInt8((changed ? BUNDLE_FLAG_CHANGED : 0) | (delta ? BUNDLE_FLAG_DELTA : 0) |
+                    (deferred ? BUNDLE_FLAG_DEFERRED : 0) | ((tier & 0x03) << BUNDLE_TIER_SHIFT), o); o += 1;
+  header.writeUInt8(etagBytes.length, o); o += 1;
+  etagBytes.copy(header, o); o += etagBytes.length;
+  if (delta) {
+    header.writeInt16LE(delta.x, o); o += 2;
+    header.writeInt16LE(delta.y, o); o += 2;
+    header.writeUInt16LE(delta.w, o); o += 2;
+    header.writeUInt16LE(delta.h, o); o += 2;
+  }
+  header.writeUInt32LE(length, o);
+  return header;
+}
+
+/**
+ * Build a bundle from rendered zones
+ * Unchanged and deferred entries carry no BMP. Entries with a delta rect
+ * need version 3.
+ * @param {Array<{id: string, zone: object, bmp: Buffer, changed?: boolean, etag?: string, delta?: object, deferred?: boolean, tier?: number}>} entries
+ */
+export function encodeBundle(entries, version = BUNDLE_VERSION) {
+  const parts = [Buffer.from(BUNDLE_MAGIC, 'ascii'), Buffer.from([version, entries.length])];
+  for (const { id, zone, bmp, changed, etag, delta, deferred, tier } of entries) {
+    const body = changed === false || deferred ? Buffer.alloc(0) : bmp;
+    const rect = version >= BUNDLE_VERSION_DELTA && changed !== false && !deferred ? delta : null;
+    parts.push(encodeFrameHeader(id, zone, body.length, changed !== false, etag || '', rect, !!deferred, tier || 0));
+    parts.push(body);
+  }
+  return Buffer.concat(parts);
+}
+
+/**
+ * Wire payload for a changed zone: a delta against baseEtag if allowed and
+ * possible, otherwise the full zone, rle1-encoded if negotiated
+ * @returns {{payload: Buffer, delta: object|null}}
+ */
+export function encodeZonePayload(bmp, baseEtag, { useCodec = false, useDelta = false } = {}) {
+  const plan = useDelta ? planZoneDelta(baseEtag, bmp) : null;
+  if (plan) {
+    return { payload: useCodec ? encodeRowsRle(plan.image) : rowsToBmp(plan.image), delta: plan.rect };
+  }
+  return { payload: useCodec ? encodeZoneRle(bmp) : bmp, delta: null };
+}
+
+/**
+ * Parse the X-Zone-ETags header into { zoneId: etag }
+ */
+export function parseZoneETags(header) {
+  const etags = {};
+  if (!header) return etags;
+  const re = /([\w.-]+)=("[^"]*")/g;
+  let m;
+  while ((m = re.exec(String(header))) !== null) {
+    etags[m[1]] = m[2];
+  }
+  return etags;
+}
+
+/**
+ * Resolve the requested zone IDs from query params
+ */
+export function resolveZoneIds(query) {
+  if (query?.ids) {
+    return String(query.ids).split(',').map(s => s.trim()).filter(Boolean);
+  }
+  const tier = query?.tier;
+  if (tier === 'all') return Object.keys(ZONES);
+  if (tier) return getZonesForTier(parseInt(tier, 10));
+  return [];
+}
+
+export default async function handler(req, res) {
+  try {
+    const ids = resolveZoneIds(req.query);
+
+    if (ids.length === 0 || ids.length > MAX_BUNDLE_ZONES) {
+      return res.status(400).json({
+        error: 'Specify 1-16 zones with ids=<a,b,c> or tier=<1|2|3|all>',
+        available: getKnownZoneIds()
+      });
+    }
+
+    const unknown = ids.filter(id => !isKnownZone(id));
+    if (unknown.length > 0) {
+      return res.status(400).json({
+        error: 'Invalid zone ID',
+        invalid: unknown,
+        available: getKnownZoneIds()
+      });
+    }
+
+    const dashboardData = await buildZoneDashboardData(req.query?.demo);
+    if (!dashboardData) {
+      return res.status(400).json({ error: 'Unknown demo scenario' });
+    }
+
+    const forceRefresh = req.query?.force === 'true';
+    const clientETags = forceRefresh ? {} : parseZoneETags(req.headers?.['x-zone-etags']);
+    const useCodec = wantsZoneCodec(req);
+    const useDelta = wantsZoneDelta(req);
+    let rawBytes = 0;
+
+    const entries = [];
+    for (const id of ids) {
+      const bmp = renderZoneBmp(id, dashboardData);
+      if (!bmp) continue;
+      const etag = generateETag(bmp);
+      rememberZone(etag, bmp);
+      const changed = clientETags[id] !== etag;
+      if (changed) rawBytes += bmp.length;
+
+      const { payload, delta } = changed
+        ? encodeZonePayload(bmp, clientETags[id], { useCodec, useDelta })
+        : { payload: bmp, delta: null };
+      entries.push({ id, zone: getZoneGeometry(id), bmp: payload, changed, etag, delta, tier: getTierForZone(id) });
+    }
+
+    if (entries.length === 0) {
+      return res.status(500).json({ error: 'Zone render failed' });
+    }
+
+    const body = encodeBundle(entries, useDelta ? BUNDLE_VERSION_DELTA : BUNDLE_VERSION);
+
+    res.setHeader('Content-Type', 'application/octet-stream');
+    res.setHeader('Content-Length', body.length);
+    res.setHeader('X-Bundle-Zones', entries.length);
+    res.setHeader('X-Bundle-Changed', entries.filter(e => e.changed).length);
+    res.setHeader('X-Bundle-Deltas', entries.filter(e => e.delta).length);
+    res.setHeader('Vary', 'X-Zone-Codec, X-Zone-Delta');
+    setZoneHintHeaders(res, entries.map(e => e.id), dashboardData, getMelbourneTime());
+    if (useCodec) {
+      res.setHeader('X-Zone-Codec', ZONE_CODEC);
+      res.setHeader('X-Bundle-Raw-Bytes', rawBytes);
+    }
+    res.setHeader('Cache-Control', 'no-cache, no-store, must-revalidate');
+
+    return res.status(200).send(body);
+
+  } catch (error) {
+    console.error('Zone bundle API error:', error);
+    return res.status(500).json({
+      error: 'Zone bundle render failed',
+      message: error.message
+    });
+  }
+}
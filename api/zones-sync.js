@@ -0,0 +1,142 @@
+/**
+ * /api/zones-sync - Sequence-numbered zone sync
+ *
+ * One round trip tells the device exactly which zones changed since the
+ * last sequence number it saw, with the small ones inlined.
+ *
+ * Query params:
+ * - since=<seq>&epoch=<epoch>: Last sync cursor the device applied (omit
+ *   or 0 for a full sync)
+ * - ids=header,summary,legs | tier=1|2|3|all: Zones the device shows
+ * - demo=<scenario>: Use demo scenario data (separate history)
+ *
+ * Request headers as for /api/zones-bundle: X-Zone-Codec, X-Zone-Delta
+ * and X-Zone-ETags (bases for delta frames).
+ *
+ * Response headers: X-Sync-Seq and X-Sync-Epoch, the cursor to send next
+ * time once every listed zone has been drawn; X-Next-Change and
+ * X-Zone-Next-Change, seconds until the requested zones are next expected
+ * to change (src/services/zone-hints.js), on 204 replies too.
+ * - 204: nothing changed since the cursor, no body
+ * - 200: a zone bundle (version 3, see api/zones-bundle.js) holding only
+ *   the changed zones. Zones whose payload exceeds SYNC_INLINE_MAX are
+ *   listed with the deferred flag and no payload; fetch them from
+ *   /api/zone/:id.
+ *
+ * Sequence state lives in KV (see src/services/zone-sync.js).
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+import {
+  generateETag,
+  buildZoneDashboardData,
+  renderZoneBmp,
+  getZoneGeometry,
+  isKnownZone,
+  getKnownZoneIds,
+  getMelbourneTime
+} from '../src/services/zone-bmp.js';
+import { setZoneHintHeaders } from '../src/services/zone-hints.js';
+import { ZONE_CODEC, wantsZoneCodec } from '../src/services/zone-codec.js';
+import { wantsZoneDelta, rememberZone } from '../src/services/zone-delta.js';
+import { advanceZoneSync, zonesChangedSince, parseSyncCursor } from '../src/services/zone-sync.js';
+import { getZoneSyncState, setZoneSyncState } from '../src/data/kv-preferences.js';
+import {
+  BUNDLE_VERSION_DELTA,
+  encodeBundle,
+  encodeZonePayload,
+  parseZoneETags,
+  resolveZoneIds
+} from './zones-bundle.js';
+
+// Larger payloads are deferred to /api/zone/:id so the sync reply stays small
+export const SYNC_INLINE_MAX = 4096;
+const MAX_SYNC_ZONES = 16;
+
+export default async function handler(req, res) {
+  try {
+    const ids = resolveZoneIds(req.query);
+
+    if (ids.length === 0 || ids.length > MAX_SYNC_ZONES) {
+      return res.status(400).json({
+        error: 'Specify 1-16 zones with ids=<a,b,c> or tier=<1|2|3|all>',
+        available: getKnownZoneIds()
+      });
+    }
+
+    const unknown = ids.filter(id => !isKnownZone(id));
+    if (unknown.length > 0) {
+      return res.status(400).json({
+        error: 'Invalid zone ID',
+        invalid: unknown,
+        available: getKnownZoneIds()
+      });
+    }
+
+    const demo = req.query?.demo;
+    const dashboardData = await buildZoneDashboardData(demo);
+    if (!dashboardData) {
+      return res.status(400).json({ error: 'Unknown demo scenario' });
+    }
+
+    const rendered = [];
+    for (const id of ids) {
+      const bmp = renderZoneBmp(id, dashboardData);
+      if (!bmp) continue;
+      const etag = generateETag(bmp);
+      rememberZone(etag, bmp);
+      rendered.push({ id, bmp, etag });
+    }
+
+    if (rendered.length === 0) {
+      return res.status(500).json({ error: 'Zone render failed' });
+    }
+
+    const { state, changed: stateChanged } = advanceZoneSync(await getZoneSyncState(demo), rendered);
+    if (stateChanged) await setZoneSyncState(state, demo);
+
+    const { since, epoch } = parseSyncCursor(req.query);
+    const changedIds = new Set(zonesChangedSince(state, rendered.map(r => r.id), epoch, since));
+
+    res.setHeader('X-Sync-Seq', state.seq);
+    res.setHeader('X-Sync-Epoch', state.epoch);
+    setZoneHintHeaders(res, rendered.map(r => r.id), dashboardData, getMelbourneTime());
+    res.setHeader('Cache-Control', 'no-cache, no-store, must-revalidate');
+
+    if (changedIds.size === 0) {
+      return res.status(204).end();
+    }
+
+    const useCodec = wantsZoneCodec(req);
+    const useDelta = wantsZoneDelta(req);
+    const clientETags = parseZoneETags(req.headers?.['x-zone-etags']);
+
+    const entries = [];
+    for (const { id, bmp, etag } of rendered) {
+      if (!changedIds.has(id)) continue;
+      const { payload, delta } = encodeZonePayload(bmp, clientETags[id], { useCodec, useDelta });
+      const deferred = payload.length > SYNC_INLINE_MAX;
+      entries.push({ id, zone: getZoneGeometry(id), bmp: payload, changed: true, etag, delta, deferred });
+    }
+
+    const body = encodeBundle(entries, BUNDLE_VERSION_DELTA);
+
+    res.setHeader('Content-Type', 'application/octet-stream');
+    res.setHeader('Content-Length', body.length);
+    res.setHeader('X-Bundle-Zones', entries.length);
+    res.setHeader('X-Bundle-Deferred', entries.filter(e => e.deferred).length);
+    res.setHeader('Vary', 'X-Zone-Codec, X-Zone-Delta');
+    if (useCodec) res.setHeader('X-Zone-Codec', ZONE_CODEC);
+
+    return res.status(200).send(body);
+
+  } catch (error) {
+    console.error('Zone sync API error:', error);
+    return res.status(500).json({
+      error: 'Zone sync failed',
+      message: error.message
+    });
+  }
+}
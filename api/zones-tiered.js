@@ -11,6 +11,11 @@
  * - tier: 1, 2, 3, or 'all' (default: 'all')
  * - force=1: Return all zones in tier (ignore change detection)
  * - format=json: Return zone metadata only (no BMP data)
+ *
+ * Response: { tier, timestamp, intervals, zones: [{ id, x, y, w, h, tier,
+ * changed, data }] } where data is the zone BMP in base64. Key order is
+ * part of the contract: the firmware streams `data` straight into its
+ * framebuffer, so geometry must come first and `zones` must be last.
  * 
  * Copyright (c) 2026 Angus Bergman
  * Licensed under CC BY-NC 4.0
@@ -19,7 +24,7 @@
 import { getDepartures, getDisruptions, getWeather } from '../src/services/opendata-client.js';
 import SmartCommute from '../src/engines/smart-commute.js';
 import { getTransitApiKey } from '../src/data/kv-preferences.js';
-import ccdashRenderer, { ZONES, TIER_CONFIG } from '../src/services/ccdash-renderer.js';
+import ccdashRenderer, { ZONES, TIER_CONFIG, getTierForZone } from '../src/services/ccdash-renderer.js';
 import PreferencesManager from '../src/data/preferences-manager.js';
 
 // Singleton engine instance
@@ -266,23 +271,35 @@ export default async function handler(req, res) {
       });
     }
     
-    // Render zones
-    let result = {};
-    if (tierParam === 'all') {
-      // Render all zones
-      result = ccdashRenderer.renderZones(dashboardData, forceAll);
-    } else {
-      // Render only zones for the specified tier
-      const tierZones = ccdashRenderer.getZonesForTier(parseInt(tierParam));
-      for (const zoneId of tierZones) {
-        result[zoneId] = ccdashRenderer.renderSingleZone(zoneId, dashboardData);
-      }
+    // Render zones (all zones for 'all', else the tier's zones)
+    const zoneIds = tierParam === 'all'
+      ? ccdashRenderer.getActiveZones(dashboardData)
+      : ccdashRenderer.getZonesForTier(parseInt(tierParam));
+    const changed = new Set(ccdashRenderer.getChangedZones(dashboardData, forceAll));
+
+    const zones = [];
+    for (const zoneId of zoneIds) {
+      const def = ccdashRenderer.getZoneDefinition(zoneId, dashboardData);
+      const bmp = def ? ccdashRenderer.renderSingleZone(zoneId, dashboardData) : null;
+      if (!bmp) continue;
+      zones.push({
+        id: zoneId,
+        x: def.x,
+        y: def.y,
+        w: def.w,
+        h: def.h,
+        tier: getTierForZone(zoneId),
+        changed: forceAll || changed.has(zoneId),
+        data: bmp.toString('base64')
+      });
     }
 
-    // Add tier intervals to response
-    result.intervals = TIER_CONFIG;
-    result.tier = tierParam;
-    result.timestamp = now.toISOString();
+    const result = {
+      tier: tierParam,
+      timestamp: now.toISOString(),
+      intervals: TIER_CONFIG,
+      zones
+    };
     
     res.setHeader('Content-Type', 'application/json');
     res.setHeader('Cache-Control', 'no-cache, no-store, must-revalidate');
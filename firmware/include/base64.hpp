@@ -1,6 +1,14 @@
 /**
  * Base64 Decoder for Arduino/ESP32
  * Minimal implementation for decoding base64 BMP data
+ *
+ * The decoder is table-driven: one 256-entry lookup per character, and
+ * 16 characters (four quanta) per iteration, stored as three 32-bit words
+ * when the output is word aligned. Whitespace, padding or invalid input
+ * drop to a per-character path for that stretch only.
+ *
+ * Output never overtakes input, so every entry point may decode in place
+ * (output == input).
  */
 
 #ifndef BASE64_HPP
@@ -8,17 +16,72 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 static const char base64_chars[] = 
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+// Sextet value per input byte; 0x80 = not a base64 digit ('=', whitespace, junk)
+static const uint8_t base64_table[256] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3E, 0x80, 0x80, 0x80, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
 static inline int base64_char_value(char c) {
-    if (c >= 'A' && c <= 'Z') return c - 'A';
-    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
-    if (c >= '0' && c <= '9') return c - '0' + 52;
-    if (c == '+') return 62;
-    if (c == '/') return 63;
-    return -1;
+    uint8_t v = base64_table[(uint8_t)c];
+    return v & 0x80 ? -1 : v;
+}
+
+/**
+ * Decode whole 16-character blocks while every character is a digit.
+ * Returns input consumed (a multiple of 16); output gets 3/4 of that.
+ * In-place safe: each block is fully read before any of it is written.
+ */
+static inline size_t base64_decode_blocks(const unsigned char* in, size_t len, unsigned char* out) {
+    size_t done = 0;
+    bool aligned = ((uintptr_t)out & 3) == 0;
+    while (len - done >= 16) {
+        const unsigned char* p = in + done;
+        uint32_t q[4];
+        uint8_t bad = 0;
+        for (int i = 0; i < 4; i++) {
+            uint8_t a = base64_table[p[4 * i]];
+            uint8_t b = base64_table[p[4 * i + 1]];
+            uint8_t c = base64_table[p[4 * i + 2]];
+            uint8_t d = base64_table[p[4 * i + 3]];
+            bad |= a | b | c | d;
+            q[i] = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | d;
+        }
+        if (bad & 0x80) break;
+
+        // 4 x 24 bits -> 12 bytes -> 3 little-endian words
+        unsigned char* o = out + (done / 4) * 3;
+        uint32_t w0 = (q[0] >> 16) | ((q[0] >> 8 & 0xFF) << 8) | ((q[0] & 0xFF) << 16) | ((q[1] >> 16) << 24);
+        uint32_t w1 = (q[1] >> 8 & 0xFF) | ((q[1] & 0xFF) << 8) | ((q[2] >> 16) << 16) | ((q[2] >> 8 & 0xFF) << 24);
+        uint32_t w2 = (q[2] & 0xFF) | ((q[3] >> 16) << 8) | ((q[3] >> 8 & 0xFF) << 16) | ((q[3] & 0xFF) << 24);
+        uint32_t w[3] = { w0, w1, w2 };
+        if (aligned) {
+            memcpy(__builtin_assume_aligned(o, 4), w, 12);   // three word stores
+        } else {
+            memcpy(o, w, 12);
+        }
+        done += 16;
+    }
+    return done;
 }
 
 /**
@@ -35,37 +98,66 @@ static inline size_t decode_base64_length(const unsigned char* input, size_t inp
 }
 
 /**
- * Decode base64 string to binary
+ * Incremental decoder for base64 that arrives in arbitrary pieces (e.g. a
+ * JSON string streamed by JsonStreamParser). Carries up to 18 bits between
+ * calls, so pieces need not be aligned to 4-character quanta.
  */
-static inline size_t decode_base64(const unsigned char* input, size_t inputLen, unsigned char* output) {
-    if (inputLen == 0) return 0;
-    
-    size_t outputLen = 0;
-    uint32_t buffer = 0;
-    int bits = 0;
-    
-    for (size_t i = 0; i < inputLen; i++) {
-        char c = input[i];
-        
-        // Skip whitespace
-        if (c == '\n' || c == '\r' || c == ' ' || c == '\t') continue;
-        
-        // Stop at padding
-        if (c == '=') break;
-        
-        int value = base64_char_value(c);
-        if (value < 0) continue;  // Invalid char, skip
-        
-        buffer = (buffer << 6) | value;
-        bits += 6;
-        
-        if (bits >= 8) {
-            bits -= 8;
-            output[outputLen++] = (buffer >> bits) & 0xFF;
+class Base64StreamDecoder {
+public:
+    Base64StreamDecoder() { reset(); }
+
+    void reset() {
+        buffer = 0;
+        bits = 0;
+        ended = false;
+    }
+
+    /**
+     * Decode the next piece. output must hold (inputLen * 3) / 4 + 2 bytes,
+     * or be input itself. Returns bytes written.
+     */
+    size_t decode(const char* input, size_t inputLen, unsigned char* output) {
+        const unsigned char* in = (const unsigned char*)input;
+        size_t outputLen = 0;
+        size_t i = 0;
+        while (i < inputLen && !ended) {
+            // Block kernel whenever we sit on a quantum boundary
+            if (bits == 0 && inputLen - i >= 16) {
+                size_t n = base64_decode_blocks(in + i, inputLen - i, output + outputLen);
+                i += n;
+                outputLen += (n / 4) * 3;
+                if (i >= inputLen) break;
+            }
+
+            // One character: whitespace, padding, junk, or a tail
+            unsigned char c = in[i++];
+            uint8_t value = base64_table[c];
+            if (value & 0x80) {
+                if (c == '=') ended = true;
+                continue;   // whitespace / invalid, skip
+            }
+            buffer = (buffer << 6) | value;
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                output[outputLen++] = (buffer >> bits) & 0xFF;
+            }
         }
+        return outputLen;
     }
-    
-    return outputLen;
+
+private:
+    uint32_t buffer;
+    int bits;
+    bool ended;
+};
+
+/**
+ * Decode base64 string to binary. output may equal input.
+ */
+static inline size_t decode_base64(const unsigned char* input, size_t inputLen, unsigned char* output) {
+    Base64StreamDecoder decoder;
+    return decoder.decode((const char*)input, inputLen, output);
 }
 
 #endif // BASE64_HPP
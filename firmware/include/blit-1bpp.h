@@ -0,0 +1,167 @@
+/**
+ * 1-bit Blitter
+ * Copies packed 1-bpp rows into a 1-bpp framebuffer or panel RAM
+ *
+ * Replaces per-pixel drawPixel() loops (a bit extract, bounds check and
+ * read-modify-write per pixel, 384,000 calls for a full screen). Rows are
+ * moved 32 bits at a time: four source bytes are loaded big-endian,
+ * optionally inverted, shifted into place for any destination x and
+ * stored. Only the first and last byte of a row need masking.
+ *
+ * Source: MSB first, `stride` bytes per row (BMP padding is fine).
+ * Destination: MSB first, 1 = white (bb_epaper framebuffer / panel RAM).
+ *
+ * Flags:
+ *   BLIT_INVERT    source bits are 1 = black (logos, prerendered screens)
+ *   BLIT_FLIP_Y    source rows are bottom-up (positive-height BMP)
+ *   BLIT_INK_ONLY  draw black pixels only, leave the rest of dst as is
+ *                  (what the old drawPixel(BBEP_BLACK) loops did)
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef BLIT_1BPP_H
+#define BLIT_1BPP_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define BLIT_INVERT   0x01
+#define BLIT_FLIP_Y   0x02
+#define BLIT_INK_ONLY 0x04
+
+#ifndef BLIT_PANEL_BAND
+#define BLIT_PANEL_BAND 1024   // stack band for the panel-RAM path
+#endif
+
+static inline uint32_t blitLoad32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void blitStore32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * Blit one row of w pixels to dst, starting `shift` (0-7) bits into dst[0]
+ */
+static inline void blitRow(uint8_t* dst, int shift, const uint8_t* src, int w, uint8_t flags) {
+    const uint8_t inv = (flags & BLIT_INVERT) ? 0xFF : 0x00;
+    const uint32_t inv32 = inv ? 0xFFFFFFFFu : 0;
+    const bool inkOnly = flags & BLIT_INK_ONLY;
+    const int srcBytes = (w + 7) >> 3;
+    const int dstBytes = (shift + w + 7) >> 3;
+    const uint8_t firstMask = (uint8_t)(0xFF >> shift);
+    const uint8_t lastMask = (uint8_t)(0xFF << (7 - ((shift + w - 1) & 7)));
+
+    // Destination byte k takes the low bits of src[k-1] and the high bits of src[k]
+    auto srcByte = [&](int i) -> uint8_t { return (i >= 0 && i < srcBytes) ? src[i] ^ inv : inv; };
+    auto dstByte = [&](int k) -> uint8_t {
+        return shift ? (uint8_t)((srcByte(k - 1) << (8 - shift)) | (srcByte(k) >> shift)) : srcByte(k);
+    };
+    auto put = [&](int k, uint8_t v, uint8_t mask) {
+        if (inkOnly) dst[k] &= v | ~mask;
+        else dst[k] = (dst[k] & ~mask) | (v & mask);
+    };
+
+    if (dstBytes == 1) {
+        put(0, dstByte(0), firstMask & lastMask);
+        return;
+    }
+    put(0, dstByte(0), firstMask);
+
+    // Whole words: dst[k..k+3] from src[k-1..k+3], all inside both rows
+    int k = 1;
+    if (shift) {
+        for (; k + 4 <= srcBytes && k + 4 < dstBytes; k += 4) {
+            uint32_t v = ((blitLoad32(src + k) ^ inv32) >> shift) |
+                         ((uint32_t)(uint8_t)(src[k - 1] ^ inv) << (32 - shift));
+            if (inkOnly) v &= blitLoad32(dst + k);
+            blitStore32(dst + k, v);
+        }
+    } else {
+        for (; k + 4 <= srcBytes && k + 4 < dstBytes; k += 4) {
+            uint32_t v = blitLoad32(src + k) ^ inv32;
+            if (inkOnly) v &= blitLoad32(dst + k);
+            blitStore32(dst + k, v);
+        }
+    }
+
+    for (; k < dstBytes - 1; k++) put(k, dstByte(k), 0xFF);
+    put(dstBytes - 1, dstByte(dstBytes - 1), lastMask);
+}
+
+/**
+ * Blit a w x h 1-bpp image into a framebuffer at (x, y), clipped to
+ * fbWidth x fbHeight. Returns false if nothing was drawn.
+ */
+static inline bool blit1bpp(uint8_t* fb, int pitch, int fbWidth, int fbHeight, int x, int y,
+                            const uint8_t* src, int stride, int w, int h, uint8_t flags = 0) {
+    if (!fb || !src || x < 0 || x >= fbWidth || y >= fbHeight || w <= 0 || h <= 0) return false;
+    if (x + w > fbWidth) w = fbWidth - x;
+    int row0 = y < 0 ? -y : 0;
+    int row1 = (y + h > fbHeight) ? fbHeight - y : h;
+    if (row0 >= row1) return false;
+
+    uint8_t* d = fb + (y + row0) * pitch + (x >> 3);
+    for (int r = row0; r < row1; r++, d += pitch) {
+        int sr = (flags & BLIT_FLIP_Y) ? h - 1 - r : r;
+        blitRow(d, x & 7, src + sr * stride, w, flags);
+    }
+    return true;
+}
+
+/**
+ * Blit into panel RAM through an address window (bufferless bb_epaper).
+ * The window is widened to whole bytes; the extra edge pixels and
+ * BLIT_INK_ONLY background come out white, so draw onto a white area.
+ * Panel is BBEPAPER; templated so this header does not pull in bb_epaper.
+ */
+template <class Panel>
+bool blit1bppToPanel(Panel* panel, int x, int y, const uint8_t* src, int stride, int w, int h,
+                     uint8_t flags = 0, int plane = 0 /* PLANE_0 */) {
+    if (!panel || !src || x < 0 || y < 0 || w <= 0 || h <= 0) return false;
+    if (x + w > panel->width()) w = panel->width() - x;
+    int rows = (y + h > panel->height()) ? panel->height() - y : h;
+    if (w <= 0 || rows <= 0) return false;
+
+    const int shift = x & 7;
+    const int rowBytes = (shift + w + 7) >> 3;
+    if (rowBytes > BLIT_PANEL_BAND) return false;
+    const int bandRows = BLIT_PANEL_BAND / rowBytes;
+    uint8_t band[BLIT_PANEL_BAND];
+
+    panel->setAddrWindow(x & ~7, y, rowBytes * 8, rows);
+    panel->startWrite(plane);
+    for (int r = 0; r < rows; r += bandRows) {
+        int n = (rows - r < bandRows) ? rows - r : bandRows;
+        memset(band, 0xFF, n * rowBytes);
+        for (int i = 0; i < n; i++) {
+            int sr = (flags & BLIT_FLIP_Y) ? h - 1 - (r + i) : r + i;
+            blitRow(band + i * rowBytes, shift, src + sr * stride, w, flags);
+        }
+        panel->writeData(band, n * rowBytes);
+    }
+    return true;
+}
+
+/**
+ * Blit to a bb_epaper display: into its framebuffer if it has one,
+ * otherwise straight into panel RAM. Assumes rotation 0.
+ */
+template <class Panel>
+bool blit1bppToDisplay(Panel* panel, int x, int y, const uint8_t* src, int stride, int w, int h,
+                       uint8_t flags = 0) {
+    uint8_t* fb = (uint8_t*)panel->getBuffer();
+    if (fb) {
+        return blit1bpp(fb, (panel->width() + 7) >> 3, panel->width(), panel->height(),
+                        x, y, src, stride, w, h, flags);
+    }
+    return blit1bppToPanel(panel, x, y, src, stride, w, h, flags);
+}
+
+#endif // BLIT_1BPP_H
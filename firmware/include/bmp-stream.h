@@ -0,0 +1,462 @@
+/**
+ * Streaming 1-bit BMP Decoder
+ * Decodes a zone BMP as it arrives and writes it to the panel in bands
+ *
+ * Zone BMPs used to be read whole into a 35-45 KB heap buffer before
+ * loadBMP()/drawPixel(). That buffer plus the ~42 KB TLS context is what
+ * caused ANTI-BRICK Incident #5. The decoder here holds only the header
+ * and one band of rows (BMP_STREAM_BAND_SIZE, default 2 KB):
+ *
+ *   bytes -> feed() -> header parse -> row band -> BmpRowSink
+ *
+ * - Bottom-up (positive height) and top-down (negative height) BMPs
+ * - Either palette order: bits are normalised so 1 = white, matching
+ *   the panel RAM and bb_epaper's 1-bpp framebuffer
+ * - Fed in arbitrary pieces, so it works with chunked responses that have
+ *   no Content-Length
+ *
+ * Sinks:
+ *   PanelWindowSink  - writes bands straight into controller RAM via an
+ *                      address window (x must be a multiple of 8)
+ *   FramebufferSink  - merges bands into a 1-bpp framebuffer at any x
+ *
+ * The Stream adapters (BmpStreamWriter, GatedBmpWriter) and logging are
+ * device-only; the decoder and sinks build on the host for tests.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef BMP_STREAM_H
+#define BMP_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "blit-1bpp.h"
+#include "panel-window.h"
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#endif
+
+#ifndef BMP_STREAM_BAND_SIZE
+#define BMP_STREAM_BAND_SIZE 2048
+#endif
+
+#define BMP_STREAM_HEADER_MAX 64   // file header + BITMAPINFOHEADER fields we read
+
+#ifndef BMP_STREAM_ROW_MAX
+#define BMP_STREAM_ROW_MAX 100     // bytes of one 800 px row, for toggle counting
+#endif
+
+/**
+ * Receives decoded rows, top to bottom, 1 bit per pixel, 1 = white
+ */
+class BmpRowSink {
+public:
+    virtual ~BmpRowSink() {}
+    /** Called once the header is parsed. Return false to reject the image. */
+    virtual bool begin(int /*width*/, int /*height*/) { return true; }
+    /** Rows y .. y+rows-1 of the image, each rowBytes long */
+    virtual bool writeRows(int y, int rows, const uint8_t* data, int rowBytes) = 0;
+    virtual void end() {}
+};
+
+class BmpStreamDecoder {
+public:
+    enum Result { NEED_MORE = 0, DONE = 1, FAILED = -1 };
+
+    /**
+     * @param band  Caller-owned row band buffer (must hold at least one row)
+     */
+    BmpStreamDecoder(uint8_t* band, size_t bandSize) : band(band), bandSize(bandSize) {
+        reset(nullptr);
+    }
+
+    void reset(BmpRowSink* rowSink) {
+        sink = rowSink;
+        state = HEADER;
+        pos = 0;
+        dataOffset = 0;
+        paletteOffset = 0;
+        invert = false;
+        width = height = 0;
+        rowsDone = 0;
+        rowPos = 0;
+        bandRows = 0;
+    }
+
+    /**
+     * Feed the next piece of the file. Returns DONE once every row has
+     * been delivered, FAILED on a malformed or unsupported image.
+     */
+    Result feed(const uint8_t* data, size_t len) {
+        while (len > 0) {
+            if (state == ROWS) {
+                size_t n = consumeRows(data, len);
+                if (state == FAIL) return FAILED;
+                data += n;
+                len -= n;
+                continue;
+            }
+            if (state == DONE_STATE) return DONE;
+            if (state == FAIL) return FAILED;
+
+            // Header, palette and any gap before the pixel data
+            uint8_t b = *data++;
+            len--;
+            if (pos < BMP_STREAM_HEADER_MAX) hdr[pos] = b;
+            if (paletteOffset && pos >= paletteOffset && pos < paletteOffset + 8) {
+                palette[pos - paletteOffset] = b;
+            }
+            pos++;
+
+            if (pos == 54 && !parseHeader()) {
+                state = FAIL;
+                return FAILED;
+            }
+            if (pos > 54 && pos == dataOffset) startRows();
+        }
+        return state == DONE_STATE ? DONE : (state == FAIL ? FAILED : NEED_MORE);
+    }
+
+    bool done() const { return state == DONE_STATE; }
+    int imageWidth() const { return width; }
+    int imageHeight() const { return height; }
+
+private:
+    enum State { HEADER, ROWS, DONE_STATE, FAIL };
+
+    uint8_t* band;
+    size_t bandSize;
+    BmpRowSink* sink;
+    State state;
+
+    uint8_t hdr[BMP_STREAM_HEADER_MAX];
+    uint8_t palette[8];
+    uint32_t pos;
+    uint32_t dataOffset;
+    uint32_t paletteOffset;
+    bool invert;
+    bool bottomUp;
+
+    int width, height;
+    int rowBytes;       // packed bytes per output row
+    int stride;         // BMP row stride (4-byte aligned)
+    uint8_t lastMask;   // pad bits of the last byte in a row
+    int rowsPerBand;
+    int rowsDone;       // rows fully received
+    int rowPos;         // byte position within the current BMP row
+    int bandRows;       // rows currently in the band
+
+    static uint32_t le32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    bool parseHeader() {
+        if (hdr[0] != 'B' || hdr[1] != 'M') return false;
+        dataOffset = le32(hdr + 10);
+        uint32_t infoSize = le32(hdr + 14);
+        int32_t w = (int32_t)le32(hdr + 18);
+        int32_t h = (int32_t)le32(hdr + 22);
+        uint16_t bpp = hdr[28] | (hdr[29] << 8);
+        uint32_t compression = le32(hdr + 30);
+
+        if (bpp != 1 || compression != 0 || w <= 0 || h == 0) {
+#ifdef ESP_PLATFORM
+            Serial.printf("[BMP] Unsupported: %ldx%ld %u bpp comp %lu\n",
+                          (long)w, (long)h, bpp, (unsigned long)compression);
+#endif
+            return false;
+        }
+        paletteOffset = 14 + infoSize;
+        if (dataOffset < paletteOffset + 8) return false;
+
+        bottomUp = h > 0;
+        width = w;
+        height = bottomUp ? h : -h;
+        rowBytes = (width + 7) / 8;
+        stride = ((width + 31) / 32) * 4;
+        lastMask = (width & 7) ? (uint8_t)(0xFF >> (width & 7)) : 0;
+        rowsPerBand = bandSize / rowBytes;
+        if (rowsPerBand < 1) {
+#ifdef ESP_PLATFORM
+            Serial.printf("[BMP] Row of %d bytes exceeds band\n", rowBytes);
+#endif
+            return false;
+        }
+        if (sink && !sink->begin(width, height)) return false;
+        return true;
+    }
+
+    void startRows() {
+        // Palette entry 0 is B,G,R,0. If index 0 is the light colour the
+        // bits already mean 1 = dark and must be flipped.
+        int luma0 = palette[0] + palette[1] + palette[2];
+        int luma1 = palette[4] + palette[5] + palette[6];
+        invert = luma0 > luma1;
+        rowsDone = 0;
+        rowPos = 0;
+        bandRows = 0;
+        state = ROWS;
+    }
+
+    size_t consumeRows(const uint8_t* data, size_t len) {
+        size_t used = 0;
+        while (used < len && state == ROWS) {
+            if (rowPos < rowBytes) {
+                uint8_t* dst = band + bandRows * rowBytes + rowPos;
+                size_t n = rowBytes - rowPos;
+                if (n > len - used) n = len - used;
+                if (invert) {
+                    for (size_t i = 0; i < n; i++) dst[i] = ~data[used + i];
+                } else {
+                    memcpy(dst, data + used, n);
+                }
+                rowPos += n;
+                used += n;
+            } else {
+                // Row padding
+                size_t n = stride - rowPos;
+                if (n > len - used) n = len - used;
+                rowPos += n;
+                used += n;
+            }
+
+            if (rowPos == stride) {
+                if (lastMask) band[bandRows * rowBytes + rowBytes - 1] |= lastMask;
+                rowPos = 0;
+                bandRows++;
+                rowsDone++;
+                if (bandRows == rowsPerBand || rowsDone == height) {
+                    if (!flushBand()) {
+                        state = FAIL;
+                        break;
+                    }
+                }
+                if (rowsDone == height) {
+                    if (sink) sink->end();
+                    state = DONE_STATE;
+                }
+            }
+        }
+        return used;
+    }
+
+    /**
+     * Hand the band to the sink top-down, reversing it for bottom-up files
+     */
+    bool flushBand() {
+        int y;
+        if (bottomUp) {
+            for (int a = 0, b = bandRows - 1; a < b; a++, b--) {
+                uint8_t* ra = band + a * rowBytes;
+                uint8_t* rb = band + b * rowBytes;
+                for (int i = 0; i < rowBytes; i++) {
+                    uint8_t t = ra[i];
+                    ra[i] = rb[i];
+                    rb[i] = t;
+                }
+            }
+            y = height - rowsDone;
+        } else {
+            y = rowsDone - bandRows;
+        }
+        bool ok = !sink || sink->writeRows(y, bandRows, band, rowBytes);
+        bandRows = 0;
+        return ok;
+    }
+};
+
+#ifdef ESP_PLATFORM
+/**
+ * Stream adapter so HTTPClient::writeToStream() can feed the decoder
+ * directly. writeToStream() also strips chunked transfer encoding.
+ */
+class BmpStreamWriter : public Stream {
+public:
+    explicit BmpStreamWriter(BmpStreamDecoder& decoder) : decoder(decoder), failed(false) {}
+
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (!failed && decoder.feed(buf, len) == BmpStreamDecoder::FAILED) failed = true;
+        return len;   // keep draining the body even after a decode error
+    }
+    size_t write(uint8_t b) override { return write(&b, 1); }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+
+    /** True if a complete image was decoded */
+    bool ok() const { return !failed && decoder.done(); }
+
+private:
+    BmpStreamDecoder& decoder;
+    bool failed;
+};
+
+/**
+ * BmpStreamWriter that holds the body back while the panel is still
+ * refreshing the previous zone, so the request, TLS and server time of
+ * zone N+1 overlap the waveform of zone N. Up to spillSize bytes are kept
+ * in `spill`; once that is full, or panelBusy() turns false, it calls
+ * waitPanel() and feeds the decoder (which only then touches panel RAM).
+ * Call finish() after the body has been read.
+ */
+class GatedBmpWriter : public Stream {
+public:
+    GatedBmpWriter(BmpStreamDecoder& decoder, uint8_t* spill, size_t spillSize,
+                   bool (*panelBusy)(), void (*waitPanel)())
+        : decoder(decoder), spill(spill), spillSize(spillSize), panelBusy(panelBusy),
+          waitPanel(waitPanel), held(0), heldMax(0), open(false), failed(false) {}
+
+    size_t write(const uint8_t* buf, size_t len) override {
+        size_t total = len;
+        if (!open && panelBusy && panelBusy()) {
+            size_t n = min(len, spillSize - held);
+            memcpy(spill + held, buf, n);
+            held += n;
+            if (held > heldMax) heldMax = held;
+            buf += n;
+            len -= n;
+            if (len == 0) return total;
+        }
+        if (!open) openGate();
+        feed(buf, len);
+        return total;
+    }
+    size_t write(uint8_t b) override { return write(&b, 1); }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+
+    /** Feed whatever is still held (waits for the panel if need be) */
+    void finish() {
+        if (!open) openGate();
+    }
+
+    /** True if a complete image was decoded */
+    bool ok() const { return !failed && decoder.done(); }
+    /** Most body bytes held while the panel was busy */
+    size_t heldBytes() const { return heldMax; }
+
+private:
+    void openGate() {
+        if (waitPanel) waitPanel();
+        open = true;
+        feed(spill, held);
+        held = 0;
+    }
+
+    void feed(const uint8_t* buf, size_t len) {
+        if (len && !failed && decoder.feed(buf, len) == BmpStreamDecoder::FAILED) failed = true;
+    }
+
+    BmpStreamDecoder& decoder;
+    uint8_t* spill;
+    size_t spillSize;
+    bool (*panelBusy)();
+    void (*waitPanel)();
+    size_t held, heldMax;
+    bool open;
+    bool failed;
+};
+#endif // ESP_PLATFORM
+
+/**
+ * Writes bands straight into the panel controller RAM through an
+ * address window. No framebuffer is needed (bufferless bb_epaper).
+ * Panel is BBEPAPER; templated so this header does not pull in bb_epaper.
+ */
+template <class Panel>
+class PanelWindowSink : public BmpRowSink {
+public:
+    PanelWindowSink(Panel* panel, int x, int y, int plane = 0 /* PLANE_0 */)
+        : panel(panel), x(x), y(y), plane(plane), width(0) {}
+
+    // A failed decode never reaches end(); do not leave a band in flight
+    ~PanelWindowSink() { panelFlushData(); }
+
+    bool begin(int w, int h) override {
+        if (x & 7) {
+#ifdef ESP_PLATFORM
+            Serial.printf("[BMP] Window x=%d not byte aligned\n", x);
+#endif
+            return false;
+        }
+        if (x + w > panel->width() || y + h > panel->height()) return false;
+        width = w;
+        return true;
+    }
+
+    /**
+     * One window per band (bottom-up files arrive last band first). With a
+     * DMA writer the band is copied and clocked out while the decoder
+     * fills the next one; the previous band is flushed before the window
+     * command.
+     */
+    bool writeRows(int row, int rows, const uint8_t* data, int rowBytes) override {
+        panelFlushData();
+        panel->setAddrWindow(x, y + row, rowBytes * 8, rows);
+        panel->startWrite(plane);
+        panelWriteData(panel, data, rows * rowBytes);
+        if (panelDataWriter()) panelDataWriter()->send();
+        return true;
+    }
+
+    void end() override { panelFlushData(); }
+
+private:
+    Panel* panel;
+    int x, y;
+    int plane;
+    int width;
+};
+
+/**
+ * Merges bands into a 1-bpp, MSB-first framebuffer (1 = white) at any x
+ */
+class FramebufferSink : public BmpRowSink {
+public:
+    FramebufferSink(uint8_t* fb, int pitch, int fbHeight, int x, int y)
+        : fb(fb), pitch(pitch), fbHeight(fbHeight), x(x), y(y), width(0), toggled(0) {}
+
+    bool begin(int w, int h) override {
+        if (!fb || x < 0 || y < 0 || (x + w + 7) / 8 > pitch || y + h > fbHeight) return false;
+        width = w;
+        toggled = 0;
+        return true;
+    }
+
+    bool writeRows(int row, int rows, const uint8_t* data, int rowBytes) override {
+        // Count flipped pixels on the way (ghosting accounting): keep the
+        // old bytes of each row and compare after the blit
+        const int first = x >> 3;
+        const int span = ((x + width + 7) >> 3) - first;
+        uint8_t old[BMP_STREAM_ROW_MAX + 1];
+        for (int r = 0; r < rows && y + row + r < fbHeight; r++) {
+            uint8_t* dst = fb + (y + row + r) * pitch + first;
+            if (span <= (int)sizeof(old)) memcpy(old, dst, span);
+            blit1bpp(fb, pitch, pitch * 8, fbHeight, x, y + row + r, data + r * rowBytes, rowBytes, width, 1);
+            if (span > (int)sizeof(old)) continue;
+            for (int i = 0; i < span; i++) toggled += __builtin_popcount((uint8_t)(old[i] ^ dst[i]));
+        }
+        return true;
+    }
+
+    /** Pixels whose value changed since begin() */
+    int32_t toggledPixels() const { return toggled; }
+
+private:
+    uint8_t* fb;
+    int pitch, fbHeight;
+    int x, y;
+    int width;
+    int32_t toggled;
+};
+
+#endif // BMP_STREAM_H
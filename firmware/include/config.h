@@ -27,6 +27,29 @@
 #define API_ZONEDATA_ENDPOINT "/api/zonedata"
 #define API_STATUS_ENDPOINT "/api/status"
 
+// =============================================================================
+// TLS
+// =============================================================================
+
+// The server chain is always verified, against the Let's Encrypt roots in
+// tls-ca.h. For a server on another CA, point TLS_CA_PEM at a PEM string
+// holding its root(s):
+// #define TLS_CA_PEM MY_ROOT_CA_PEM
+
+// Optional public-key pins on top of that: hex SHA-256 of the
+// SubjectPublicKeyInfo of a certificate in the verified chain. Pin a root,
+// or an intermediate with its successor as the backup; never a leaf, whose
+// key changes at every renewal.
+// Empty = CA verification only.
+//   openssl s_client -connect host:443 -showcerts </dev/null |
+//     openssl x509 -pubkey -noout | openssl pkey -pubin -outform der |
+//     openssl dgst -sha256
+#define TLS_PIN_SHA256 ""
+#define TLS_PIN_SHA256_BACKUP ""
+
+// Handshake timeout
+#define TLS_HANDSHAKE_TIMEOUT_MS 15000
+
 // =============================================================================
 // WIFI CONFIGURATION
 // =============================================================================
@@ -50,7 +73,8 @@
 #define TIER2_REFRESH_INTERVAL 120000    // 2 minutes - content (weather, legs) - only if changed
 #define TIER3_REFRESH_INTERVAL 300000    // 5 minutes - static (location bar)
 
-// Full refresh every 10 minutes (prevents ghosting)
+// Legacy fixed full refresh interval (main.cpp and tiered schedule full
+// refreshes from per-zone ghosting instead, see ghost-tracker.h)
 #define DEFAULT_FULL_REFRESH 600000
 
 // Timeouts
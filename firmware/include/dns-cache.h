@@ -0,0 +1,279 @@
+/**
+ * DNS Cache
+ * Resolved server address with its TTL, kept in RTC memory
+ *
+ * Each cycle opened its connection with connect(host, ...), and lwIP's
+ * own cache lives in RAM, so after every wake the server name was looked
+ * up again: one more round trip to the resolver before the TCP SYN,
+ * usually tens of ms and sometimes seconds. The cache here sends its own
+ * A query, which tells it the record's TTL, and keeps name, address and
+ * expiry in RTC memory on rtcClockMs() (sleep-cycle.h), which keeps
+ * counting through deep sleep.
+ *
+ *   IPAddress ip;
+ *   bool cached;
+ *   if (dnsCacheResolve(host, ip, cached)) client.connect(ip, port, host, timeout);
+ *
+ * If a connect to a cached address fails, forget() the name and resolve
+ * again (ZoneConnection::open() does this).
+ *
+ * TTLs are clamped to DNS_CACHE_MIN_TTL_S..DNS_CACHE_MAX_TTL_S. The floor
+ * outlives the short TTLs CDNs hand out across a few sleep cycles. That
+ * is safe: TLS verifies the server's certificate chain and host name
+ * (tls-session.h) whatever address it reached, so a stale or spoofed
+ * address fails the handshake and only costs the fallback lookup.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "sleep-cycle.h"
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_system.h>
+#include <esp_attr.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR
+#endif
+
+#ifndef DNS_CACHE_SLOTS
+#define DNS_CACHE_SLOTS 2
+#endif
+
+#ifndef DNS_CACHE_MIN_TTL_S
+#define DNS_CACHE_MIN_TTL_S 300
+#endif
+
+#ifndef DNS_CACHE_MAX_TTL_S
+#define DNS_CACHE_MAX_TTL_S 86400
+#endif
+
+#ifndef DNS_QUERY_TIMEOUT_MS
+#define DNS_QUERY_TIMEOUT_MS 1500
+#endif
+
+#define DNS_HOST_MAX 64
+#define DNS_MSG_MAX 512
+
+struct DnsCacheEntry {
+    char host[DNS_HOST_MAX];
+    uint32_t addr;                   // IPv4, network byte order in memory (as IPAddress)
+    uint64_t expiresMs;              // rtcClockMs()
+};
+
+struct DnsCacheTable {
+    DnsCacheEntry entries[DNS_CACHE_SLOTS];
+};
+
+class DnsCache {
+public:
+    explicit DnsCache(RtcBlock<DnsCacheTable>& slot) : slot(slot) {}
+
+    /** Cached address of `host` if it has not expired at `now` */
+    bool lookup(const char* host, uint64_t now, uint32_t& addr) {
+        if (!slot.valid()) return false;
+        for (int i = 0; i < DNS_CACHE_SLOTS; i++) {
+            const DnsCacheEntry& e = slot.data.entries[i];
+            if (e.host[0] && strcmp(e.host, host) == 0 && now < e.expiresMs) {
+                addr = e.addr;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void store(const char* host, uint32_t addr, uint32_t ttlS, uint64_t now) {
+        if (strlen(host) >= DNS_HOST_MAX) return;
+        if (!slot.valid()) slot.clear();
+        if (ttlS < DNS_CACHE_MIN_TTL_S) ttlS = DNS_CACHE_MIN_TTL_S;
+        if (ttlS > DNS_CACHE_MAX_TTL_S) ttlS = DNS_CACHE_MAX_TTL_S;
+
+        // Same name, else an empty slot, else the one expiring first
+        DnsCacheEntry* e = nullptr;
+        for (int i = 0; i < DNS_CACHE_SLOTS && !e; i++) {
+            if (strcmp(slot.data.entries[i].host, host) == 0) e = &slot.data.entries[i];
+        }
+        for (int i = 0; i < DNS_CACHE_SLOTS && !e; i++) {
+            if (!slot.data.entries[i].host[0]) e = &slot.data.entries[i];
+        }
+        if (!e) {
+            e = &slot.data.entries[0];
+            for (int i = 1; i < DNS_CACHE_SLOTS; i++) {
+                if (slot.data.entries[i].expiresMs < e->expiresMs) e = &slot.data.entries[i];
+            }
+        }
+        memset(e, 0, sizeof(*e));
+        strcpy(e->host, host);
+        e->addr = addr;
+        e->expiresMs = now + (uint64_t)ttlS * 1000;
+        slot.seal();
+    }
+
+    void forget(const char* host) {
+        if (!slot.valid()) return;
+        for (int i = 0; i < DNS_CACHE_SLOTS; i++) {
+            if (strcmp(slot.data.entries[i].host, host) == 0) memset(&slot.data.entries[i], 0, sizeof(DnsCacheEntry));
+        }
+        slot.seal();
+    }
+
+private:
+    RtcBlock<DnsCacheTable>& slot;
+};
+
+/**
+ * Standard recursive A query for `host`. Returns the message length, or
+ * -1 if it does not fit or a label is too long.
+ */
+static inline int dnsBuildQuery(uint8_t* buf, size_t cap, uint16_t id, const char* host) {
+    size_t hostLen = strlen(host);
+    if (cap < 12 + hostLen + 2 + 4) return -1;
+    memset(buf, 0, 12);
+    buf[0] = id >> 8;
+    buf[1] = id & 0xFF;
+    buf[2] = 0x01;                   // RD
+    buf[5] = 1;                      // QDCOUNT
+    size_t pos = 12;
+    const char* label = host;
+    for (;;) {
+        const char* dot = strchr(label, '.');
+        size_t n = dot ? (size_t)(dot - label) : strlen(label);
+        if (n == 0 || n > 63) return -1;
+        buf[pos++] = (uint8_t)n;
+        memcpy(buf + pos, label, n);
+        pos += n;
+        if (!dot) break;
+        label = dot + 1;
+    }
+    buf[pos++] = 0;
+    buf[pos++] = 0; buf[pos++] = 1;  // QTYPE A
+    buf[pos++] = 0; buf[pos++] = 1;  // QCLASS IN
+    return (int)pos;
+}
+
+// Position after the (possibly compressed) name at `pos`, or 0 if malformed
+static inline size_t dnsSkipName(const uint8_t* msg, size_t len, size_t pos) {
+    while (pos < len) {
+        uint8_t n = msg[pos];
+        if (n == 0) return pos + 1;
+        if ((n & 0xC0) == 0xC0) return pos + 2 <= len ? pos + 2 : 0;
+        pos += 1 + n;
+    }
+    return 0;
+}
+
+/**
+ * First A record of a response to query `id`. `ttl` is the lowest TTL
+ * along the answer chain up to it (CNAMEs included).
+ */
+static inline bool dnsParseResponse(const uint8_t* msg, size_t len, uint16_t id, uint32_t& addr, uint32_t& ttl) {
+    if (len < 12) return false;
+    if (((msg[0] << 8) | msg[1]) != id) return false;
+    if (!(msg[2] & 0x80) || (msg[3] & 0x0F) != 0) return false;   // not a response, or RCODE
+    int qd = (msg[4] << 8) | msg[5];
+    int an = (msg[6] << 8) | msg[7];
+
+    size_t pos = 12;
+    for (int i = 0; i < qd; i++) {
+        pos = dnsSkipName(msg, len, pos);
+        if (pos == 0 || pos + 4 > len) return false;
+        pos += 4;
+    }
+
+    uint32_t minTtl = UINT32_MAX;
+    for (int i = 0; i < an; i++) {
+        pos = dnsSkipName(msg, len, pos);
+        if (pos == 0 || pos + 10 > len) return false;
+        uint16_t type = (msg[pos] << 8) | msg[pos + 1];
+        uint16_t cls = (msg[pos + 2] << 8) | msg[pos + 3];
+        uint32_t t = ((uint32_t)msg[pos + 4] << 24) | ((uint32_t)msg[pos + 5] << 16) | (msg[pos + 6] << 8) | msg[pos + 7];
+        uint16_t rdLen = (msg[pos + 8] << 8) | msg[pos + 9];
+        pos += 10;
+        if (pos + rdLen > len) return false;
+        if (t < minTtl) minTtl = t;
+        if (type == 1 && cls == 1 && rdLen == 4) {
+            memcpy(&addr, msg + pos, 4);
+            ttl = minTtl;
+            return true;
+        }
+        pos += rdLen;
+    }
+    return false;
+}
+
+#ifdef ESP_PLATFORM
+/** The one cache, shared by every translation unit that includes this */
+inline DnsCache& dnsCache() {
+    static RTC_DATA_ATTR RtcBlock<DnsCacheTable> slot;
+    static DnsCache cache(slot);
+    return cache;
+}
+
+/** A query to the first DHCP/static DNS server; address and TTL */
+static inline bool dnsQuery(const char* host, uint32_t& addr, uint32_t& ttl) {
+    uint8_t msg[DNS_MSG_MAX];
+    uint16_t id = (uint16_t)esp_random();
+    int n = dnsBuildQuery(msg, sizeof(msg), id, host);
+    if (n < 0) return false;
+
+    WiFiUDP udp;
+    if (!udp.begin(0)) return false;
+    bool ok = udp.beginPacket(WiFi.dnsIP(0), 53) && udp.write(msg, n) == (size_t)n && udp.endPacket();
+    for (unsigned long t0 = millis(); ok && millis() - t0 < DNS_QUERY_TIMEOUT_MS; delay(2)) {
+        int len = udp.parsePacket();
+        if (len <= 0) continue;
+        len = udp.read(msg, sizeof(msg));
+        if (len > 0 && dnsParseResponse(msg, len, id, addr, ttl)) {
+            udp.stop();
+            return true;
+        }
+    }
+    udp.stop();
+    return false;
+}
+
+/**
+ * Address of `host`: from the cache while fresh (`cached` set), else
+ * looked up and cached. Falls back to the system resolver with the
+ * minimum TTL if the direct query gets no answer.
+ */
+static inline bool dnsCacheResolve(const char* host, IPAddress& ip, bool& cached) {
+    cached = false;
+    if (ip.fromString(host)) return true;
+
+    uint32_t addr = 0, ttl = 0;
+    uint64_t now = rtcClockMs();
+    if (dnsCache().lookup(host, now, addr)) {
+        ip = IPAddress(addr);
+        cached = true;
+        return true;
+    }
+
+    unsigned long t0 = millis();
+    if (dnsQuery(host, addr, ttl)) {
+        ip = IPAddress(addr);
+    } else if (WiFi.hostByName(host, ip)) {
+        addr = (uint32_t)ip;
+        ttl = DNS_CACHE_MIN_TTL_S;
+    } else {
+        return false;
+    }
+    dnsCache().store(host, addr, ttl, now);
+    Serial.printf("[DNS] %s -> %s, TTL %lu s (%lu ms)\n", host, ip.toString().c_str(),
+                  (unsigned long)ttl, millis() - t0);
+    return true;
+}
+#endif // ESP_PLATFORM
+
+#endif // DNS_CACHE_H
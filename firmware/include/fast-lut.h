@@ -0,0 +1,110 @@
+/**
+ * Fast-Update Waveform
+ * Short custom LUT for small, high-churn rectangles (clock, minutes)
+ *
+ * A normal partial refresh runs bb_epaper's multi-phase partial waveform,
+ * most of a second even in a small window. Digits that change every
+ * minute only need one drive phase: push black pixels to black and white
+ * to white, leave unchanged ones floating at VCOM. That is the DU/A2 idea
+ * from other controllers, built here from the UC8179 register LUTs:
+ *
+ *   0x20 VCOM, 0x21 W->W, 0x22 K->W, 0x23 W->K, 0x24 K->K
+ *
+ * Each table is 7 groups of {level select, 4 frame counts, repeat}; only
+ * group 0 is used. At the ~50 Hz frame rate FAST_LUT_FRAMES = 10 is about
+ * 200 ms of drive.
+ *
+ * The fast waveform leaves more residue than the normal one, so callers
+ * count fast updates in GhostTracker and fall back to a normal update
+ * after GHOST_FAST_MAX in a row.
+ *
+ *   refreshPanelWindowFast(bbep, win, waitBusy);
+ *
+ * bb_epaper sends its own LUTs on every refresh(), so the fast tables do
+ * not leak into normal updates. Panel needs writeCmd() and writeData().
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef FAST_LUT_H
+#define FAST_LUT_H
+
+#include <stdint.h>
+#include <string.h>
+#include "panel-window.h"
+
+#ifndef FAST_LUT_FRAMES
+#define FAST_LUT_FRAMES 10
+#endif
+
+#ifndef FAST_LUT_TIMEOUT_MS
+#define FAST_LUT_TIMEOUT_MS 1000 // BUSY wait cap; a fast update takes ~250 ms
+#endif
+
+#define FAST_LUT_LEN 42          // 7 groups x 6 bytes
+#define FAST_LUT_VCOM 0x20
+#define FAST_LUT_WW   0x21
+#define FAST_LUT_KW   0x22
+#define FAST_LUT_WK   0x23
+#define FAST_LUT_KK   0x24
+#define FAST_CMD_REFRESH 0x12    // DRF: display refresh
+
+// Level select, phase 0 in the top two bits: 00 = VCOM, 01 = VDH, 10 = VDL
+#define FAST_LEVEL_HOLD  0x00
+#define FAST_LEVEL_WHITE 0x40    // VDH
+#define FAST_LEVEL_BLACK 0x80    // VDL
+
+/**
+ * Fill `lut` with a one-phase table driving every pixel at `level`
+ */
+static inline void fastLutTable(uint8_t* lut, uint8_t level) {
+    memset(lut, 0, FAST_LUT_LEN);
+    lut[0] = level;
+    lut[1] = FAST_LUT_FRAMES;
+    lut[5] = 1;              // repeat once
+}
+
+/**
+ * Load the fast LUT into the controller's LUT registers
+ */
+template <class Panel>
+void loadFastLut(Panel* panel) {
+    static const struct { uint8_t reg, level; } tables[] = {
+        { FAST_LUT_VCOM, FAST_LEVEL_HOLD },
+        { FAST_LUT_WW,   FAST_LEVEL_HOLD },     // unchanged: no drive
+        { FAST_LUT_KW,   FAST_LEVEL_WHITE },
+        { FAST_LUT_WK,   FAST_LEVEL_BLACK },
+        { FAST_LUT_KK,   FAST_LEVEL_HOLD },
+    };
+    uint8_t lut[FAST_LUT_LEN];
+    for (const auto& t : tables) {
+        fastLutTable(lut, t.level);
+        panel->writeCmd(t.reg);
+        panel->writeData(lut, FAST_LUT_LEN);
+    }
+}
+
+/**
+ * Fast differential refresh of `win`: same plane handling as
+ * refreshPanelWindow(), but driven by the fast LUT. `waitBusy` blocks
+ * until the controller's BUSY line is released.
+ */
+template <class Panel, class WaitBusy>
+int refreshPanelWindowFast(Panel* panel, const PanelWindow& win, WaitBusy waitBusy) {
+    if (!panel || win.empty()) return -1;
+    const uint8_t* fb = (const uint8_t*)panel->getBuffer();
+    if (fb) {
+        pushPanelWindow(panel, fb, win, PANEL_PLANE_NEW);
+    } else {
+        panel->setAddrWindow(win.x, win.y, win.w, win.h);
+    }
+    loadFastLut(panel);
+    panel->writeCmd(FAST_CMD_REFRESH);
+    waitBusy();
+    if (fb) pushPanelWindow(panel, fb, win, PANEL_PLANE_OLD);
+    panel->setAddrWindow(0, 0, panel->width(), panel->height());
+    return 0;
+}
+
+#endif // FAST_LUT_H
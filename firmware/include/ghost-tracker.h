@@ -0,0 +1,190 @@
+/**
+ * Ghost Tracker
+ * Per-zone ghosting budget for scheduling cleaning refreshes
+ *
+ * Partial waveforms leave a faint residue that builds up with every
+ * update and with every pixel that flips. Rather than a fixed "full
+ * refresh every N partials / M minutes" for the whole screen, each zone
+ * accrues a score:
+ *
+ *   GHOST_UPDATE_COST per partial update of the zone, plus
+ *   GHOST_TOGGLE_COST x (toggled pixels / zone pixels)
+ *
+ * A zone whose score reaches GHOST_ZONE_BUDGET gets a localized cleaning
+ * refresh (full waveform in just its window) and starts again. Whole-
+ * screen full refreshes, which blank the panel for ~4 s, are deferred to
+ * idle periods: once the leftover debt is worth it and nobody is looking,
+ * or after GHOST_FULL_MAX_MS regardless.
+ *
+ * Fast-LUT updates (fast-lut.h) cost GHOST_FAST_COST more and are capped
+ * at GHOST_FAST_MAX in a row; fastAllowed() then asks for a normal update.
+ *
+ * Zones are keyed by id, so layouts that rebuild their zone list every
+ * fetch (tiered) keep their history. Scores are in 1/100 update units.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef GHOST_TRACKER_H
+#define GHOST_TRACKER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef GHOST_SLOTS
+#define GHOST_SLOTS 12
+#endif
+
+#define GHOST_ID_MAX 16
+
+#ifndef GHOST_UPDATE_COST
+#define GHOST_UPDATE_COST 100        // one partial update
+#endif
+
+#ifndef GHOST_TOGGLE_COST
+#define GHOST_TOGGLE_COST 200        // extra if every pixel of the zone flipped
+#endif
+
+#ifndef GHOST_FAST_COST
+#define GHOST_FAST_COST 50           // extra residue of a fast-LUT update
+#endif
+
+#ifndef GHOST_FAST_MAX
+#define GHOST_FAST_MAX 5             // fast updates in a row before a normal one
+#endif
+
+#ifndef GHOST_ZONE_BUDGET
+#define GHOST_ZONE_BUDGET 3000       // ~30 light updates, ~10 heavy ones
+#endif
+
+#ifndef GHOST_CLEAN_RESIDUE
+#define GHOST_CLEAN_RESIDUE 300      // a windowed clean leaves some at its edges
+#endif
+
+#ifndef GHOST_WHOLE_BUDGET
+#define GHOST_WHOLE_BUDGET 1500      // total debt that makes an idle full refresh worth it
+#endif
+
+#ifndef GHOST_IDLE_MS
+#define GHOST_IDLE_MS 1800000UL      // 30 min without a button press
+#endif
+
+#ifndef GHOST_FULL_MAX_MS
+#define GHOST_FULL_MAX_MS 14400000UL // 4 h: full refresh even if never idle
+#endif
+
+struct GhostZone {
+    char id[GHOST_ID_MAX];
+    int16_t x, y, w, h;
+    uint32_t score;
+    uint16_t updates;
+    uint8_t fastRun;         // fast updates since the last normal one
+};
+
+class GhostTracker {
+public:
+    GhostTracker() { reset(); }
+
+    /** After a whole-screen full refresh: everything is clean */
+    void reset() {
+        memset(zones, 0, sizeof(zones));
+        residue = 0;
+    }
+
+    /**
+     * A partial update of zone `id` at (x, y, w, h) flipped `toggled`
+     * pixels. Callers that cannot compare old and new pixels (bufferless
+     * panels) pass the changed area as an upper bound. `fast` marks an
+     * update driven by the fast LUT.
+     */
+    void noteUpdate(const char* id, int x, int y, int w, int h, int32_t toggled, bool fast = false) {
+        GhostZone* z = slot(id);
+        if (!z || w <= 0 || h <= 0) return;
+        z->x = x; z->y = y; z->w = w; z->h = h;
+        int32_t area = (int32_t)w * h;
+        if (toggled > area) toggled = area;
+        if (toggled < 0) toggled = 0;
+        z->score += GHOST_UPDATE_COST + (uint32_t)((int64_t)toggled * GHOST_TOGGLE_COST / area);
+        if (fast) {
+            z->score += GHOST_FAST_COST;
+            z->fastRun++;
+        } else {
+            z->fastRun = 0;
+        }
+        z->updates++;
+    }
+
+    /** Whether the next update of `id` may use the fast LUT */
+    bool fastAllowed(const char* id) const {
+        int i = find(id);
+        return i < 0 || zones[i].fastRun < GHOST_FAST_MAX;
+    }
+
+    /** The zone most over budget, or nullptr if none needs cleaning */
+    const GhostZone* zoneToClean() const {
+        const GhostZone* worst = nullptr;
+        for (int i = 0; i < GHOST_SLOTS; i++) {
+            const GhostZone& z = zones[i];
+            if (z.id[0] && z.score >= GHOST_ZONE_BUDGET && (!worst || z.score > worst->score)) worst = &z;
+        }
+        return worst;
+    }
+
+    /** Zone `id` just had a localized cleaning refresh */
+    void noteCleaned(const char* id) {
+        int i = find(id);
+        if (i < 0) return;
+        zones[i].score = 0;
+        zones[i].updates = 0;
+        zones[i].fastRun = 0;
+        residue += GHOST_CLEAN_RESIDUE;
+    }
+
+    uint32_t score(const char* id) const {
+        int i = find(id);
+        return i < 0 ? 0 : zones[i].score;
+    }
+
+    /** Ghosting a whole-screen full refresh would clear */
+    uint32_t debt() const {
+        uint32_t total = residue;
+        for (int i = 0; i < GHOST_SLOTS; i++) total += zones[i].score;
+        return total;
+    }
+
+    /**
+     * Whether to do a whole-screen full refresh now. `idle` is the
+     * caller's view of "nobody is looking" (no recent button press).
+     */
+    bool wholeDue(bool idle, unsigned long sinceFullMs) const {
+        if (sinceFullMs >= GHOST_FULL_MAX_MS) return true;
+        return idle && debt() >= GHOST_WHOLE_BUDGET;
+    }
+
+private:
+    int find(const char* id) const {
+        for (int i = 0; i < GHOST_SLOTS; i++) {
+            if (zones[i].id[0] && strncmp(zones[i].id, id, GHOST_ID_MAX - 1) == 0) return i;
+        }
+        return -1;
+    }
+
+    GhostZone* slot(const char* id) {
+        int i = find(id);
+        if (i >= 0) return &zones[i];
+        for (i = 0; i < GHOST_SLOTS; i++) {
+            if (!zones[i].id[0]) {
+                strncpy(zones[i].id, id, GHOST_ID_MAX - 1);
+                zones[i].id[GHOST_ID_MAX - 1] = '\0';
+                return &zones[i];
+            }
+        }
+        return nullptr;
+    }
+
+    GhostZone zones[GHOST_SLOTS];
+    uint32_t residue;
+};
+
+#endif // GHOST_TRACKER_H
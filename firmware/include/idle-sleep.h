@@ -0,0 +1,258 @@
+/**
+ * Idle Sleep
+ * Light sleep with Wi-Fi modem sleep between refreshes, association kept
+ *
+ * Where deep sleep is off (USB power, SLEEP_ALWAYS_ON, builds without
+ * sleep-cycle.h) the loops waited for the next refresh in delay(), with
+ * the CPU at full clock. idleUntil() waits for the same deadline, but:
+ *
+ *   - Wi-Fi goes to DTIM modem sleep (WIFI_PS_MIN_MODEM): the radio wakes
+ *     for the AP's DTIM beacons only and the association stays up, so the
+ *     next fetch needs no reconnect;
+ *   - power management drops the CPU to the XTAL clock and, if the SDK
+ *     was built with tickless idle, light-sleeps it between beacons
+ *     (automatic light sleep). Builds without it keep frequency scaling;
+ *   - a press of the button on PIN_INTERRUPT ends the wait at once.
+ *
+ * On return Wi-Fi power save is switched off and the CPU clock restored,
+ * so the fetch itself is not slowed by beacon-interval latency. What the
+ * wait adds to the fetch is the wake-up lateness past the deadline, which
+ * is measured and logged with an estimate of the idle current.
+ *
+ * Light sleep stops the USB-Serial-JTAG console, so callers pass
+ * allowLight = false while a USB host is attached.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef IDLE_SLEEP_H
+#define IDLE_SLEEP_H
+
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <esp_wifi.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#endif
+
+#ifndef IDLE_SLICE_MS
+#define IDLE_SLICE_MS 5000           // re-check keepWaiting() at least this often
+#endif
+
+#ifndef IDLE_MIN_MS
+#define IDLE_MIN_MS 200              // shorter waits are plain delays
+#endif
+
+#ifndef IDLE_CPU_MHZ
+#define IDLE_CPU_MHZ 160
+#endif
+
+#ifndef IDLE_XTAL_MHZ
+#define IDLE_XTAL_MHZ 40
+#endif
+
+// Estimated average currents per idle mode, Wi-Fi associated
+#ifndef IDLE_UA_DELAY
+#define IDLE_UA_DELAY 24000          // delay() at full clock
+#endif
+
+#ifndef IDLE_UA_DFS
+#define IDLE_UA_DFS 12000            // modem sleep, CPU at XTAL clock
+#endif
+
+#ifndef IDLE_UA_LIGHT
+#define IDLE_UA_LIGHT 2500           // modem sleep + automatic light sleep (DTIM 1)
+#endif
+
+struct IdleStats {
+    uint32_t periods;
+    uint32_t idleMs;
+    uint32_t lastIdleMs;
+    uint32_t lastLateMs;             // woke this long after the deadline
+    uint32_t maxLateMs;
+    uint32_t buttonWakes;
+};
+
+class IdleSleep {
+public:
+    enum Mode { IDLE_DELAY, IDLE_DFS, IDLE_LIGHT };
+
+    /** Host tests: clock, wait and button (true = pressed) */
+    unsigned long (*clockMs)() = nullptr;
+    void (*waitMs)(uint32_t ms) = nullptr;
+    bool (*buttonDown)() = nullptr;
+
+    /** Watch the active-low button on `wakePin` */
+    void begin(int wakePin) {
+        pin = wakePin;
+#ifdef ESP_PLATFORM
+        clockMs = millis;
+        pinMode(pin, INPUT_PULLUP);
+        attachInterruptArg(pin, onButton, this, FALLING);
+#endif
+    }
+
+    /**
+     * Idle until `deadline` (millis), a button press, or keepWaiting()
+     * returning false. True if the button ended the wait.
+     */
+    bool idleUntil(unsigned long deadline, bool allowLight, bool (*keepWaiting)() = nullptr) {
+        unsigned long t0 = now();
+        idled = false;
+        if ((long)(deadline - t0) < IDLE_MIN_MS || pressed()) {
+            plainWait(deadline, t0);
+            return false;
+        }
+
+        mode = enter(allowLight);
+        button = false;
+        bool byButton = false;
+        for (;;) {
+            unsigned long t = now();
+            long left = (long)(deadline - t);
+            if (left <= 0) break;
+            if (button || pressed()) {
+                byButton = true;
+                break;
+            }
+            if (keepWaiting && !keepWaiting()) break;
+            wait(left < IDLE_SLICE_MS ? (uint32_t)left : IDLE_SLICE_MS);
+        }
+        leave();
+        idled = true;
+
+        unsigned long t1 = now();
+        stat.periods++;
+        stat.lastIdleMs = t1 - t0;
+        stat.idleMs += stat.lastIdleMs;
+        stat.lastLateMs = (long)(t1 - deadline) > 0 ? t1 - deadline : 0;
+        if (stat.lastLateMs > stat.maxLateMs) stat.maxLateMs = stat.lastLateMs;
+        if (byButton) stat.buttonWakes++;
+        return byButton;
+    }
+
+    /** The last idleUntil() slept rather than just delaying */
+    bool lastIdled() const { return idled; }
+    Mode lastMode() const { return mode; }
+    const IdleStats& stats() const { return stat; }
+
+    /** Estimated idle current of `m`, in µA */
+    static uint32_t modeMicroAmps(Mode m) {
+        return m == IDLE_LIGHT ? IDLE_UA_LIGHT : m == IDLE_DFS ? IDLE_UA_DFS : IDLE_UA_DELAY;
+    }
+
+    static const char* modeName(Mode m) {
+        return m == IDLE_LIGHT ? "light sleep" : m == IDLE_DFS ? "modem sleep" : "delay";
+    }
+
+    /** What the ISR does (host tests call it directly) */
+    void press() { button = true; }
+
+private:
+    unsigned long now() const { return clockMs ? clockMs() : 0; }
+
+    bool pressed() const {
+        if (buttonDown) return buttonDown();
+#ifdef ESP_PLATFORM
+        return pin >= 0 && digitalRead(pin) == LOW;
+#else
+        return false;
+#endif
+    }
+
+    void wait(uint32_t ms) {
+        if (waitMs) {
+            waitMs(ms);
+            return;
+        }
+#ifdef ESP_PLATFORM
+        waiter = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+#endif
+    }
+
+    void plainWait(unsigned long deadline, unsigned long t0) {
+        long left = (long)(deadline - t0);
+        if (left > 0) wait(left < IDLE_SLICE_MS ? (uint32_t)left : IDLE_SLICE_MS);
+    }
+
+    // Radio to DTIM modem sleep, CPU clock scaling and, if allowed and
+    // built in, automatic light sleep with the button as a wake source
+    Mode enter(bool allowLight) {
+#ifdef ESP_PLATFORM
+        esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+        esp_pm_config_esp32c3_t pm = {};
+        pm.max_freq_mhz = IDLE_CPU_MHZ;
+        pm.min_freq_mhz = IDLE_XTAL_MHZ;
+        if (allowLight) {
+            pm.light_sleep_enable = true;
+            if (esp_pm_configure(&pm) == ESP_OK) {
+                gpio_wakeup_enable((gpio_num_t)pin, GPIO_INTR_LOW_LEVEL);
+                esp_sleep_enable_gpio_wakeup();
+                return IDLE_LIGHT;
+            }
+        }
+        pm.light_sleep_enable = false;
+        if (esp_pm_configure(&pm) == ESP_OK) return IDLE_DFS;
+#else
+        (void)allowLight;
+#endif
+        return IDLE_DELAY;
+    }
+
+    void leave() {
+#ifdef ESP_PLATFORM
+        if (mode == IDLE_LIGHT) gpio_wakeup_disable((gpio_num_t)pin);
+        if (mode != IDLE_DELAY) {
+            esp_pm_config_esp32c3_t pm = {};
+            pm.max_freq_mhz = IDLE_CPU_MHZ;
+            pm.min_freq_mhz = IDLE_CPU_MHZ;
+            esp_pm_configure(&pm);
+        }
+        esp_wifi_set_ps(WIFI_PS_NONE);
+#endif
+    }
+
+#ifdef ESP_PLATFORM
+    static void IRAM_ATTR onButton(void* arg) {
+        IdleSleep* self = (IdleSleep*)arg;
+        self->button = true;
+        if (self->waiter) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(self->waiter, &woken);
+            if (woken) portYIELD_FROM_ISR();
+        }
+    }
+    TaskHandle_t waiter = nullptr;
+#endif
+
+    int pin = -1;
+    volatile bool button = false;
+    bool idled = false;
+    Mode mode = IDLE_DELAY;
+    IdleStats stat = {};
+};
+
+inline IdleSleep& idleSleep() {
+    static IdleSleep idle;
+    return idle;
+}
+
+#ifdef ESP_PLATFORM
+/** The last idle period: mode, lateness and estimated current against delay() */
+static inline void logIdleSleep() {
+    const IdleSleep& idle = idleSleep();
+    if (!idle.lastIdled()) return;
+    const IdleStats& s = idle.stats();
+    Serial.printf("[Idle] %lu ms %s, woke %lu ms late (max %lu), ~%.1f mA vs ~%.1f mA in delay()\n",
+                  (unsigned long)s.lastIdleMs, IdleSleep::modeName(idle.lastMode()),
+                  (unsigned long)s.lastLateMs, (unsigned long)s.maxLateMs,
+                  IdleSleep::modeMicroAmps(idle.lastMode()) / 1000.0f, IDLE_UA_DELAY / 1000.0f);
+}
+#endif
+
+#endif // IDLE_SLEEP_H
@@ -0,0 +1,448 @@
+/**
+ * Streaming JSON Scanner
+ * SAX-style, allocation-free JSON tokenizer fed in arbitrary pieces
+ *
+ * Replaces "getString() the whole body, then deserializeJson()" for large
+ * responses: nothing is buffered except the current key or short scalar
+ * (JSON_STREAM_SCALAR_MAX). A handler can ask for any string value to be
+ * streamed instead; its characters are then passed through in runs that
+ * point straight into the input buffer, so a 30 KB base64 field never
+ * exists in RAM as a whole.
+ *
+ * JsonPathHandler adds a key-path matcher on top: every value is reported
+ * with a path such as "status", "changed[]" or "zones[].x", so callers
+ * match fields by name regardless of key order or escaping. jsonFindString()
+ * wraps that for the common "one field out of a small buffer" case.
+ *
+ * The scanner is lenient: it tracks nesting and key/value position but
+ * does not reject every malformed document.
+ *
+ * Builds without Arduino (native unit tests): only JsonStreamWriter needs
+ * the Arduino Stream class.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#endif
+
+#ifndef JSON_STREAM_SCALAR_MAX
+#define JSON_STREAM_SCALAR_MAX 64
+#endif
+
+#define JSON_STREAM_MAX_DEPTH 16
+
+#ifndef JSON_PATH_MAX
+#define JSON_PATH_MAX 64
+#endif
+
+class JsonStreamHandler {
+public:
+    virtual ~JsonStreamHandler() {}
+    /** depth is the nesting level of the new container (top level = 1) */
+    virtual void onBeginObject(int /*depth*/) {}
+    virtual void onEndObject(int /*depth*/) {}
+    virtual void onBeginArray(int /*depth*/) {}
+    virtual void onEndArray(int /*depth*/) {}
+    /** Member name; depth is that of the enclosing object */
+    virtual void onKey(const char* /*key*/, int /*depth*/) {}
+    /** String, number, true, false or null. Strings are truncated to fit. */
+    virtual void onScalar(const char* /*value*/, bool /*isString*/, int /*depth*/) {}
+    /** Return true to receive the upcoming string value via onStringData() */
+    virtual bool wantStream(int /*depth*/) { return false; }
+    virtual void onStringData(const char* /*data*/, size_t /*len*/) {}
+    virtual void onStringEnd() {}
+};
+
+class JsonStreamParser {
+public:
+    explicit JsonStreamParser(JsonStreamHandler* handler = nullptr) { reset(handler); }
+
+    void reset(JsonStreamHandler* h) {
+        handler = h;
+        mode = VALUE;
+        depth = 0;
+        objectBits = 0;
+        expectKey = false;
+        streaming = false;
+        sawValue = false;
+        len = 0;
+        failed = false;
+    }
+
+    /**
+     * Feed the next piece of the document. Returns false once the input
+     * is known to be malformed.
+     */
+    bool feed(const char* data, size_t n) {
+        const char* end = data + n;
+        while (data < end && !failed) {
+            if (mode == STRING) {
+                // Plain runs: pass straight through when streaming, else one copy
+                const char* run = data;
+                while (data < end && *data != '"' && *data != '\\') data++;
+                size_t n = data - run;
+                if (streaming) {
+                    if (n) handler->onStringData(run, n);
+                } else {
+                    if (n > sizeof(buf) - 1 - len) n = sizeof(buf) - 1 - len;
+                    memcpy(buf + len, run, n);
+                    len += n;
+                }
+                if (data == end) break;
+            }
+            step(*data++);
+        }
+        return !failed;
+    }
+
+    /**
+     * True once the top-level value has been closed
+     */
+    bool complete() const { return !failed && depth == 0 && mode == VALUE && sawValue; }
+
+    int currentDepth() const { return depth; }
+
+private:
+    enum Mode { VALUE, STRING, ESCAPE, UNICODE, LITERAL };
+
+    JsonStreamHandler* handler;
+    Mode mode;
+    int depth;
+    uint32_t objectBits;   // bit d set = container at depth d is an object
+    bool expectKey;
+    bool isKey;
+    bool streaming;
+    bool sawValue;
+    bool failed;
+    char buf[JSON_STREAM_SCALAR_MAX];
+    size_t len;
+    uint16_t unicode;
+    int unicodeDigits;
+
+    bool inObject() const { return depth > 0 && (objectBits & (1UL << depth)); }
+
+    void append(char c) {
+        if (streaming) {
+            handler->onStringData(&c, 1);
+        } else if (len < sizeof(buf) - 1) {
+            buf[len++] = c;
+        }
+    }
+
+    void appendUtf8(uint16_t cp) {
+        if (cp < 0x80) {
+            append((char)cp);
+        } else if (cp < 0x800) {
+            append((char)(0xC0 | (cp >> 6)));
+            append((char)(0x80 | (cp & 0x3F)));
+        } else {
+            append((char)(0xE0 | (cp >> 12)));
+            append((char)(0x80 | ((cp >> 6) & 0x3F)));
+            append((char)(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    void endString() {
+        mode = VALUE;
+        if (streaming) {
+            streaming = false;
+            handler->onStringEnd();
+            return;
+        }
+        buf[len] = '\0';
+        if (isKey) {
+            if (handler) handler->onKey(buf, depth);
+            expectKey = false;
+        } else if (handler) {
+            handler->onScalar(buf, true, depth);
+        }
+    }
+
+    void endLiteral() {
+        buf[len] = '\0';
+        mode = VALUE;
+        if (handler) handler->onScalar(buf, false, depth);
+    }
+
+    void step(char c) {
+        switch (mode) {
+            case STRING:
+                if (c == '"') endString();
+                else if (c == '\\') mode = ESCAPE;
+                else append(c);
+                return;
+
+            case ESCAPE:
+                mode = STRING;
+                switch (c) {
+                    case 'n': append('\n'); break;
+                    case 't': append('\t'); break;
+                    case 'r': append('\r'); break;
+                    case 'b': append('\b'); break;
+                    case 'f': append('\f'); break;
+                    case 'u': mode = UNICODE; unicode = 0; unicodeDigits = 0; break;
+                    default:  append(c); break;   // \" \\ \/
+                }
+                return;
+
+            case UNICODE: {
+                int v = (c >= '0' && c <= '9') ? c - '0' :
+                        (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                        (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                if (v < 0) { failed = true; return; }
+                unicode = (unicode << 4) | v;
+                if (++unicodeDigits == 4) {
+                    appendUtf8(unicode);
+                    mode = STRING;
+                }
+                return;
+            }
+
+            case LITERAL:
+                if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+                    c == '-' || c == '+' || c == '.' || c == 'E') {
+                    if (len < sizeof(buf) - 1) buf[len++] = c;
+                    return;
+                }
+                endLiteral();
+                break;   // c is a structural character; handle it below
+
+            case VALUE:
+                break;
+        }
+
+        switch (c) {
+            case ' ': case '\t': case '\r': case '\n':
+                return;
+            case '{':
+            case '[':
+                if (depth + 1 >= JSON_STREAM_MAX_DEPTH) { failed = true; return; }
+                depth++;
+                if (c == '{') objectBits |= (1UL << depth);
+                else objectBits &= ~(1UL << depth);
+                expectKey = (c == '{');
+                sawValue = true;
+                if (handler) {
+                    if (c == '{') handler->onBeginObject(depth);
+                    else handler->onBeginArray(depth);
+                }
+                return;
+            case '}':
+            case ']':
+                if (depth == 0) { failed = true; return; }
+                if (handler) {
+                    if (c == '}') handler->onEndObject(depth);
+                    else handler->onEndArray(depth);
+                }
+                depth--;
+                expectKey = false;
+                return;
+            case ',':
+                expectKey = inObject();
+                return;
+            case ':':
+                expectKey = false;
+                return;
+            case '"':
+                mode = STRING;
+                len = 0;
+                isKey = expectKey && inObject();
+                streaming = !isKey && handler && handler->wantStream(depth);
+                sawValue = true;
+                return;
+            default:
+                mode = LITERAL;
+                len = 0;
+                buf[len++] = c;
+                sawValue = true;
+                return;
+        }
+    }
+};
+
+/**
+ * Tracks the key path of every value. Subclasses override the path
+ * callbacks instead of the raw JsonStreamHandler ones.
+ *
+ * Paths join member names with '.' and mark array elements with "[]":
+ *   {"zones":[{"x":1}]}  ->  "zones" (array), "zones[]" (object),
+ *                            "zones[].x" = "1"
+ * Paths longer than JSON_PATH_MAX are truncated and will not match.
+ */
+class JsonPathHandler : public JsonStreamHandler {
+public:
+    JsonPathHandler() : arrayBits(0) {
+        path[0] = '\0';
+        prefixLen[0] = prefixLen[1] = 0;
+    }
+
+    /** Scalar at path */
+    virtual void onValue(const char* /*path*/, const char* /*value*/, bool /*isString*/) {}
+    /** Object or array starts / ends at path */
+    virtual void onEnter(const char* /*path*/, bool /*isArray*/) {}
+    virtual void onLeave(const char* /*path*/, bool /*isArray*/) {}
+    /** Return true to receive the string at path via onStringData() */
+    virtual bool wantStreamPath(const char* /*path*/) { return false; }
+
+    // JsonStreamHandler
+    void onBeginObject(int depth) override { enter(depth, false); }
+    void onBeginArray(int depth) override { enter(depth, true); }
+    void onEndObject(int depth) override { leave(depth, false); }
+    void onEndArray(int depth) override { leave(depth, true); }
+
+    void onKey(const char* key, int depth) override {
+        truncate(prefixLen[depth]);
+        if (prefixLen[depth] > 0) append(".");
+        append(key);
+    }
+
+    void onScalar(const char* value, bool isString, int depth) override {
+        elementPath(depth);
+        onValue(path, value, isString);
+    }
+
+    bool wantStream(int depth) override {
+        elementPath(depth);
+        return wantStreamPath(path);
+    }
+
+protected:
+    char path[JSON_PATH_MAX];
+
+private:
+    uint16_t prefixLen[JSON_STREAM_MAX_DEPTH + 1];   // path of the container at each depth
+    uint32_t arrayBits;                              // bit d set = container at depth d is an array
+    size_t len = 0;
+
+    void truncate(size_t n) {
+        len = n;
+        path[len] = '\0';
+    }
+
+    void append(const char* s) {
+        while (*s && len < sizeof(path) - 1) path[len++] = *s++;
+        path[len] = '\0';
+    }
+
+    /** Array elements have no key; their path is the array's plus "[]" */
+    void elementPath(int depth) {
+        if (depth > 0 && (arrayBits & (1UL << depth))) {
+            truncate(prefixLen[depth]);
+            append("[]");
+        }
+    }
+
+    void enter(int depth, bool isArray) {
+        if (depth == 1) truncate(0);
+        else elementPath(depth - 1);
+        prefixLen[depth] = len;
+        if (isArray) arrayBits |= (1UL << depth);
+        else arrayBits &= ~(1UL << depth);
+        onEnter(path, isArray);
+    }
+
+    void leave(int depth, bool isArray) {
+        truncate(prefixLen[depth]);
+        onLeave(path, isArray);
+    }
+};
+
+/**
+ * Copies the string (or scalar text) at one path out of a complete or
+ * partial document. Strings are streamed, so out may be longer than
+ * JSON_STREAM_SCALAR_MAX.
+ */
+class JsonStringFinder : public JsonPathHandler {
+public:
+    JsonStringFinder(const char* target, char* out, size_t outLen)
+        : target(target), out(out), outLen(outLen), used(0), found(false), collecting(false) {
+        if (outLen) out[0] = '\0';
+    }
+
+    bool wantStreamPath(const char* p) override {
+        if (found || strcmp(p, target) != 0) return false;
+        collecting = true;
+        used = 0;
+        return true;
+    }
+
+    void onStringData(const char* data, size_t len) override {
+        if (!collecting) return;
+        while (len-- > 0 && used + 1 < outLen) out[used++] = *data++;
+        if (outLen) out[used] = '\0';
+    }
+
+    void onStringEnd() override {
+        if (collecting) found = true;
+        collecting = false;
+    }
+
+    void onValue(const char* p, const char* value, bool /*isString*/) override {
+        if (found || strcmp(p, target) != 0 || !outLen) return;
+        strncpy(out, value, outLen - 1);
+        out[outLen - 1] = '\0';
+        found = true;
+    }
+
+    bool wasFound() const { return found; }
+
+private:
+    const char* target;
+    char* out;
+    size_t outLen;
+    size_t used;
+    bool found;
+    bool collecting;
+};
+
+/**
+ * Find the value at path (e.g. "status", "device.url") in a JSON buffer.
+ * Returns true and fills out (always terminated) if present.
+ */
+inline bool jsonFindString(const char* json, size_t len, const char* path, char* out, size_t outLen) {
+    JsonStringFinder finder(path, out, outLen);
+    JsonStreamParser parser(&finder);
+    parser.feed(json, len);
+    return finder.wasFound();
+}
+
+#ifdef ESP_PLATFORM
+/**
+ * Stream adapter so HTTPClient::writeToStream() can feed the parser
+ * directly (it also strips chunked transfer encoding)
+ */
+class JsonStreamWriter : public Stream {
+public:
+    explicit JsonStreamWriter(JsonStreamParser& parser) : parser(parser), failed(false) {}
+
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (!failed && !parser.feed((const char*)buf, len)) failed = true;
+        return len;
+    }
+    size_t write(uint8_t b) override { return write(&b, 1); }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+
+    /** True if a complete, well-formed document was received */
+    bool ok() const { return !failed && parser.complete(); }
+
+private:
+    JsonStreamParser& parser;
+    bool failed;
+};
+#endif // ESP_PLATFORM
+
+#endif // JSON_STREAM_H
@@ -0,0 +1,87 @@
+/**
+ * Next Change Hints
+ * Server-given time until zones next change, clamped into a refresh delay
+ *
+ * Zone, bundle and sync responses carry (src/services/zone-hints.js):
+ *
+ *   X-Next-Change: 42                        seconds, earliest of the zones
+ *   X-Zone-Next-Change: header=42,footer=3600
+ *
+ * The device sleeps until the earliest hint instead of a fixed cadence:
+ * one minute while departures count down, tens of minutes overnight.
+ * Hints are relative, so no wall clock is needed. The delay is clamped to
+ * NEXT_CHANGE_MIN_MS (a hint a few seconds out would otherwise cost a
+ * wake per second of clock skew) and NEXT_CHANGE_MAX_MS (so a wrong hint
+ * cannot park the dashboard for long); without a hint the build's own
+ * cadence applies.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef NEXT_CHANGE_H
+#define NEXT_CHANGE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NEXT_CHANGE_MIN_MS
+#define NEXT_CHANGE_MIN_MS 15000
+#endif
+
+#ifndef NEXT_CHANGE_MAX_MS
+#define NEXT_CHANGE_MAX_MS 1800000   // 30 min
+#endif
+
+#define ZONE_HINTS_MAX 256
+
+/** Refresh delay for a hint of `hintS` seconds; `fallbackMs` if there is none (< 0) */
+static inline uint32_t nextChangeDelayMs(int32_t hintS, uint32_t fallbackMs) {
+    if (hintS < 0) return fallbackMs;
+    uint64_t ms = (uint64_t)hintS * 1000;
+    if (ms < NEXT_CHANGE_MIN_MS) return NEXT_CHANGE_MIN_MS;
+    if (ms > NEXT_CHANGE_MAX_MS) return NEXT_CHANGE_MAX_MS;
+    return (uint32_t)ms;
+}
+
+/** Earlier of two hints, either of which may be absent (< 0) */
+static inline int32_t nextChangeEarliest(int32_t a, int32_t b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    return a < b ? a : b;
+}
+
+/** Seconds for `id` in an X-Zone-Next-Change list, -1 if not listed */
+static inline int32_t zoneHintSeconds(const char* hints, const char* id) {
+    size_t idLen = strlen(id);
+    const char* p = hints;
+    while (p && *p) {
+        const char* eq = strchr(p, '=');
+        if (!eq) break;
+        if ((size_t)(eq - p) == idLen && strncmp(p, id, idLen) == 0) return atol(eq + 1);
+        p = strchr(eq, ',');
+        if (p) p++;
+    }
+    return -1;
+}
+
+/**
+ * Keep an X-Zone-Next-Change value. If it was cut short (`truncated`, or
+ * longer than `cap`) the last entry may be cut too and is dropped, since
+ * "leg1.time=45" cut to "leg1=4" would name another zone.
+ */
+static inline void copyZoneHints(char* out, size_t cap, const char* value, bool truncated) {
+    size_t len = strlen(value);
+    if (len >= cap) {
+        len = cap - 1;
+        truncated = true;
+    }
+    memcpy(out, value, len);
+    out[len] = '\0';
+    if (!truncated) return;
+    char* comma = strrchr(out, ',');
+    *(comma ? comma : out) = '\0';
+}
+
+#endif // NEXT_CHANGE_H
@@ -0,0 +1,209 @@
+/**
+ * Panel BUSY Wait
+ * Interrupt-driven refresh completion instead of spinning on the BUSY pin
+ *
+ * refresh(mode, true) polls BUSY at full clock for the whole waveform:
+ * ~3.5 s for a full refresh, 0.5-1 s for a partial. Here the refresh is
+ * started with refresh(mode, false) and an edge interrupt on BUSY (low
+ * while the controller drives the panel) marks the end:
+ *
+ *   startPanelRefresh(bbep, REFRESH_FULL);   // returns at once
+ *   ... fetch, persist, anything not touching the panel ...
+ *   finishPanelRefresh();                    // sleeps until the BUSY edge
+ *
+ *   panelRefresh(bbep, REFRESH_PARTIAL);     // start + finish
+ *
+ * While finishing, the task blocks on a notification from the ISR, so the
+ * CPU idles and Wi-Fi keeps running. If canSleep() says so (e.g. Wi-Fi is
+ * off) it light-sleeps instead, woken by the BUSY level.
+ *
+ * Busy time is kept per kind: the bb_epaper refresh mode, or
+ * PANEL_BUSY_FAST_LUT for fast-lut.h updates. Without begin() everything
+ * falls back to refresh(mode, true).
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef PANEL_BUSY_H
+#define PANEL_BUSY_H
+
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#endif
+
+#ifndef PANEL_BUSY_TIMEOUT_MS
+#define PANEL_BUSY_TIMEOUT_MS 8000   // well past a full refresh
+#endif
+
+#define PANEL_BUSY_ASSERT_MS 20      // BUSY goes low within this after the refresh command
+#define PANEL_BUSY_KINDS 4
+#define PANEL_BUSY_FAST_LUT 3        // bb_epaper refresh modes are 0..2
+
+struct PanelBusyStats {
+    uint32_t count;
+    uint32_t lastMs;
+    uint32_t maxMs;
+    uint32_t totalMs;
+
+    uint32_t avgMs() const { return count ? totalMs / count : 0; }
+};
+
+class PanelBusy {
+public:
+    /** Wake-up policy while finishing: light sleep when this returns true */
+    bool (*canSleep)() = nullptr;
+    /** Host tests: clock and BUSY line (true = busy) */
+    unsigned long (*clockMs)() = nullptr;
+    bool (*lineBusy)() = nullptr;
+
+    /** Attach the edge interrupt. Until then refreshes block as before. */
+    void begin(int busyPin) {
+        pin = busyPin;
+#ifdef ESP_PLATFORM
+        clockMs = millis;
+        pinMode(pin, INPUT);
+        attachInterruptArg(pin, onRelease, this, RISING);
+#endif
+    }
+
+    bool attached() const { return pin >= 0 || lineBusy; }
+
+    /** The controller was just told to refresh */
+    void start(int k) {
+        released = false;
+        kind = k < 0 || k >= PANEL_BUSY_KINDS ? 0 : k;
+        t0 = now();
+        running = true;
+#ifdef ESP_PLATFORM
+        waiter = xTaskGetCurrentTaskHandle();
+#endif
+        // A poll right after the command could see BUSY still high
+        while (!busyNow() && now() - t0 < PANEL_BUSY_ASSERT_MS) {}
+        if (!busyNow()) released = true;
+    }
+
+    bool pending() const { return running; }
+
+    /** Non-blocking: true once the refresh is over (stats recorded once) */
+    bool poll() {
+        if (!running) return true;
+        if (!released && busyNow()) return false;
+        uint32_t ms = now() - t0;
+        PanelBusyStats& s = byKind[kind];
+        s.count++;
+        s.lastMs = ms;
+        s.totalMs += ms;
+        if (ms > s.maxMs) s.maxMs = ms;
+        running = false;
+        return true;
+    }
+
+    /** Block until BUSY is released. False on timeout. */
+    bool finish(uint32_t timeoutMs = PANEL_BUSY_TIMEOUT_MS) {
+        while (!poll()) {
+            uint32_t waited = now() - t0;
+            if (waited >= timeoutMs) {
+                running = false;
+                timeouts++;
+                return false;
+            }
+            sleepUntilRelease(timeoutMs - waited);
+        }
+        return true;
+    }
+
+    const PanelBusyStats& stats(int k) const { return byKind[k]; }
+    uint32_t timeoutCount() const { return timeouts; }
+
+    /** What the BUSY edge does (host tests call it directly) */
+    void release() { released = true; }
+
+private:
+    unsigned long now() const { return clockMs ? clockMs() : 0; }
+
+    bool busyNow() const {
+        if (lineBusy) return lineBusy();
+#ifdef ESP_PLATFORM
+        return pin >= 0 && digitalRead(pin) == LOW;
+#else
+        return false;
+#endif
+    }
+
+    void sleepUntilRelease(uint32_t ms) {
+#ifdef ESP_PLATFORM
+        if (canSleep && canSleep()) {
+            gpio_wakeup_enable((gpio_num_t)pin, GPIO_INTR_HIGH_LEVEL);
+            esp_sleep_enable_gpio_wakeup();
+            esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+            esp_light_sleep_start();
+            esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+            gpio_wakeup_disable((gpio_num_t)pin);
+            return;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+#else
+        (void)ms;
+#endif
+    }
+
+#ifdef ESP_PLATFORM
+    static void IRAM_ATTR onRelease(void* arg) {
+        PanelBusy* self = (PanelBusy*)arg;
+        self->released = true;
+        if (self->waiter) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(self->waiter, &woken);
+            if (woken) portYIELD_FROM_ISR();
+        }
+    }
+    TaskHandle_t waiter = nullptr;
+#endif
+
+    int pin = -1;
+    volatile bool released = false;
+    bool running = false;
+    int kind = 0;
+    unsigned long t0 = 0;
+    uint32_t timeouts = 0;
+    PanelBusyStats byKind[PANEL_BUSY_KINDS] = {};
+};
+
+inline PanelBusy& panelBusy() {
+    static PanelBusy busy;
+    return busy;
+}
+
+/**
+ * Start a refresh and return while the panel is still busy. Waits for a
+ * refresh still running first. Returns refresh()'s result.
+ */
+template <class Panel>
+int startPanelRefresh(Panel* panel, int mode, int kind = -1) {
+    PanelBusy& busy = panelBusy();
+    if (!busy.attached()) return panel->refresh(mode, true);
+    busy.finish();
+    int rc = panel->refresh(mode, false);
+    busy.start(kind < 0 ? mode : kind);
+    return rc;
+}
+
+/** Wait for the refresh started last, if any. False on timeout. */
+static inline bool finishPanelRefresh() {
+    return panelBusy().finish();
+}
+
+/** Blocking refresh, sleeping on the BUSY edge rather than spinning */
+template <class Panel>
+int panelRefresh(Panel* panel, int mode) {
+    int rc = startPanelRefresh(panel, mode);
+    finishPanelRefresh();
+    return rc;
+}
+
+#endif // PANEL_BUSY_H
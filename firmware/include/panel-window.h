@@ -0,0 +1,203 @@
+/**
+ * Windowed Partial Refresh
+ * Pushes and waveforms only the changed rectangle of the panel
+ *
+ * A plain refresh(REFRESH_PARTIAL) updates the whole 800x480 plane even
+ * when one 800x28 zone changed. The UC8179 controller can limit both the
+ * RAM writes and the update to a window (PTIN/PTL), which bb_epaper
+ * programs in setAddrWindow(). The controller addresses x in whole bytes,
+ * so windows are widened to multiples of PANEL_X_ALIGN pixels.
+ *
+ *   PanelWindow win = alignPanelWindow(x, y, w, h, SCREEN_W, SCREEN_H);
+ *   refreshPanelWindow(&bbep, win, REFRESH_PARTIAL);
+ *
+ * With a framebuffer (allocBuffer) only the window rows are sent over SPI;
+ * bufferless builds have already streamed the zone into panel RAM. Either
+ * way the full-screen window is restored afterwards so later full
+ * refreshes and writes cover the whole panel.
+ *
+ * Differential update: the UC8179 waveforms each pixel from its value in
+ * the "old" plane (DTM1) to the "new" plane (DTM2), so one partial refresh
+ * gives a clean transition without a flash to black first. With a
+ * framebuffer the bookkeeping is automatic: the window goes to the new
+ * plane, is refreshed, then is copied to the old plane so the old plane
+ * always matches what the panel shows. Callers just draw the new bitmap
+ * into the framebuffer. After a whole-screen refresh(REFRESH_FULL) call
+ * syncPanelOldPlane() once.
+ *
+ * Plane data goes through the installed PanelDataWriter when there is one
+ * (spi-dma.h: double-buffered SPI DMA), else panel->writeData(). A writer
+ * may still be clocking bytes out when it returns, so it is flushed before
+ * the next command.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef PANEL_WINDOW_H
+#define PANEL_WINDOW_H
+
+#include <stdint.h>
+#include "panel-busy.h"
+
+#define PANEL_X_ALIGN 8
+
+// bb_epaper plane numbers (PLANE_0 / PLANE_1) as UC8179 data RAM
+#define PANEL_PLANE_OLD 0   // DTM1: what the panel currently shows
+#define PANEL_PLANE_NEW 1   // DTM2: what the next refresh drives it to
+
+#ifndef PANEL_WINDOW_MAX_PCT
+#define PANEL_WINDOW_MAX_PCT 60   // above this, a whole-plane partial costs about the same
+#endif
+
+struct PanelWindow {
+    int16_t x, y, w, h;
+
+    bool empty() const { return w <= 0 || h <= 0; }
+    int32_t area() const { return empty() ? 0 : (int32_t)w * h; }
+};
+
+/**
+ * Bulk path for plane data, used after startWrite() has sent the RAM
+ * command. Keeps byte and CPU-time counts for the refresh log.
+ */
+class PanelDataWriter {
+public:
+    virtual ~PanelDataWriter() {}
+    /** Queue bytes; may return before they are on the wire */
+    virtual void write(const uint8_t* data, int len) = 0;
+    /** Start sending anything buffered, without waiting */
+    virtual void send() {}
+    /** Wait until everything written is on the wire */
+    virtual void flush() = 0;
+
+    uint32_t bytes = 0;      // since the last resetStats()
+    uint32_t cpuUs = 0;      // time callers spent blocked in write/send/flush
+    void resetStats() { bytes = 0; cpuUs = 0; }
+};
+
+/** The installed writer, or nullptr for plain panel->writeData() */
+inline PanelDataWriter*& panelDataWriter() {
+    static PanelDataWriter* writer = nullptr;
+    return writer;
+}
+
+template <class Panel>
+void panelWriteData(Panel* panel, const uint8_t* data, int len) {
+    PanelDataWriter* w = panelDataWriter();
+    if (w) w->write(data, len);
+    else panel->writeData((uint8_t*)data, len);
+}
+
+/** Call before any panel command that follows plane data */
+static inline void panelFlushData() {
+    if (panelDataWriter()) panelDataWriter()->flush();
+}
+
+/**
+ * Clip a rectangle to the panel and widen it to byte-aligned x edges.
+ * Returns an empty window if nothing is left.
+ */
+static inline PanelWindow alignPanelWindow(int x, int y, int w, int h, int panelW, int panelH) {
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + w > panelW ? panelW : x + w;
+    int y1 = y + h > panelH ? panelH : y + h;
+    if (x0 >= x1 || y0 >= y1) return PanelWindow{ 0, 0, 0, 0 };
+
+    x0 &= ~(PANEL_X_ALIGN - 1);
+    x1 = (x1 + PANEL_X_ALIGN - 1) & ~(PANEL_X_ALIGN - 1);
+    if (x1 > panelW) x1 = panelW;
+    return PanelWindow{ (int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+}
+
+/**
+ * True if refreshing just this window beats a whole-plane partial update
+ */
+static inline bool panelWindowWorthIt(const PanelWindow& win, int panelW, int panelH) {
+    if (win.empty()) return false;
+    return win.area() * 100 <= (int32_t)panelW * panelH * PANEL_WINDOW_MAX_PCT;
+}
+
+/**
+ * Copy the window rows from a 1-bpp framebuffer into panel RAM.
+ * Rows are sent one at a time into a single address window, and are on
+ * the wire when this returns.
+ */
+template <class Panel>
+bool pushPanelWindow(Panel* panel, const uint8_t* fb, const PanelWindow& win,
+                     int plane = PANEL_PLANE_NEW) {
+    if (!panel || !fb || win.empty()) return false;
+    const int pitch = (panel->width() + 7) >> 3;
+    const int rowBytes = win.w >> 3;
+
+    panel->setAddrWindow(win.x, win.y, win.w, win.h);
+    panel->startWrite(plane);
+    const uint8_t* row = fb + win.y * pitch + (win.x >> 3);
+    for (int r = 0; r < win.h; r++, row += pitch) {
+        panelWriteData(panel, row, rowBytes);
+    }
+    panelFlushData();
+    return true;
+}
+
+/**
+ * Partial-refresh only `win`. With a framebuffer this is a differential
+ * update: the window is pushed to the new plane, refreshed, then copied to
+ * the old plane. `mode` is REFRESH_PARTIAL or REFRESH_FULL (bb_epaper
+ * constants are not visible here). Waits for BUSY (on the edge interrupt
+ * if panel-busy.h is set up) so the full window can be restored. Returns
+ * refresh()'s result, or -1 for an empty window.
+ */
+template <class Panel>
+int refreshPanelWindow(Panel* panel, const PanelWindow& win, int mode) {
+    if (!panel || win.empty()) return -1;
+    const uint8_t* fb = (const uint8_t*)panel->getBuffer();
+    if (fb) {
+        pushPanelWindow(panel, fb, win, PANEL_PLANE_NEW);
+    } else {
+        panel->setAddrWindow(win.x, win.y, win.w, win.h);
+    }
+    int rc = panelRefresh(panel, mode);
+    if (fb) pushPanelWindow(panel, fb, win, PANEL_PLANE_OLD);
+    panel->setAddrWindow(0, 0, panel->width(), panel->height());
+    return rc;
+}
+
+/**
+ * Start a windowed refresh and return while the panel is busy, so the
+ * caller can fetch the next zone meanwhile (panel-busy.h). Bufferless
+ * only: with a framebuffer the old plane is written after the waveform,
+ * so this is refreshPanelWindow(). Call endPanelWindowRefresh() after the
+ * last one.
+ */
+template <class Panel>
+int startPanelWindowRefresh(Panel* panel, const PanelWindow& win, int mode) {
+    if (!panel || win.empty()) return -1;
+    if (panel->getBuffer()) return refreshPanelWindow(panel, win, mode);
+    finishPanelRefresh();
+    panel->setAddrWindow(win.x, win.y, win.w, win.h);
+    return startPanelRefresh(panel, mode);
+}
+
+/** Wait for the last started window and restore the full-screen window */
+template <class Panel>
+void endPanelWindowRefresh(Panel* panel) {
+    finishPanelRefresh();
+    panel->setAddrWindow(0, 0, panel->width(), panel->height());
+}
+
+/**
+ * Copy the whole framebuffer to the old plane, after a full refresh that
+ * did not go through refreshPanelWindow(). No-op for bufferless panels.
+ */
+template <class Panel>
+void syncPanelOldPlane(Panel* panel) {
+    const uint8_t* fb = panel ? (const uint8_t*)panel->getBuffer() : nullptr;
+    if (!fb) return;
+    pushPanelWindow(panel, fb, PanelWindow{ 0, 0, (int16_t)panel->width(), (int16_t)panel->height() },
+                    PANEL_PLANE_OLD);
+    panel->setAddrWindow(0, 0, panel->width(), panel->height());
+}
+
+#endif // PANEL_WINDOW_H
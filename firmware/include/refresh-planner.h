@@ -0,0 +1,191 @@
+/**
+ * Refresh Planner
+ * Batches one update cycle's dirty rectangles into as few refreshes as pay off
+ *
+ * Each panel refresh has a fixed cost (command sequence, LUT load, BUSY
+ * settle) on top of a part that grows with the window area (SPI rows and
+ * gate scanning). Issuing one partial per zone pays the fixed cost 4-5
+ * times a minute. The planner collects the cycle's rectangles, then
+ * greedily merges any pair whose union is cheaper than refreshing both:
+ *
+ *   cost(r) = REFRESH_COST_FIXED_MS + area(r) * REFRESH_COST_NS_PER_PX / 1e6
+ *
+ * so overlapping or nearby zones become one window and distant ones stay
+ * separate. If the windows cover at least REFRESH_PLAN_WHOLE_PCT of the
+ * screen, or cost more than one whole-panel refresh, the plan is a single
+ * whole-panel refresh instead.
+ *
+ *   RefreshPlanner plan(SCREEN_W, SCREEN_H, millis);
+ *   plan.add(x, y, w, h);            // per changed zone
+ *   plan.execute(&bbep, REFRESH_PARTIAL, REFRESH_PARTIAL);
+ *   Serial.printf("busy %lu ms\n", plan.busyMs());
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef REFRESH_PLANNER_H
+#define REFRESH_PLANNER_H
+
+#include <stdint.h>
+#include "panel-window.h"
+
+#ifndef REFRESH_PLAN_MAX
+#define REFRESH_PLAN_MAX 16          // rectangles per cycle; more are folded in
+#endif
+
+#ifndef REFRESH_COST_FIXED_MS
+#define REFRESH_COST_FIXED_MS 180    // per refresh, whatever the size
+#endif
+
+#ifndef REFRESH_COST_NS_PER_PX
+#define REFRESH_COST_NS_PER_PX 1200  // ~460 ms more for the whole 800x480 plane
+#endif
+
+#ifndef REFRESH_PLAN_WHOLE_PCT
+#define REFRESH_PLAN_WHOLE_PCT PANEL_WINDOW_MAX_PCT
+#endif
+
+class RefreshPlanner {
+public:
+    enum Kind { PLAN_NONE = 0, PLAN_WINDOWS = 1, PLAN_WHOLE = 2 };
+
+    RefreshPlanner(int panelW, int panelH, unsigned long (*clockMs)() = nullptr)
+        : panelW(panelW), panelH(panelH), clockMs(clockMs) { reset(); }
+
+    void reset() {
+        count = 0;
+        planned = false;
+        kind = PLAN_NONE;
+        lastBusyMs = 0;
+    }
+
+    /** Mark a rectangle dirty. It is clipped and byte-aligned like any window. */
+    void add(int x, int y, int w, int h) {
+        PanelWindow win = alignPanelWindow(x, y, w, h, panelW, panelH);
+        if (win.empty()) return;
+        planned = false;
+        if (count == REFRESH_PLAN_MAX) {
+            // Out of slots: grow the last one rather than lose the area
+            rects[count - 1] = unite(rects[count - 1], win);
+            return;
+        }
+        rects[count++] = win;
+    }
+
+    bool empty() const { return count == 0; }
+
+    /** Estimated panel-busy time of one refresh of `win` */
+    static uint32_t costMs(const PanelWindow& win) {
+        return REFRESH_COST_FIXED_MS + (uint32_t)((uint64_t)win.area() * REFRESH_COST_NS_PER_PX / 1000000);
+    }
+
+    static PanelWindow unite(const PanelWindow& a, const PanelWindow& b) {
+        int x0 = a.x < b.x ? a.x : b.x;
+        int y0 = a.y < b.y ? a.y : b.y;
+        int x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+        int y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+        return PanelWindow{ (int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+    }
+
+    /**
+     * Merge rectangles and decide between windows and one whole-panel
+     * refresh. Called by execute(); safe to call again.
+     */
+    Kind plan() {
+        if (planned) return kind;
+        planned = true;
+        if (count == 0) return kind = PLAN_NONE;
+
+        // Greedy: merge the pair with the biggest saving until none saves
+        for (;;) {
+            int bi = -1, bj = -1;
+            int32_t best = -1;
+            for (int i = 0; i < count; i++) {
+                for (int j = i + 1; j < count; j++) {
+                    int32_t saving = (int32_t)(costMs(rects[i]) + costMs(rects[j])) -
+                                     (int32_t)costMs(unite(rects[i], rects[j]));
+                    if (saving > best) { best = saving; bi = i; bj = j; }
+                }
+            }
+            if (bi < 0 || best < 0) break;
+            rects[bi] = unite(rects[bi], rects[bj]);
+            rects[bj] = rects[--count];
+        }
+
+        int32_t area = 0;
+        uint32_t cost = 0;
+        for (int i = 0; i < count; i++) {
+            area += rects[i].area();
+            cost += costMs(rects[i]);
+        }
+        const int32_t screen = (int32_t)panelW * panelH;
+        bool whole = area * 100 >= screen * REFRESH_PLAN_WHOLE_PCT ||
+                     cost >= costMs(PanelWindow{ 0, 0, (int16_t)panelW, (int16_t)panelH });
+        return kind = whole ? PLAN_WHOLE : PLAN_WINDOWS;
+    }
+
+    /** Windows to refresh (valid after plan() returned PLAN_WINDOWS) */
+    int windowCount() const { return count; }
+    const PanelWindow& window(int i) const { return rects[i]; }
+
+    /** Cost-model estimate for the current plan */
+    uint32_t estimatedMs() {
+        switch (plan()) {
+            case PLAN_WINDOWS: {
+                uint32_t ms = 0;
+                for (int i = 0; i < count; i++) ms += costMs(rects[i]);
+                return ms;
+            }
+            case PLAN_WHOLE: return costMs(PanelWindow{ 0, 0, (int16_t)panelW, (int16_t)panelH });
+            default: return 0;
+        }
+    }
+
+    /**
+     * Run the plan as one batch: each window via refreshPanelWindow(), or
+     * one wholeMode refresh of the whole panel. Clears the rectangles.
+     * Returns the number of refreshes issued.
+     */
+    template <class Panel>
+    int execute(Panel* panel, int partialMode, int wholeMode) {
+        Kind k = plan();
+        unsigned long t0 = clockMs ? clockMs() : 0;
+        int issued = 0;
+        if (k == PLAN_WHOLE) {
+            // Through the window path too, so framebuffer planes stay in step
+            PanelWindow all = { 0, 0, (int16_t)panelW, (int16_t)panelH };
+            if (refreshPanelWindow(panel, all, wholeMode) >= 0) issued = 1;
+        } else if (k == PLAN_WINDOWS) {
+            for (int i = 0; i < count; i++) {
+                if (refreshPanelWindow(panel, rects[i], partialMode) >= 0) issued++;
+            }
+        }
+        uint32_t estimate = estimatedMs();
+        lastBusyMs = clockMs ? (uint32_t)(clockMs() - t0) : estimate;
+        lastKind = k;
+        lastIssued = issued;
+        count = 0;
+        planned = false;
+        kind = PLAN_NONE;
+        return issued;
+    }
+
+    /** Panel-busy milliseconds of the last execute() (measured if a clock was given) */
+    uint32_t busyMs() const { return lastBusyMs; }
+    Kind lastPlan() const { return lastKind; }
+    int lastRefreshes() const { return lastIssued; }
+
+private:
+    int panelW, panelH;
+    unsigned long (*clockMs)();
+    PanelWindow rects[REFRESH_PLAN_MAX];
+    int count = 0;
+    bool planned = false;
+    Kind kind = PLAN_NONE;
+    Kind lastKind = PLAN_NONE;
+    int lastIssued = 0;
+    uint32_t lastBusyMs = 0;
+};
+
+#endif // REFRESH_PLANNER_H
@@ -0,0 +1,191 @@
+/**
+ * Sleep Cycle
+ * Deep sleep between dashboard refreshes, with state kept in RTC memory
+ *
+ * Between refreshes the device used to wait in delay(1000) with Wi-Fi
+ * associated: ~25 mA for the ~57 s of every minute that nothing happens.
+ * Instead, once a refresh is on the panel, loop() saves what the next
+ * cycle needs in RTC slow memory and deep-sleeps until the next refresh
+ * is due. Waking is a reset; setup() finds the saved state and the state
+ * machine resumes at the fetch, without boot screen or full refresh.
+ *
+ *   RTC_DATA_ATTR RtcBlock<MyState> rtc;
+ *   ...
+ *   rtc.data = ...; rtc.seal();                 // before sleeping
+ *   if (wokeFromSleep() && rtc.valid()) ...     // in setup()
+ *
+ * Only ever enter sleep from loop() (ANTI-BRICK-REQUIREMENTS.md rule #1),
+ * and not within SLEEP_BOOT_GRACE_MS of a cold boot, so a freshly flashed
+ * or reset device stays reachable over USB.
+ *
+ * millis() restarts at every wake; rtcClockMs() keeps counting through
+ * sleep (the RTC timer backs gettimeofday()), so time spent asleep can be
+ * added back to saved ages.
+ *
+ * Charge per cycle: there is no current sensor on the board, so the
+ * report multiplies the measured time of each phase (awake, radio on,
+ * panel busy, asleep) by the SLEEP_UA_* currents, typical figures for an
+ * ESP32-C3 board on a 3.7 V cell. Override them with bench measurements.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef SLEEP_CYCLE_H
+#define SLEEP_CYCLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifndef SLEEP_CYCLE_ENABLE
+#define SLEEP_CYCLE_ENABLE 1
+#endif
+
+#ifndef SLEEP_ALWAYS_ON
+#define SLEEP_ALWAYS_ON 0            // 1: never sleep (bench, permanent USB power)
+#endif
+
+#ifndef SLEEP_BOOT_GRACE_MS
+#define SLEEP_BOOT_GRACE_MS 120000   // stay awake after a cold boot (reflash window)
+#endif
+
+#ifndef SLEEP_MIN_MS
+#define SLEEP_MIN_MS 8000            // shorter waits cost more to wake from than they save
+#endif
+
+#ifndef SLEEP_UA_CPU
+#define SLEEP_UA_CPU 22000           // awake, radio off
+#endif
+
+#ifndef SLEEP_UA_RADIO
+#define SLEEP_UA_RADIO 60000         // extra while Wi-Fi is up (average incl. TX bursts)
+#endif
+
+#ifndef SLEEP_UA_PANEL
+#define SLEEP_UA_PANEL 6000          // extra while the panel is BUSY
+#endif
+
+#ifndef SLEEP_UA_DEEP
+#define SLEEP_UA_DEEP 45             // chip, regulator and pull-ups in deep sleep
+#endif
+
+#define SLEEP_RTC_MAGIC 0x43435331   // "CCS1"
+
+/**
+ * A plain struct in RTC memory plus a magic and a checksum. RTC_DATA_ATTR
+ * memory survives deep sleep but holds garbage after power-on, and the
+ * layout may change between firmware builds; valid() catches both.
+ * T must be trivially copyable (no constructors: RTC_DATA_ATTR objects
+ * with one would be re-initialised on every wake).
+ */
+template <class T>
+struct RtcBlock {
+    uint32_t magic;
+    uint32_t sum;
+    T data;
+
+    bool valid() const { return magic == expectedMagic() && sum == checksum(); }
+
+    void seal() {
+        magic = expectedMagic();
+        sum = checksum();
+    }
+
+    void clear() {
+        memset(this, 0, sizeof(*this));
+    }
+
+private:
+    static uint32_t expectedMagic() { return SLEEP_RTC_MAGIC ^ (uint32_t)sizeof(T); }
+
+    uint32_t checksum() const {
+        const uint8_t* p = (const uint8_t*)&data;
+        uint32_t h = 2166136261u;    // FNV-1a
+        for (size_t i = 0; i < sizeof(T); i++) {
+            h ^= p[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+};
+
+/** Where one wake-to-sleep cycle spent its time */
+struct SleepCycleTimes {
+    uint32_t sleptMs;                // before this wake
+    uint32_t awakeMs;
+    uint32_t radioMs;                // part of awakeMs with Wi-Fi up
+    uint32_t panelMs;                // part of awakeMs with the panel BUSY
+};
+
+/** Charge drawn over a cycle, in mA·s */
+static inline float sleepCycleCharge(const SleepCycleTimes& t) {
+    uint64_t uaMs = (uint64_t)t.awakeMs * SLEEP_UA_CPU
+                  + (uint64_t)t.radioMs * SLEEP_UA_RADIO
+                  + (uint64_t)t.panelMs * SLEEP_UA_PANEL
+                  + (uint64_t)t.sleptMs * SLEEP_UA_DEEP;
+    return uaMs / 1000000.0f;
+}
+
+/**
+ * How long to sleep when `elapsedMs` of a `periodMs` cycle have passed;
+ * 0 if the rest is too short to be worth it.
+ */
+static inline uint32_t sleepCycleRemaining(unsigned long elapsedMs, uint32_t periodMs) {
+    if (elapsedMs >= periodMs) return 0;
+    uint32_t left = periodMs - (uint32_t)elapsedMs;
+    return left < SLEEP_MIN_MS ? 0 : left;
+}
+
+/** Milliseconds on a clock that keeps running through deep sleep */
+static inline uint64_t rtcClockMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+
+/** This boot is a wake from deep sleep (timer or button), not a reset */
+static inline bool wokeFromSleep() {
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    return cause == ESP_SLEEP_WAKEUP_TIMER || cause == ESP_SLEEP_WAKEUP_GPIO;
+}
+
+static inline bool wokeByButton() {
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+}
+
+/**
+ * A USB host is polling the port, so the device is on USB power. With
+ * ARDUINO_USB_CDC_ON_BOOT the USB-Serial-JTAG CDC reports this; on other
+ * builds it is never assumed.
+ */
+static inline bool usbPowered() {
+#if ARDUINO_USB_CDC_ON_BOOT
+    return (bool)Serial;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Deep-sleep for `ms`, or until `wakePin` (active-low button) is pressed.
+ * Radios must already be off. Does not return; the wake is a reset.
+ */
+static inline void sleepUntilNextCycle(uint32_t ms, int wakePin) {
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+    if (wakePin >= 0) {
+        gpio_pullup_en((gpio_num_t)wakePin);
+        esp_deep_sleep_enable_gpio_wakeup(1ULL << wakePin, ESP_GPIO_WAKEUP_GPIO_LOW);
+    }
+    Serial.flush();
+    esp_deep_sleep_start();
+}
+#endif // ESP_PLATFORM
+
+#endif // SLEEP_CYCLE_H
@@ -0,0 +1,335 @@
+/**
+ * SPI DMA Plane Writer
+ * Double-buffered plane transfers and boot-time SPI clock calibration
+ *
+ * bb_epaper sends plane data with CPU-fed SPI: a 48 KB plane at 8 MHz
+ * keeps the CPU spinning for ~50 ms (far longer with speed 0), and the
+ * BMP decoder cannot fill its next band meanwhile. The writer here copies
+ * data into one of two DMA chunks and queues it on an ESP-IDF spi_master
+ * device while the caller carries on; it only blocks when both chunks
+ * are still in flight:
+ *
+ *   chunk A: [copy][---- DMA ----]
+ *   chunk B:        [copy][---- DMA ----]
+ *   CPU:     decode band N+1 ........
+ *
+ * bb_epaper keeps sending the commands; the writer only drives DC high and
+ * CS low for the data phase and is flushed before the next command (see
+ * panel-window.h). Install it after initIO():
+ *
+ *   installPanelDataWriter(&bbep, spiHz, EPD_SCK_PIN, EPD_MOSI_PIN, EPD_CS_PIN, EPD_DC_PIN);
+ *
+ * PANEL_SPI_DMA=0 installs a CPU writer with the same byte/time counts, so
+ * the refresh log can compare the two.
+ *
+ * Calibration: before initIO(), calibratePanelSpi() reads the controller's
+ * revision register (UC8179 REV, 0x70) over the 3-wire data line at each
+ * clock in SPI_CAL_STEPS and picks the fastest one whose reads all match
+ * a slow reference read. Panels that do not answer keep SPI_CAL_FALLBACK_HZ.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef SPI_DMA_H
+#define SPI_DMA_H
+
+#include <stdint.h>
+#include <string.h>
+#include "panel-window.h"
+
+#ifndef PANEL_SPI_DMA
+#define PANEL_SPI_DMA 1
+#endif
+
+#ifndef SPI_DMA_CHUNK
+#define SPI_DMA_CHUNK 2048           // bytes per DMA transaction; two are allocated
+#endif
+
+#ifndef SPI_CAL_STEPS
+#define SPI_CAL_STEPS { 40000000, 26666667, 20000000, 16000000, 13333333, 10000000, 8000000 }
+#endif
+
+#ifndef SPI_CAL_SAFE_HZ
+#define SPI_CAL_SAFE_HZ 2000000      // reference read
+#endif
+
+#ifndef SPI_CAL_FALLBACK_HZ
+#define SPI_CAL_FALLBACK_HZ 8000000  // what the other builds always used
+#endif
+
+#define SPI_CAL_READS 8              // reads per step, all must match
+#define SPI_CAL_REG 0x70             // UC8179 REV
+#define SPI_CAL_LEN 3                // LUT revision + chip revision
+
+/**
+ * Packs writes into two chunks and keeps at most both in flight.
+ * Bus needs select(), queue(data, len) (asynchronous, in order), wait()
+ * (oldest queued transaction done) and release().
+ */
+template <class Bus>
+class DoubleBufferedWriter : public PanelDataWriter {
+public:
+    DoubleBufferedWriter(Bus& bus, unsigned long (*clockUs)() = nullptr)
+        : bus(bus), clockUs(clockUs) {}
+
+    void write(const uint8_t* data, int len) override {
+        unsigned long t0 = now();
+        if (!selected) {
+            bus.select();
+            selected = true;
+        }
+        bytes += len;
+        while (len > 0) {
+            int n = SPI_DMA_CHUNK - fill;
+            if (n > len) n = len;
+            memcpy(buf[cur] + fill, data, n);
+            fill += n;
+            data += n;
+            len -= n;
+            if (fill == SPI_DMA_CHUNK) submit();
+        }
+        cpuUs += now() - t0;
+    }
+
+    void send() override {
+        unsigned long t0 = now();
+        submit();
+        cpuUs += now() - t0;
+    }
+
+    void flush() override {
+        if (!selected) return;
+        unsigned long t0 = now();
+        submit();
+        while (inFlight > 0) {
+            bus.wait();
+            inFlight--;
+        }
+        bus.release();
+        selected = false;
+        cpuUs += now() - t0;
+    }
+
+private:
+    // Queue the current chunk and switch to the other one, waiting for it
+    // first if it is still on the wire
+    void submit() {
+        if (fill == 0) return;
+        bus.queue(buf[cur], fill);
+        inFlight++;
+        fill = 0;
+        cur ^= 1;
+        if (inFlight == 2) {
+            bus.wait();
+            inFlight--;
+        }
+    }
+
+    unsigned long now() const { return clockUs ? clockUs() : 0; }
+
+    Bus& bus;
+    unsigned long (*clockUs)();
+    uint8_t buf[2][SPI_DMA_CHUNK];
+    int cur = 0;
+    int fill = 0;
+    int inFlight = 0;
+    bool selected = false;
+};
+
+/**
+ * CPU path with the same accounting, for comparing against the DMA one
+ * (PANEL_SPI_DMA=0).
+ */
+template <class Panel>
+class PanelCpuWriter : public PanelDataWriter {
+public:
+    PanelCpuWriter(Panel* panel, unsigned long (*clockUs)() = nullptr) : panel(panel), clockUs(clockUs) {}
+
+    void write(const uint8_t* data, int len) override {
+        unsigned long t0 = clockUs ? clockUs() : 0;
+        panel->writeData((uint8_t*)data, len);
+        bytes += len;
+        if (clockUs) cpuUs += clockUs() - t0;
+    }
+
+    void flush() override {}
+
+private:
+    Panel* panel;
+    unsigned long (*clockUs)();
+};
+
+/**
+ * Fastest clock in `steps` (fastest first) at which `read(hz, out)` returns
+ * the same SPI_CAL_LEN bytes SPI_CAL_READS times in a row as at
+ * SPI_CAL_SAFE_HZ. All-0x00 or all-0xFF references mean nothing answered.
+ */
+template <class ReadFn>
+uint32_t pickSpiClock(const uint32_t* steps, int count, ReadFn read) {
+    uint8_t ref[SPI_CAL_LEN], got[SPI_CAL_LEN];
+    if (!read(SPI_CAL_SAFE_HZ, ref)) return SPI_CAL_FALLBACK_HZ;
+    bool allZero = true, allOnes = true;
+    for (int i = 0; i < SPI_CAL_LEN; i++) {
+        if (ref[i] != 0x00) allZero = false;
+        if (ref[i] != 0xFF) allOnes = false;
+    }
+    if (allZero || allOnes) return SPI_CAL_FALLBACK_HZ;
+
+    for (int s = 0; s < count; s++) {
+        bool ok = true;
+        for (int r = 0; r < SPI_CAL_READS && ok; r++) {
+            ok = read(steps[s], got) && memcmp(got, ref, SPI_CAL_LEN) == 0;
+        }
+        if (ok) return steps[s];
+    }
+    return SPI_CAL_SAFE_HZ;
+}
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <driver/spi_master.h>
+#include <soc/spi_struct.h>
+
+/**
+ * spi_master device on SPI2 (the bus Arduino's SPI and bb_epaper use) with
+ * DMA. CS and DC stay GPIOs driven here, as bb_epaper drives them.
+ */
+class SpiDmaBus {
+public:
+    bool begin(uint32_t hz, int sck, int mosi, int cs, int dc) {
+        csPin = cs;
+        dcPin = dc;
+        spi_bus_config_t bus = {};
+        bus.mosi_io_num = mosi;
+        bus.miso_io_num = -1;
+        bus.sclk_io_num = sck;
+        bus.quadwp_io_num = -1;
+        bus.quadhd_io_num = -1;
+        bus.max_transfer_sz = SPI_DMA_CHUNK;
+        if (spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO) != ESP_OK) return false;
+
+        spi_device_interface_config_t cfg = {};
+        cfg.clock_speed_hz = (int)hz;
+        cfg.mode = 0;
+        cfg.spics_io_num = -1;
+        cfg.queue_size = 2;
+        if (spi_bus_add_device(SPI2_HOST, &cfg, &dev) != ESP_OK) {
+            spi_bus_free(SPI2_HOST);
+            return false;
+        }
+        return true;
+    }
+
+    void select() {
+        digitalWrite(dcPin, HIGH);
+        digitalWrite(csPin, LOW);
+    }
+
+    void queue(const uint8_t* data, int len) {
+        spi_transaction_t& t = trans[slot];
+        slot ^= 1;
+        memset(&t, 0, sizeof(t));
+        t.length = (size_t)len * 8;
+        t.tx_buffer = data;
+        spi_device_queue_trans(dev, &t, portMAX_DELAY);
+    }
+
+    void wait() {
+        spi_transaction_t* done;
+        spi_device_get_trans_result(dev, &done, portMAX_DELAY);
+    }
+
+    void release() {
+        digitalWrite(csPin, HIGH);
+        // Arduino's SPI feeds the FIFO by hand; leave DMA off for it
+        GPSPI2.dma_conf.dma_tx_ena = 0;
+    }
+
+private:
+    spi_device_handle_t dev = nullptr;
+    spi_transaction_t trans[2];
+    int slot = 0;
+    int csPin = -1, dcPin = -1;
+};
+
+/**
+ * Reset the panel and find the fastest reliable SPI clock. Run before
+ * bb_epaper's initIO(), which takes the bus over afterwards.
+ */
+static inline uint32_t calibratePanelSpi(int sck, int mosi, int cs, int dc, int rst, int busy) {
+    pinMode(cs, OUTPUT);
+    pinMode(dc, OUTPUT);
+    pinMode(rst, OUTPUT);
+    pinMode(busy, INPUT);
+    digitalWrite(cs, HIGH);
+    digitalWrite(rst, LOW);
+    delay(10);
+    digitalWrite(rst, HIGH);
+    for (unsigned long t0 = millis(); digitalRead(busy) == LOW && millis() - t0 < 200;) delay(1);
+
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = mosi;          // bidirectional data line
+    bus.miso_io_num = -1;
+    bus.sclk_io_num = sck;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    if (spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_DISABLED) != ESP_OK) return SPI_CAL_FALLBACK_HZ;
+
+    auto read = [&](uint32_t hz, uint8_t* out) -> bool {
+        spi_device_interface_config_t cfg = {};
+        cfg.clock_speed_hz = (int)hz;
+        cfg.mode = 0;
+        cfg.spics_io_num = -1;
+        cfg.queue_size = 1;
+        cfg.flags = SPI_DEVICE_3WIRE | SPI_DEVICE_HALFDUPLEX;
+        spi_device_handle_t dev;
+        if (spi_bus_add_device(SPI2_HOST, &cfg, &dev) != ESP_OK) return false;
+
+        spi_transaction_t t = {};
+        t.flags = SPI_TRANS_USE_TXDATA;
+        t.length = 8;
+        t.tx_data[0] = SPI_CAL_REG;
+        digitalWrite(cs, LOW);
+        digitalWrite(dc, LOW);
+        bool ok = spi_device_polling_transmit(dev, &t) == ESP_OK;
+        digitalWrite(dc, HIGH);
+        memset(&t, 0, sizeof(t));
+        t.flags = SPI_TRANS_USE_RXDATA;
+        t.rxlength = SPI_CAL_LEN * 8;
+        ok = ok && spi_device_polling_transmit(dev, &t) == ESP_OK;
+        digitalWrite(cs, HIGH);
+        if (ok) memcpy(out, t.rx_data, SPI_CAL_LEN);
+        spi_bus_remove_device(dev);
+        return ok;
+    };
+
+    static const uint32_t steps[] = SPI_CAL_STEPS;
+    uint32_t hz = pickSpiClock(steps, sizeof(steps) / sizeof(steps[0]), read);
+    spi_bus_free(SPI2_HOST);
+    return hz;
+}
+
+/**
+ * Point panelDataWriter() at the DMA writer, or at the CPU one if DMA is
+ * disabled or the bus could not be set up. Returns true for DMA.
+ */
+template <class Panel>
+bool installPanelDataWriter(Panel* panel, uint32_t hz, int sck, int mosi, int cs, int dc) {
+#if PANEL_SPI_DMA
+    static SpiDmaBus bus;
+    static DoubleBufferedWriter<SpiDmaBus> dma(bus, micros);
+    static bool up = false;
+    if (!up) up = bus.begin(hz, sck, mosi, cs, dc);
+    if (up) {
+        panelDataWriter() = &dma;
+        return true;
+    }
+#endif
+    static PanelCpuWriter<Panel> cpu(panel, micros);
+    panelDataWriter() = &cpu;
+    return false;
+}
+#endif // ESP_PLATFORM
+
+#endif // SPI_DMA_H
@@ -0,0 +1,435 @@
+/**
+ * TLS Client with Session Resumption and a Pinned CA
+ * Drop-in replacement for WiFiClientSecure
+ *
+ * WiFiClientSecure runs the whole handshake inside connect() and offers no
+ * way to hand mbedTLS a previous session, so every request pays for a full
+ * handshake (ECDHE + certificate parse, ~1-2 s on the C3). TlsClient drives
+ * mbedTLS itself over a plain WiFiClient socket:
+ *
+ *   - The last session (ticket or session ID) is serialised into an
+ *     RTC_DATA_ATTR slot, so it is reused by later connections and survives
+ *     deep sleep. A resumed handshake is a single round trip with no
+ *     certificate processing.
+ *   - Full handshakes verify the server chain (MBEDTLS_SSL_VERIFY_REQUIRED)
+ *     up to a root in TLS_CA_PEM (tls-ca.h: the Let's Encrypt roots) and
+ *     the certificate against the host name. Pinning the roots rather than
+ *     a leaf or intermediate key survives certificate renewals.
+ *   - Optionally TLS_PIN_SHA256 / TLS_PIN_SHA256_BACKUP (SPKI SHA-256)
+ *     must also match a certificate of the verified chain, e.g. to tie
+ *     the server to one intermediate.
+ *   - Resumed sessions are bound to the master secret of a session that
+ *     already passed these checks.
+ *   - Without a usable CA nothing connects: there is no insecure mode.
+ *
+ * The device has no wall clock until SNTP runs, so "not yet valid" is
+ * ignored while the system time is before TLS_CLOCK_VALID_AFTER; expiry
+ * is still enforced once the clock is set.
+ *
+ * Derives from WiFiClient so it can be passed to HTTPClient::begin().
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <time.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+
+#ifndef TLS_CA_PEM
+#include "tls-ca.h"
+#define TLS_CA_PEM TLS_CA_LETS_ENCRYPT
+#endif
+
+#ifndef TLS_CLOCK_VALID_AFTER
+#define TLS_CLOCK_VALID_AFTER 1735689600   // 2025-01-01: below this the clock is unset
+#endif
+
+#ifndef TLS_PIN_SHA256
+#define TLS_PIN_SHA256 ""
+#endif
+
+#ifndef TLS_PIN_SHA256_BACKUP
+#define TLS_PIN_SHA256_BACKUP ""
+#endif
+
+#ifndef TLS_HANDSHAKE_TIMEOUT_MS
+#define TLS_HANDSHAKE_TIMEOUT_MS 15000
+#endif
+
+// Serialised session incl. peer certificate (~1.5-2.5 KB for Vercel)
+#ifndef TLS_SESSION_MAX
+#define TLS_SESSION_MAX 3072
+#endif
+
+#define TLS_SESSION_MAGIC 0x544C5331   // "TLS1"
+#define TLS_HOST_MAX 64
+
+/**
+ * Cached session for one host, kept in RTC slow memory
+ */
+struct TlsSessionSlot {
+    uint32_t magic;
+    char host[TLS_HOST_MAX];
+    uint16_t port;
+    uint16_t len;
+    uint8_t data[TLS_SESSION_MAX];
+};
+
+/**
+ * The one slot, shared by every translation unit that includes this
+ */
+inline TlsSessionSlot& tlsSessionSlot() {
+    static RTC_DATA_ATTR TlsSessionSlot slot;
+    return slot;
+}
+
+/**
+ * Drop the cached session (e.g. after a pin failure or server change)
+ */
+static inline void tlsSessionClear() {
+    TlsSessionSlot& slot = tlsSessionSlot();
+    slot.magic = 0;
+    slot.len = 0;
+}
+
+static inline bool tlsPinsConfigured() {
+    return TLS_PIN_SHA256[0] != '\0' || TLS_PIN_SHA256_BACKUP[0] != '\0';
+}
+
+/**
+ * TLS_CA_PEM, parsed on first use and kept. nullptr if no certificate in
+ * it parses; connections then fail.
+ */
+inline mbedtls_x509_crt* tlsCaChain() {
+    static mbedtls_x509_crt chain;
+    static int state = 0;                // 0 unparsed, 1 ok, -1 unusable
+    if (state == 0) {
+        mbedtls_x509_crt_init(&chain);
+        int ret = mbedtls_x509_crt_parse(&chain, (const unsigned char*)TLS_CA_PEM, strlen(TLS_CA_PEM) + 1);
+        // > 0: some certificates did not parse; the rest are still usable
+        state = (ret >= 0 && chain.version != 0) ? 1 : -1;
+        if (state < 0) Serial.printf("[TLS] No usable CA in TLS_CA_PEM (-0x%04x)\n", ret < 0 ? -ret : 0);
+    }
+    return state > 0 ? &chain : nullptr;
+}
+
+class TlsClient : public WiFiClient {
+public:
+    TlsClient() : tls(nullptr), peeked(-1), closed(false), handshakeTime(0), wasResumed(false),
+                  pinMatched(false) {}
+    ~TlsClient() { stop(); }
+
+    int connect(IPAddress ip, uint16_t port) override {
+        return connect(ip, port, TLS_HANDSHAKE_TIMEOUT_MS);
+    }
+
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) override {
+        stop();
+        if (!WiFiClient::connect(ip, port, timeout)) return 0;
+        return startTls(ip.toString().c_str(), port);
+    }
+
+    /**
+     * Connect to an address resolved elsewhere (dns-cache.h); `host` is
+     * still used for SNI and the session cache
+     */
+    int connect(IPAddress ip, uint16_t port, const char* host, int32_t timeout) {
+        stop();
+        if (!WiFiClient::connect(ip, port, timeout)) return 0;
+        return startTls(host, port);
+    }
+
+    int connect(const char* host, uint16_t port) override {
+        return connect(host, port, TLS_HANDSHAKE_TIMEOUT_MS);
+    }
+
+    int connect(const char* host, uint16_t port, int32_t timeout) override {
+        stop();
+        if (!WiFiClient::connect(host, port, timeout)) return 0;
+        return startTls(host, port);
+    }
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        if (!tls) return 0;
+        size_t sent = 0;
+        unsigned long start = millis();
+        while (sent < size) {
+            int n = mbedtls_ssl_write(&tls->ssl, buf + sent, size - sent);
+            if (n > 0) {
+                sent += n;
+            } else if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                if (millis() - start > TLS_HANDSHAKE_TIMEOUT_MS) break;
+                delay(1);
+            } else {
+                break;
+            }
+        }
+        return sent;
+    }
+
+    int available() override {
+        if (!tls) return 0;
+        int n = (peeked >= 0) ? 1 : 0;
+        if (mbedtls_ssl_get_bytes_avail(&tls->ssl) == 0) {
+            // Process any buffered record without consuming application data
+            int r = mbedtls_ssl_read(&tls->ssl, nullptr, 0);
+            if (r < 0 && r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) {
+                closed = true;
+            }
+        }
+        return n + (int)mbedtls_ssl_get_bytes_avail(&tls->ssl);
+    }
+
+    int read() override {
+        uint8_t b;
+        return read(&b, 1) == 1 ? b : -1;
+    }
+
+    int read(uint8_t* buf, size_t size) override {
+        if (!tls || size == 0) return -1;
+        size_t off = 0;
+        if (peeked >= 0) {
+            buf[off++] = (uint8_t)peeked;
+            peeked = -1;
+            if (size == 1) return 1;
+        }
+        int n = mbedtls_ssl_read(&tls->ssl, buf + off, size - off);
+        if (n > 0) return (int)off + n;
+        if (n == 0 || (n != MBEDTLS_ERR_SSL_WANT_READ && n != MBEDTLS_ERR_SSL_WANT_WRITE)) {
+            closed = true;   // close_notify or fatal error
+        }
+        return off > 0 ? (int)off : -1;
+    }
+
+    int peek() override {
+        if (peeked < 0) {
+            uint8_t b;
+            if (read(&b, 1) == 1) peeked = b;
+        }
+        return peeked;
+    }
+
+    void flush() override {}
+
+    uint8_t connected() override {
+        if (!tls) return 0;
+        if (peeked >= 0 || mbedtls_ssl_get_bytes_avail(&tls->ssl) > 0) return 1;
+        return !closed && WiFiClient::connected();
+    }
+
+    void stop() override {
+        if (tls) {
+            if (!closed) mbedtls_ssl_close_notify(&tls->ssl);
+            mbedtls_ssl_free(&tls->ssl);
+            mbedtls_ssl_config_free(&tls->conf);
+            delete tls;
+            tls = nullptr;
+        }
+        peeked = -1;
+        WiFiClient::stop();
+    }
+
+    /**
+     * Duration of the last TLS handshake (TCP connect excluded)
+     */
+    uint32_t handshakeMs() const { return handshakeTime; }
+
+    /**
+     * True if the last handshake resumed a cached session
+     */
+    bool resumed() const { return wasResumed; }
+
+private:
+    struct TlsState {
+        mbedtls_ssl_context ssl;
+        mbedtls_ssl_config conf;
+    };
+
+    TlsState* tls;
+    int peeked;
+    bool closed;
+    uint32_t handshakeTime;
+    bool wasResumed;
+    bool pinMatched;                     // a verified chain certificate matched a pin
+
+    // ---- BIO over the underlying TCP socket (non-blocking) ----
+
+    static int bioSend(void* ctx, const unsigned char* buf, size_t len) {
+        TlsClient* self = (TlsClient*)ctx;
+        size_t n = self->WiFiClient::write(buf, len);
+        if (n > 0) return (int)n;
+        return self->WiFiClient::connected() ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+
+    static int bioRecv(void* ctx, unsigned char* buf, size_t len) {
+        TlsClient* self = (TlsClient*)ctx;
+        if (self->WiFiClient::available() <= 0) {
+            return self->WiFiClient::connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+        }
+        int n = self->WiFiClient::read(buf, len);
+        return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    static int rng(void*, unsigned char* out, size_t len) {
+        esp_fill_random(out, len);
+        return 0;
+    }
+
+    int startTls(const char* host, uint16_t port) {
+        mbedtls_x509_crt* ca = tlsCaChain();
+        if (!ca) {
+            WiFiClient::stop();
+            return 0;
+        }
+        tls = new TlsState();
+        if (!tls) {
+            WiFiClient::stop();
+            return 0;
+        }
+        closed = false;
+        wasResumed = false;
+        pinMatched = false;
+        mbedtls_ssl_init(&tls->ssl);
+        mbedtls_ssl_config_init(&tls->conf);
+
+        if (mbedtls_ssl_config_defaults(&tls->conf, MBEDTLS_SSL_IS_CLIENT,
+                                        MBEDTLS_SSL_TRANSPORT_STREAM,
+                                        MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+            stop();
+            return 0;
+        }
+        mbedtls_ssl_conf_authmode(&tls->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        mbedtls_ssl_conf_ca_chain(&tls->conf, ca, nullptr);
+        mbedtls_ssl_conf_verify(&tls->conf, verifyCert, this);
+        mbedtls_ssl_conf_rng(&tls->conf, rng, nullptr);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_conf_session_tickets(&tls->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+        if (mbedtls_ssl_setup(&tls->ssl, &tls->conf) != 0 ||
+            mbedtls_ssl_set_hostname(&tls->ssl, host) != 0) {
+            stop();
+            return 0;
+        }
+        mbedtls_ssl_set_bio(&tls->ssl, this, bioSend, bioRecv, nullptr);
+
+        // Offer the cached session for this host
+        unsigned char offeredMaster[48];
+        bool offered = false;
+        const TlsSessionSlot& slot = tlsSessionSlot();
+        if (slot.magic == TLS_SESSION_MAGIC && slot.port == port && strcmp(slot.host, host) == 0) {
+            mbedtls_ssl_session saved;
+            mbedtls_ssl_session_init(&saved);
+            if (mbedtls_ssl_session_load(&saved, slot.data, slot.len) == 0 &&
+                mbedtls_ssl_set_session(&tls->ssl, &saved) == 0) {
+                memcpy(offeredMaster, saved.master, sizeof(offeredMaster));
+                offered = true;
+            } else {
+                tlsSessionClear();
+            }
+            mbedtls_ssl_session_free(&saved);
+        }
+
+        unsigned long t0 = millis();
+        int ret;
+        while ((ret = mbedtls_ssl_handshake(&tls->ssl)) != 0) {
+            if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) break;
+            if (millis() - t0 > TLS_HANDSHAKE_TIMEOUT_MS) break;
+            delay(1);
+        }
+        handshakeTime = millis() - t0;
+
+        if (ret != 0) {
+            uint32_t flags = mbedtls_ssl_get_verify_result(&tls->ssl);
+            if (ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
+                Serial.printf("[TLS] %s certificate rejected: flags 0x%08lx\n", host, (unsigned long)flags);
+            }
+            Serial.printf("[TLS] %s handshake failed: -0x%04x\n", host, -ret);
+            if (offered) tlsSessionClear();
+            stop();
+            return 0;
+        }
+
+        mbedtls_ssl_session current;
+        mbedtls_ssl_session_init(&current);
+        mbedtls_ssl_get_session(&tls->ssl, &current);
+        wasResumed = offered && memcmp(current.master, offeredMaster, sizeof(offeredMaster)) == 0;
+
+        if (!wasResumed) {
+            if (tlsPinsConfigured() && !pinMatched) {
+                Serial.printf("[TLS] %s public key pin mismatch\n", host);
+                mbedtls_ssl_session_free(&current);
+                tlsSessionClear();
+                stop();
+                return 0;
+            }
+            saveSession(current, host, port);
+        }
+        mbedtls_ssl_session_free(&current);
+
+        Serial.printf("[TLS] %s handshake %lu ms (%s)\n", host,
+                      (unsigned long)handshakeTime, wasResumed ? "resumed" : "full");
+        return 1;
+    }
+
+    void saveSession(const mbedtls_ssl_session& session, const char* host, uint16_t port) {
+        TlsSessionSlot& slot = tlsSessionSlot();
+        size_t len = 0;
+        slot.magic = 0;
+        if (strlen(host) >= TLS_HOST_MAX) return;
+        int ret = mbedtls_ssl_session_save(&session, slot.data, sizeof(slot.data), &len);
+        if (ret != 0) {
+            Serial.printf("[TLS] Session not cached: -0x%04x (%u B)\n", -ret, (unsigned)len);
+            return;
+        }
+        strcpy(slot.host, host);
+        slot.port = port;
+        slot.len = (uint16_t)len;
+        slot.magic = TLS_SESSION_MAGIC;
+    }
+
+    static bool pinMatches(const char* pin, const char* hex) {
+        return pin[0] != '\0' && strcasecmp(pin, hex) == 0;
+    }
+
+    static bool spkiMatchesPin(const mbedtls_x509_crt* crt) {
+        unsigned char der[600];
+        int len = mbedtls_pk_write_pubkey_der((mbedtls_pk_context*)&crt->pk, der, sizeof(der));
+        if (len <= 0) return false;
+
+        unsigned char digest[32];
+        if (mbedtls_sha256_ret(der + sizeof(der) - len, len, digest, 0) != 0) return false;
+
+        char hex[65];
+        for (int i = 0; i < 32; i++) sprintf(hex + i * 2, "%02x", digest[i]);
+        return pinMatches(TLS_PIN_SHA256, hex) || pinMatches(TLS_PIN_SHA256_BACKUP, hex);
+    }
+
+    /**
+     * Called by mbedTLS for each certificate of the chain it built, root
+     * first. Pins are only matched against certificates that verified, so
+     * a pinned intermediate appended to a foreign leaf does not count.
+     */
+    static int verifyCert(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags) {
+        TlsClient* self = (TlsClient*)ctx;
+        (void)depth;
+        if (time(nullptr) < TLS_CLOCK_VALID_AFTER) *flags &= ~MBEDTLS_X509_BADCERT_FUTURE;
+        if (*flags == 0 && tlsPinsConfigured() && spkiMatchesPin(crt)) self->pinMatched = true;
+        return 0;
+    }
+};
+
+#endif // TLS_SESSION_H
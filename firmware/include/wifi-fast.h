@@ -0,0 +1,191 @@
+/**
+ * Wi-Fi Fast Connect
+ * Rejoin the last access point without a scan, and without DHCP while
+ * its lease is young
+ *
+ * WiFi.begin(ssid, pass) scans every channel before it associates (1-2 s),
+ * DHCP adds a few hundred ms to seconds, and connectWiFi() polled in
+ * 500 ms steps on top. WifiFast remembers what the last connect found:
+ *
+ *   - BSSID and channel, in RTC memory and NVS (cold boots benefit too);
+ *   - the DHCP lease (address, gateway, mask, DNS), in RTC memory only,
+ *     since its age is known across deep sleep but not across power loss.
+ *
+ * and picks the quickest path it can trust (wifiFastPlan()):
+ *
+ *   WIFI_PATH_STATIC  BSSID + channel, lease reused as a static IP; only
+ *                     while it is younger than WIFI_LEASE_REUSE_MS, after
+ *                     which a normal DHCP connect renews it
+ *   WIFI_PATH_BSSID   BSSID + channel, DHCP
+ *   WIFI_PATH_SCAN    full scan, DHCP (no history, or the SSID changed)
+ *
+ * A fast path that has not connected within WIFI_FAST_TIMEOUT_MS falls
+ * back to the scan. The link state is polled every WIFI_POLL_MS.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef WIFI_FAST_H
+#define WIFI_FAST_H
+
+#include <stdint.h>
+#include <string.h>
+#include "sleep-cycle.h"
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR
+#endif
+
+#ifndef WIFI_LEASE_REUSE_MS
+#define WIFI_LEASE_REUSE_MS 1800000ULL   // 30 min: half the shortest common lease
+#endif
+
+#ifndef WIFI_FAST_TIMEOUT_MS
+#define WIFI_FAST_TIMEOUT_MS 3000
+#endif
+
+#ifndef WIFI_SCAN_TIMEOUT_MS
+#define WIFI_SCAN_TIMEOUT_MS 15000       // what the old 30 x 500 ms loop allowed
+#endif
+
+#define WIFI_POLL_MS 10
+#define WIFI_FAST_NVS_KEY "wifi_fast"
+#define WIFI_SSID_MAX 33
+
+struct WifiFastState {
+    char ssid[WIFI_SSID_MAX];
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip, gateway, mask, dns;     // as IPAddress
+    uint64_t leaseAtMs;                  // rtcClockMs() when DHCP gave the lease; 0: none
+};
+
+enum WifiFastPath { WIFI_PATH_SCAN, WIFI_PATH_BSSID, WIFI_PATH_STATIC };
+
+/** Quickest connect path `s` allows for `ssid` at `now` (rtcClockMs()) */
+static inline WifiFastPath wifiFastPlan(const WifiFastState& s, bool valid, const char* ssid, uint64_t now) {
+    if (!valid || s.channel <= 0 || strncmp(s.ssid, ssid, WIFI_SSID_MAX) != 0) return WIFI_PATH_SCAN;
+    if (s.ip && s.leaseAtMs && now >= s.leaseAtMs && now - s.leaseAtMs < WIFI_LEASE_REUSE_MS) {
+        return WIFI_PATH_STATIC;
+    }
+    return WIFI_PATH_BSSID;
+}
+
+static inline const char* wifiFastPathName(WifiFastPath p) {
+    return p == WIFI_PATH_STATIC ? "cached AP + lease" : p == WIFI_PATH_BSSID ? "cached AP" : "scan";
+}
+
+#ifdef ESP_PLATFORM
+/** The one slot, shared by every translation unit that includes this */
+inline RtcBlock<WifiFastState>& wifiFastSlot() {
+    static RTC_DATA_ATTR RtcBlock<WifiFastState> slot;
+    return slot;
+}
+
+class WifiFast {
+public:
+    /** Cold boot: the AP from NVS (no lease) if RTC memory has nothing */
+    void load(Preferences& prefs) {
+        if (wifiFastSlot().valid()) return;
+        wifiFastSlot().clear();
+        WifiFastState& s = wifiFastSlot().data;
+        if (prefs.getBytesLength(WIFI_FAST_NVS_KEY) != sizeof(s)) return;
+        prefs.getBytes(WIFI_FAST_NVS_KEY, &s, sizeof(s));
+        s.ssid[WIFI_SSID_MAX - 1] = '\0';
+        s.ip = 0;
+        s.leaseAtMs = 0;
+        wifiFastSlot().seal();
+    }
+
+    bool connect(const char* ssid, const char* pass) {
+        unsigned long t0 = millis();
+        const WifiFastState& s = wifiFastSlot().data;
+        WifiFastPath path = wifiFastPlan(s, wifiFastSlot().valid(), ssid, rtcClockMs());
+
+        WiFi.persistent(false);          // credentials live in our own NVS keys
+        WiFi.mode(WIFI_STA);
+        if (path != WIFI_PATH_SCAN) {
+            if (path == WIFI_PATH_STATIC) {
+                WiFi.config(IPAddress(s.ip), IPAddress(s.gateway), IPAddress(s.mask), IPAddress(s.dns));
+            } else {
+                WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+            }
+            WiFi.begin(ssid, pass, s.channel, s.bssid);
+            if (waitConnected(WIFI_FAST_TIMEOUT_MS)) return connected(ssid, path, t0);
+            Serial.printf("[WiFi] %s failed after %lu ms, scanning\n", wifiFastPathName(path), millis() - t0);
+            WiFi.disconnect();
+        }
+
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+        WiFi.begin(ssid, pass);
+        if (waitConnected(WIFI_SCAN_TIMEOUT_MS)) return connected(ssid, WIFI_PATH_SCAN, t0);
+        wifiFastSlot().clear();
+        return false;
+    }
+
+    WifiFastPath lastPath() const { return path; }
+    uint32_t lastConnectMs() const { return connectMs; }
+
+private:
+    static bool waitConnected(uint32_t timeoutMs) {
+        for (unsigned long t0 = millis(); millis() - t0 < timeoutMs; delay(WIFI_POLL_MS)) {
+            wl_status_t st = WiFi.status();
+            if (st == WL_CONNECTED) return true;
+            if (st == WL_CONNECT_FAILED) return false;
+        }
+        return false;
+    }
+
+    // Remember the AP (and the lease, if DHCP gave one); NVS only when the AP changed
+    bool connected(const char* ssid, WifiFastPath p, unsigned long t0) {
+        path = p;
+        connectMs = millis() - t0;
+        WifiFastState& s = wifiFastSlot().data;
+        bool apChanged = !wifiFastSlot().valid() || strncmp(s.ssid, ssid, WIFI_SSID_MAX) != 0 ||
+                         memcmp(s.bssid, WiFi.BSSID(), 6) != 0 || s.channel != WiFi.channel();
+        if (apChanged) {
+            wifiFastSlot().clear();
+            strncpy(s.ssid, ssid, WIFI_SSID_MAX - 1);
+            memcpy(s.bssid, WiFi.BSSID(), 6);
+            s.channel = WiFi.channel();
+        }
+        if (p != WIFI_PATH_STATIC) {
+            s.ip = (uint32_t)WiFi.localIP();
+            s.gateway = (uint32_t)WiFi.gatewayIP();
+            s.mask = (uint32_t)WiFi.subnetMask();
+            s.dns = (uint32_t)WiFi.dnsIP(0);
+            s.leaseAtMs = rtcClockMs();
+        }
+        wifiFastSlot().seal();
+        if (apChanged) persist();
+        Serial.printf("[WiFi] Connected in %lu ms (%s), ch %ld\n", (unsigned long)connectMs,
+                      wifiFastPathName(p), (long)s.channel);
+        return true;
+    }
+
+    void persist() {
+        Preferences prefs;
+        if (!prefs.begin("cc-device", false)) return;
+        prefs.putBytes(WIFI_FAST_NVS_KEY, &wifiFastSlot().data, sizeof(WifiFastState));
+        prefs.end();
+    }
+
+    WifiFastPath path = WIFI_PATH_SCAN;
+    uint32_t connectMs = 0;
+};
+
+inline WifiFast& wifiFast() {
+    static WifiFast fast;
+    return fast;
+}
+#endif // ESP_PLATFORM
+
+#endif // WIFI_FAST_H
@@ -0,0 +1,209 @@
+/**
+ * Zone Bundle Reader
+ * Streams a /api/zones-bundle response one zone at a time
+ *
+ * Wire format (little-endian, see api/zones-bundle.js):
+ *   "CCZB"  u8 version  u8 zoneCount
+ *   per zone: u8 idLen, id, i16 x, i16 y, u16 w, u16 h, u8 flags,
+ *             [v2: u8 etagLen, etag,]
+ *             [v3, delta frames: i16 dx, i16 dy, u16 dw, u16 dh,]
+ *             u32 length, length bytes of BMP or rle1
+ *
+ * Unchanged zones (X-Zone-ETags matched) arrive with flags bit 0 clear
+ * and length 0. Delta frames (flags bit 1, only when X-Zone-Delta was
+ * sent) carry just the changed rectangle, to be drawn at (x + dx, y + dy)
+ * over the zone the ETag named. /api/zones-sync marks large changed zones
+ * deferred (flags bit 2, length 0) instead of inlining them. Flags bits
+ * 4-5 carry the zone's refresh tier (1-3, 0 for none); zoneBundleTier().
+ *
+ * The reader only ever holds one frame header; zone payloads are pulled
+ * straight from the connection by the caller with read(). next() returns
+ * false both at the end and on a read error; atEnd() tells them apart.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef ZONE_BUNDLE_H
+#define ZONE_BUNDLE_H
+
+#include "zone-connection.h"
+
+#define ZONE_BUNDLE_VERSION 3
+#define ZONE_BUNDLE_ID_MAX 24
+#define ZONE_BUNDLE_FLAG_CHANGED 0x01
+#define ZONE_BUNDLE_FLAG_DELTA 0x02
+#define ZONE_BUNDLE_FLAG_DEFERRED 0x04   // changed, fetch /api/zone/:id (sync replies)
+#define ZONE_BUNDLE_TIER_SHIFT 4
+#define ZONE_BUNDLE_TIER_MASK 0x30
+
+struct ZoneFrame {
+    char id[ZONE_BUNDLE_ID_MAX];
+    int16_t x, y;
+    uint16_t w, h;
+    uint8_t flags;
+    char etag[ZONE_ETAG_MAX];
+    int16_t dx, dy;         // delta rect, zone relative (delta frames only)
+    uint16_t dw, dh;
+    uint32_t length;
+};
+
+/** Refresh tier the server gave a frame, 0 if none (or an older server) */
+static inline int zoneBundleTier(uint8_t flags) {
+    return (flags & ZONE_BUNDLE_TIER_MASK) >> ZONE_BUNDLE_TIER_SHIFT;
+}
+
+class ZoneBundleReader {
+public:
+    explicit ZoneBundleReader(ZoneConnection& conn)
+        : conn(conn), version(0), count(0), index(0), remaining(0), failed(false) {}
+
+    /**
+     * Read and validate the bundle header. Returns zone count or -1.
+     */
+    int begin() {
+        uint8_t hdr[6];
+        if (!conn.readBodyFully(hdr, sizeof(hdr))) return -1;
+        if (memcmp(hdr, "CCZB", 4) != 0 || hdr[4] < 1 || hdr[4] > ZONE_BUNDLE_VERSION) {
+            Serial.println("[Bundle] Bad header");
+            return -1;
+        }
+        version = hdr[4];
+        count = hdr[5];
+        index = 0;
+        remaining = 0;
+        failed = false;
+        return count;
+    }
+
+    /**
+     * Advance to the next zone frame, discarding any unread payload of the
+     * current one. Returns false at the end of the bundle or on error.
+     */
+    bool next(ZoneFrame& frame) {
+        if (failed) return false;
+        if (!skip(remaining)) {
+            failed = true;
+            return false;
+        }
+        if (index >= count) return false;
+        if (!readFrame(frame)) {
+            failed = true;
+            return false;
+        }
+        index++;
+        return true;
+    }
+
+    /**
+     * Read up to len bytes of the current zone payload.
+     * Returns bytes read, 0 at end of payload, -1 on error.
+     */
+    int read(uint8_t* buf, size_t len) {
+        if (remaining == 0) return 0;
+        if (len > remaining) len = remaining;
+        int n = conn.readBody(buf, len);
+        if (n <= 0) {
+            failed = true;
+            return -1;
+        }
+        remaining -= n;
+        return n;
+    }
+
+    /**
+     * Read exactly len bytes of the current zone payload
+     */
+    bool readFully(uint8_t* buf, size_t len) {
+        if (len > remaining) return false;
+        if (!conn.readBodyFully(buf, len)) {
+            failed = true;
+            return false;
+        }
+        remaining -= len;
+        return true;
+    }
+
+    uint32_t payloadRemaining() const { return remaining; }
+    int zoneCount() const { return count; }
+
+    /** True once every frame the header announced has been read, without error */
+    bool atEnd() const { return !failed && index >= count; }
+
+private:
+    ZoneConnection& conn;
+    uint8_t version;
+    int count;
+    int index;
+    uint32_t remaining;
+    bool failed;
+
+    bool readFrame(ZoneFrame& frame) {
+        uint8_t idLen;
+        if (!conn.readBodyFully(&idLen, 1)) return false;
+
+        if (!readString(idLen, frame.id, sizeof(frame.id))) return false;
+
+        uint8_t geo[9];
+        if (!conn.readBodyFully(geo, sizeof(geo))) return false;
+        frame.x = (int16_t)(geo[0] | (geo[1] << 8));
+        frame.y = (int16_t)(geo[2] | (geo[3] << 8));
+        frame.w = (uint16_t)(geo[4] | (geo[5] << 8));
+        frame.h = (uint16_t)(geo[6] | (geo[7] << 8));
+        frame.flags = geo[8];
+
+        frame.etag[0] = '\0';
+        if (version >= 2) {
+            uint8_t etagLen;
+            if (!conn.readBodyFully(&etagLen, 1)) return false;
+            if (!readString(etagLen, frame.etag, sizeof(frame.etag))) return false;
+        }
+
+        frame.dx = frame.dy = 0;
+        frame.dw = frame.w;
+        frame.dh = frame.h;
+        if (version >= 3 && (frame.flags & ZONE_BUNDLE_FLAG_DELTA)) {
+            uint8_t d[8];
+            if (!conn.readBodyFully(d, sizeof(d))) return false;
+            frame.dx = (int16_t)(d[0] | (d[1] << 8));
+            frame.dy = (int16_t)(d[2] | (d[3] << 8));
+            frame.dw = (uint16_t)(d[4] | (d[5] << 8));
+            frame.dh = (uint16_t)(d[6] | (d[7] << 8));
+        } else {
+            frame.flags &= ~ZONE_BUNDLE_FLAG_DELTA;
+        }
+
+        uint8_t len[4];
+        if (!conn.readBodyFully(len, sizeof(len))) return false;
+        frame.length = (uint32_t)len[0] | ((uint32_t)len[1] << 8) |
+                       ((uint32_t)len[2] << 16) | ((uint32_t)len[3] << 24);
+
+        remaining = frame.length;
+        return true;
+    }
+
+    /**
+     * Read a length-prefixed string, truncating to fit out
+     */
+    bool readString(uint8_t len, char* out, size_t outLen) {
+        char tmp[256];
+        if (len > 0 && !conn.readBodyFully((uint8_t*)tmp, len)) return false;
+        size_t keep = len < outLen - 1 ? len : outLen - 1;
+        memcpy(out, tmp, keep);
+        out[keep] = '\0';
+        return true;
+    }
+
+    bool skip(uint32_t n) {
+        uint8_t scratch[128];
+        while (n > 0) {
+            size_t chunk = n < sizeof(scratch) ? n : sizeof(scratch);
+            if (!conn.readBodyFully(scratch, chunk)) return false;
+            n -= chunk;
+        }
+        remaining = 0;
+        return true;
+    }
+};
+
+#endif // ZONE_BUNDLE_H
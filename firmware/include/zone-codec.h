@@ -0,0 +1,235 @@
+/**
+ * Zone Codec Decoder
+ * Streams "rle1" zone images (row-XOR + PackBits) into a BmpRowSink
+ *
+ * Format (see src/services/zone-codec.js):
+ *   "Z1"  u16 width  u16 height  u8 flags (bit 0: rows XORed with row above)
+ *   PackBits body over rows of ceil(width / 8) bytes, 1 = white
+ *
+ * Typical dashboard zones are 10-40x smaller than the BMP, which cuts
+ * radio-on time and TLS record work on the C3. Memory is the caller's row
+ * band (as for BmpStreamDecoder) plus one previous row.
+ *
+ * ZoneImageDecoder accepts either a BMP or an rle1 stream, chosen by the
+ * first byte, so callers can advertise the codec (ZONE_CODEC_HEADER) and
+ * draw whatever the server sends back.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef ZONE_CODEC_H
+#define ZONE_CODEC_H
+
+#include "bmp-stream.h"
+
+#define ZONE_CODEC_HEADER "X-Zone-Codec: rle1\r\n"
+#define ZONE_CODEC_FLAG_XOR 0x01
+
+#ifndef ZONE_CODEC_ROW_MAX
+#define ZONE_CODEC_ROW_MAX 100   // 800 px
+#endif
+
+class ZoneCodecDecoder {
+public:
+    typedef BmpStreamDecoder::Result Result;
+
+    ZoneCodecDecoder(uint8_t* band, size_t bandSize) : band(band), bandSize(bandSize) {
+        reset(nullptr);
+    }
+
+    void reset(BmpRowSink* rowSink) {
+        sink = rowSink;
+        state = HEADER;
+        pos = 0;
+        rowsDone = 0;
+        rowPos = 0;
+        bandRows = 0;
+    }
+
+    /**
+     * Feed the next piece of the stream. Returns DONE once every row has
+     * been delivered, FAILED on a malformed stream.
+     */
+    Result feed(const uint8_t* data, size_t len) {
+        while (len > 0) {
+            switch (state) {
+                case HEADER:
+                    hdr[pos++] = *data++;
+                    len--;
+                    if (pos == sizeof(hdr) && !parseHeader()) state = FAIL;
+                    break;
+
+                case CONTROL: {
+                    uint8_t n = *data++;
+                    len--;
+                    if (n < 128) {
+                        count = n + 1;
+                        state = LITERAL;
+                    } else if (n > 128) {
+                        count = 257 - n;
+                        state = REPEAT;
+                    }
+                    break;
+                }
+
+                case LITERAL: {
+                    size_t n = count < len ? count : len;
+                    for (size_t i = 0; i < n && state == LITERAL; i++) put(data[i]);
+                    data += n;
+                    len -= n;
+                    if (state == LITERAL && (count -= n) == 0) state = CONTROL;
+                    break;
+                }
+
+                case REPEAT: {
+                    uint8_t v = *data++;
+                    len--;
+                    while (count > 0 && state == REPEAT) {
+                        putRun(v, count);
+                    }
+                    if (state == REPEAT) state = CONTROL;
+                    break;
+                }
+
+                case DONE_STATE:
+                    return BmpStreamDecoder::DONE;
+
+                case FAIL:
+                    return BmpStreamDecoder::FAILED;
+            }
+        }
+        if (state == DONE_STATE) return BmpStreamDecoder::DONE;
+        if (state == FAIL) return BmpStreamDecoder::FAILED;
+        return BmpStreamDecoder::NEED_MORE;
+    }
+
+    bool done() const { return state == DONE_STATE; }
+    int imageWidth() const { return width; }
+    int imageHeight() const { return height; }
+
+private:
+    enum State { HEADER, CONTROL, LITERAL, REPEAT, DONE_STATE, FAIL };
+
+    uint8_t* band;
+    size_t bandSize;
+    BmpRowSink* sink;
+    State state;
+
+    uint8_t hdr[7];
+    size_t pos;
+    uint8_t flags;
+    int width, height;
+    int rowBytes;
+    int rowsPerBand;
+    int rowsDone;
+    int rowPos;
+    int bandRows;
+    size_t count;                       // bytes left in the current packet
+    uint8_t prevRow[ZONE_CODEC_ROW_MAX];   // last row of the previous band
+
+    bool parseHeader() {
+        if (hdr[0] != 'Z' || hdr[1] != '1') return false;
+        width = hdr[2] | (hdr[3] << 8);
+        height = hdr[4] | (hdr[5] << 8);
+        flags = hdr[6];
+        rowBytes = (width + 7) / 8;
+        if (width == 0 || height == 0 || rowBytes > ZONE_CODEC_ROW_MAX) {
+#ifdef ESP_PLATFORM
+            Serial.printf("[Codec] Unsupported: %dx%d\n", width, height);
+#endif
+            return false;
+        }
+        rowsPerBand = bandSize / rowBytes;
+        if (rowsPerBand < 1) return false;
+        if (sink && !sink->begin(width, height)) return false;
+        memset(prevRow, 0xFF, sizeof(prevRow));   // row -1 is white
+        state = CONTROL;
+        return true;
+    }
+
+    /** Row above the one being written (for the XOR) */
+    const uint8_t* above() const {
+        return bandRows > 0 ? band + (bandRows - 1) * rowBytes : prevRow;
+    }
+
+    void put(uint8_t b) {
+        uint8_t* row = band + bandRows * rowBytes;
+        row[rowPos] = (flags & ZONE_CODEC_FLAG_XOR) ? b ^ above()[rowPos] : b;
+        if (++rowPos == rowBytes) endRow();
+    }
+
+    /** Write up to count copies of v, stopping at the end of the row */
+    void putRun(uint8_t v, size_t& left) {
+        uint8_t* row = band + bandRows * rowBytes;
+        size_t n = rowBytes - rowPos;
+        if (n > left) n = left;
+        if (flags & ZONE_CODEC_FLAG_XOR) {
+            const uint8_t* up = above() + rowPos;
+            if (v == 0) {
+                memcpy(row + rowPos, up, n);   // unchanged from the row above
+            } else {
+                for (size_t i = 0; i < n; i++) row[rowPos + i] = up[i] ^ v;
+            }
+        } else {
+            memset(row + rowPos, v, n);
+        }
+        rowPos += n;
+        left -= n;
+        if (rowPos == rowBytes) endRow();
+    }
+
+    void endRow() {
+        rowPos = 0;
+        bandRows++;
+        rowsDone++;
+        if (bandRows == rowsPerBand || rowsDone == height) {
+            memcpy(prevRow, band + (bandRows - 1) * rowBytes, rowBytes);
+            bool ok = !sink || sink->writeRows(rowsDone - bandRows, bandRows, band, rowBytes);
+            bandRows = 0;
+            if (!ok) {
+                state = FAIL;
+                return;
+            }
+        }
+        if (rowsDone == height) {
+            if (sink) sink->end();
+            state = DONE_STATE;
+        }
+    }
+};
+
+/**
+ * Decodes a zone image that may be a BMP or an rle1 stream
+ */
+class ZoneImageDecoder {
+public:
+    typedef BmpStreamDecoder::Result Result;
+
+    ZoneImageDecoder(uint8_t* band, size_t bandSize)
+        : bmp(band, bandSize), rle(band, bandSize), kind(UNKNOWN) {}
+
+    void reset(BmpRowSink* rowSink) {
+        kind = UNKNOWN;
+        bmp.reset(rowSink);
+        rle.reset(rowSink);
+    }
+
+    Result feed(const uint8_t* data, size_t len) {
+        if (len == 0) return BmpStreamDecoder::NEED_MORE;
+        if (kind == UNKNOWN) kind = data[0] == 'Z' ? RLE : BMP;
+        return kind == RLE ? rle.feed(data, len) : bmp.feed(data, len);
+    }
+
+    bool done() const { return kind == RLE ? rle.done() : (kind == BMP && bmp.done()); }
+    bool isCompressed() const { return kind == RLE; }
+
+private:
+    enum Kind { UNKNOWN, BMP, RLE };
+
+    BmpStreamDecoder bmp;
+    ZoneCodecDecoder rle;
+    Kind kind;
+};
+
+#endif // ZONE_CODEC_H
@@ -0,0 +1,409 @@
+/**
+ * Zone Connection Manager
+ * Persistent keep-alive HTTPS connection for the per-zone fetch loop
+ *
+ * One TLS session is opened per refresh cycle and every zone GET is sent
+ * over it. Requests are pipelined (several GETs written before the first
+ * response is read) up to ZONE_PIPELINE_DEPTH; if the server closes the
+ * connection with requests still outstanding, pipelining is switched off
+ * for the rest of the session and the unanswered requests are re-sent.
+ *
+ * The session runs on TlsClient, so reconnects within a cycle and the
+ * first connect of later cycles resume the cached TLS session. The server
+ * address comes from dns-cache.h, so a wake does not wait for a lookup.
+ *
+ * HTTPClient is not used here: it cannot pipeline and re-parses the URL
+ * on every request. The small HTTP/1.1 reader below handles exactly what
+ * the zone endpoints return (Content-Length or chunked bodies).
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef ZONE_CONNECTION_H
+#define ZONE_CONNECTION_H
+
+#include <Arduino.h>
+#include "tls-session.h"
+#include "dns-cache.h"
+#include "next-change.h"
+
+#ifndef ZONE_PIPELINE_DEPTH
+#define ZONE_PIPELINE_DEPTH 3
+#endif
+
+#ifndef ZONE_CONN_TIMEOUT_MS
+#define ZONE_CONN_TIMEOUT_MS 15000
+#endif
+
+#define ZONE_CONN_LINE_MAX 320      // fits X-Zone-Next-Change for a 16-zone bundle
+#define ZONE_ETAG_MAX 40
+
+// Ask for changed-rectangle updates against the If-None-Match ETag
+#define ZONE_DELTA_HEADER "X-Zone-Delta: rect\r\n"
+
+/**
+ * Parsed response head for one zone request
+ */
+struct ZoneResponse {
+    int status;
+    long contentLength;     // -1 when chunked or unknown
+    bool chunked;
+    bool keepAlive;
+    char etag[ZONE_ETAG_MAX];
+    int zoneX, zoneY, zoneW, zoneH;   // X-Zone-* headers, -1 if absent
+    int deltaX, deltaY, deltaW, deltaH;   // X-Zone-Delta rect (zone relative), deltaW -1 if absent
+    uint32_t syncSeq, syncEpoch;          // X-Sync-* cursor, 0 if absent
+    int32_t nextChangeS;                  // X-Next-Change, -1 if absent
+    char zoneHints[ZONE_HINTS_MAX];       // X-Zone-Next-Change, "" if absent
+};
+
+/**
+ * Per-cycle connection metrics
+ */
+struct ZoneConnStats {
+    uint16_t requests;
+    uint16_t handshakes;
+    uint16_t resumed;
+    uint16_t resent;
+    uint32_t handshakeMs;
+    uint32_t firstByteMs;   // cycle start to the first response head, 0 if none
+    uint32_t bodyBytes;
+    unsigned long cycleStart;
+    uint32_t wallMs;
+};
+
+class ZoneConnection {
+public:
+    ZoneConnection() : port(443), pipelineOk(true), defaultHeaders(""), inBody(false) {
+        host[0] = '\0';
+        prefix[0] = '\0';
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    /**
+     * Set the server from a base URL ("https://host[:port][/prefix]")
+     */
+    bool begin(const char* baseUrl) {
+        const char* p = baseUrl;
+        if (strncmp(p, "https://", 8) == 0) p += 8;
+        else if (strncmp(p, "http://", 7) == 0) return false;  // TLS only
+
+        const char* hostEnd = p;
+        while (*hostEnd && *hostEnd != '/' && *hostEnd != ':') hostEnd++;
+        size_t hostLen = hostEnd - p;
+        if (hostLen == 0 || hostLen >= sizeof(host)) return false;
+
+        memcpy(host, p, hostLen);
+        host[hostLen] = '\0';
+        port = 443;
+
+        const char* rest = hostEnd;
+        if (*rest == ':') {
+            port = (uint16_t)atoi(rest + 1);
+            while (*rest && *rest != '/') rest++;
+        }
+
+        strncpy(prefix, rest, sizeof(prefix) - 1);
+        prefix[sizeof(prefix) - 1] = '\0';
+        size_t plen = strlen(prefix);
+        if (plen > 0 && prefix[plen - 1] == '/') prefix[plen - 1] = '\0';
+        return true;
+    }
+
+    const char* getHost() const { return host; }
+
+    /**
+     * Header lines ("Name: value\r\n") sent with every request, e.g. the
+     * zone codec the firmware can decode. The string must stay valid.
+     */
+    void setDefaultHeaders(const char* headers) { defaultHeaders = headers ? headers : ""; }
+
+    bool connected() { return client.connected(); }
+
+    /**
+     * Open the TLS session if it is not already up
+     */
+    bool open() {
+        if (client.connected()) return true;
+        client.stop();
+
+        IPAddress ip;
+        bool cached = false;
+        bool ok = dnsCacheResolve(host, ip, cached)
+            ? client.connect(ip, port, host, ZONE_CONN_TIMEOUT_MS)
+            : client.connect(host, port, ZONE_CONN_TIMEOUT_MS);
+        if (!ok && cached) {
+            // The cached address may have moved: look the name up again
+            dnsCache().forget(host);
+            ok = dnsCacheResolve(host, ip, cached) && client.connect(ip, port, host, ZONE_CONN_TIMEOUT_MS);
+        }
+        if (!ok) {
+            Serial.printf("[Conn] Connect to %s failed\n", host);
+            return false;
+        }
+        uint32_t dt = client.handshakeMs();
+        stats.handshakes++;
+        if (client.resumed()) stats.resumed++;
+        stats.handshakeMs += dt;
+        inBody = false;
+        Serial.printf("[Conn] TLS handshake %lu ms, %s (heap %u)\n",
+                      (unsigned long)dt, client.resumed() ? "resumed" : "full", ESP.getFreeHeap());
+        return true;
+    }
+
+    void close() {
+        client.stop();
+        inBody = false;
+    }
+
+    /**
+     * Pipeline depth to use for the next batch of requests
+     */
+    int pipelineDepth() const { return pipelineOk ? ZONE_PIPELINE_DEPTH : 1; }
+
+    /**
+     * Called when the server dropped the connection with requests in flight
+     */
+    void disablePipelining() {
+        if (pipelineOk) Serial.println("[Conn] Server closed pipelined session - pipelining off");
+        pipelineOk = false;
+    }
+
+    /**
+     * Write a GET request for prefix + path. Does not wait for the response.
+     */
+    bool sendGet(const char* path, const char* extraHeaders = nullptr) {
+        char req[512];
+        int n = snprintf(req, sizeof(req),
+                         "GET %s%s HTTP/1.1\r\n"
+                         "Host: %s\r\n"
+                         "User-Agent: CommuteCompute/" FIRMWARE_VERSION "\r\n"
+                         "Connection: keep-alive\r\n"
+                         "%s%s"
+                         "\r\n",
+                         prefix, path, host, defaultHeaders, extraHeaders ? extraHeaders : "");
+        if (n <= 0 || n >= (int)sizeof(req)) return false;
+        if (client.write((const uint8_t*)req, n) != (size_t)n) return false;
+        stats.requests++;
+        return true;
+    }
+
+    /**
+     * Read the status line and headers of the next response
+     */
+    bool readResponse(ZoneResponse& resp) {
+        resp.status = 0;
+        resp.contentLength = -1;
+        resp.chunked = false;
+        resp.keepAlive = true;
+        resp.etag[0] = '\0';
+        resp.zoneX = resp.zoneY = resp.zoneW = resp.zoneH = -1;
+        resp.deltaX = resp.deltaY = resp.deltaW = resp.deltaH = -1;
+        resp.syncSeq = resp.syncEpoch = 0;
+        resp.nextChangeS = -1;
+        resp.zoneHints[0] = '\0';
+
+        char line[ZONE_CONN_LINE_MAX];
+        if (readLine(line, sizeof(line)) < 0) return false;
+        if (strncmp(line, "HTTP/1.", 7) != 0) return false;
+        resp.status = atoi(line + 9);
+        if (stats.firstByteMs == 0) stats.firstByteMs = millis() - stats.cycleStart;
+        if (line[7] == '0') resp.keepAlive = false;   // HTTP/1.0
+
+        for (;;) {
+            int len = readLine(line, sizeof(line));
+            if (len < 0) return false;
+            if (len == 0) break;
+
+            char* value = strchr(line, ':');
+            if (!value) continue;
+            *value++ = '\0';
+            while (*value == ' ') value++;
+
+            if (strcasecmp(line, "Content-Length") == 0) {
+                resp.contentLength = atol(value);
+            } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+                resp.chunked = strcasestr(value, "chunked") != nullptr;
+            } else if (strcasecmp(line, "Connection") == 0) {
+                if (strcasecmp(value, "close") == 0) resp.keepAlive = false;
+            } else if (strcasecmp(line, "ETag") == 0) {
+                strncpy(resp.etag, value, sizeof(resp.etag) - 1);
+                resp.etag[sizeof(resp.etag) - 1] = '\0';
+            } else if (strcasecmp(line, "X-Zone-X") == 0) {
+                resp.zoneX = atoi(value);
+            } else if (strcasecmp(line, "X-Zone-Y") == 0) {
+                resp.zoneY = atoi(value);
+            } else if (strcasecmp(line, "X-Zone-Width") == 0) {
+                resp.zoneW = atoi(value);
+            } else if (strcasecmp(line, "X-Zone-Height") == 0) {
+                resp.zoneH = atoi(value);
+            } else if (strcasecmp(line, "X-Zone-Delta") == 0) {
+                if (sscanf(value, "%d,%d,%d,%d", &resp.deltaX, &resp.deltaY,
+                           &resp.deltaW, &resp.deltaH) != 4) {
+                    resp.deltaW = -1;
+                }
+            } else if (strcasecmp(line, "X-Sync-Seq") == 0) {
+                resp.syncSeq = strtoul(value, nullptr, 10);
+            } else if (strcasecmp(line, "X-Sync-Epoch") == 0) {
+                resp.syncEpoch = strtoul(value, nullptr, 10);
+            } else if (strcasecmp(line, "X-Next-Change") == 0) {
+                resp.nextChangeS = atol(value);
+            } else if (strcasecmp(line, "X-Zone-Next-Change") == 0) {
+                copyZoneHints(resp.zoneHints, sizeof(resp.zoneHints), value, len == (int)sizeof(line) - 1);
+            }
+        }
+
+        // 204/304 and 1xx never carry a body
+        bool noBody = resp.status == 204 || resp.status == 304 || resp.status < 200;
+        if (resp.chunked) resp.contentLength = -1;
+        bodyRemaining = noBody ? 0 : resp.contentLength;
+        chunked = !noBody && resp.chunked;
+        chunkRemaining = 0;
+        bodyDone = noBody || (!chunked && resp.contentLength == 0);
+        inBody = true;
+
+        // Without a length or chunking the body runs to connection close
+        if (!noBody && !chunked && resp.contentLength < 0) resp.keepAlive = false;
+        return true;
+    }
+
+    /**
+     * Read up to len bytes of the current body.
+     * Returns bytes read, 0 at end of body, -1 on error/timeout.
+     */
+    int readBody(uint8_t* buf, size_t len) {
+        if (!inBody || bodyDone) return 0;
+
+        if (chunked) {
+            if (chunkRemaining == 0) {
+                char line[24];
+                if (readLine(line, sizeof(line)) < 0) return -1;
+                if (line[0] == '\0' && readLine(line, sizeof(line)) < 0) return -1;
+                chunkRemaining = strtol(line, nullptr, 16);
+                if (chunkRemaining == 0) {
+                    // Trailer section ends with an empty line
+                    while (readLine(line, sizeof(line)) > 0) {}
+                    bodyDone = true;
+                    return 0;
+                }
+            }
+            if ((long)len > chunkRemaining) len = chunkRemaining;
+        } else if (bodyRemaining >= 0) {
+            if ((long)len > bodyRemaining) len = bodyRemaining;
+        }
+
+        int n = readSome(buf, len);
+        if (n < 0) {
+            // Read-to-close bodies end when the server hangs up
+            if (!chunked && bodyRemaining < 0 && !client.connected()) {
+                bodyDone = true;
+                return 0;
+            }
+            return -1;
+        }
+
+        stats.bodyBytes += n;
+        if (chunked) {
+            chunkRemaining -= n;
+        } else if (bodyRemaining >= 0) {
+            bodyRemaining -= n;
+            if (bodyRemaining == 0) bodyDone = true;
+        }
+        return n;
+    }
+
+    /**
+     * Read exactly len body bytes. Returns false on short read.
+     */
+    bool readBodyFully(uint8_t* buf, size_t len) {
+        size_t got = 0;
+        while (got < len) {
+            int n = readBody(buf + got, len - got);
+            if (n <= 0) return false;
+            got += n;
+        }
+        return true;
+    }
+
+    /**
+     * Discard the rest of the current body so the next response can be read
+     */
+    bool skipBody() {
+        uint8_t scratch[256];
+        for (;;) {
+            int n = readBody(scratch, sizeof(scratch));
+            if (n == 0) return true;
+            if (n < 0) return false;
+        }
+    }
+
+    // ---- Per-cycle metrics ----
+
+    void beginCycle() {
+        memset(&stats, 0, sizeof(stats));
+        stats.cycleStart = millis();
+    }
+
+    void endCycle() {
+        stats.wallMs = millis() - stats.cycleStart;
+        Serial.printf("[Conn] Cycle: %u req, %u handshake(s) (%u resumed) %lu ms, first byte %lu ms, %u resent, %lu B, %lu ms wall\n",
+                      stats.requests, stats.handshakes, stats.resumed, (unsigned long)stats.handshakeMs,
+                      (unsigned long)stats.firstByteMs, stats.resent, (unsigned long)stats.bodyBytes,
+                      (unsigned long)stats.wallMs);
+    }
+
+    ZoneConnStats stats;
+
+private:
+    TlsClient client;
+    char host[96];
+    uint16_t port;
+    char prefix[64];
+    bool pipelineOk;
+    const char* defaultHeaders;
+
+    bool inBody;
+    bool chunked;
+    bool bodyDone;
+    long bodyRemaining;
+    long chunkRemaining;
+
+    /**
+     * Read at least one byte (up to len) before the timeout
+     */
+    int readSome(uint8_t* buf, size_t len) {
+        if (len == 0) return 0;
+        unsigned long deadline = millis() + ZONE_CONN_TIMEOUT_MS;
+        while ((long)(deadline - millis()) > 0) {
+            int avail = client.available();
+            if (avail > 0) {
+                int n = client.read(buf, min((size_t)avail, len));
+                if (n > 0) return n;
+            } else if (!client.connected()) {
+                return -1;
+            }
+            delay(1);
+        }
+        return -1;
+    }
+
+    /**
+     * Read one CRLF-terminated line (CR/LF stripped, overlong lines truncated).
+     * Returns line length or -1 on timeout/disconnect.
+     */
+    int readLine(char* out, size_t outLen) {
+        size_t n = 0;
+        for (;;) {
+            uint8_t c;
+            if (readSome(&c, 1) < 0) return -1;
+            if (c == '\n') break;
+            if (c == '\r') continue;
+            if (n < outLen - 1) out[n++] = (char)c;
+        }
+        out[n] = '\0';
+        return (int)n;
+    }
+};
+
+#endif // ZONE_CONNECTION_H
@@ -0,0 +1,198 @@
+/**
+ * Zone ETag Cache
+ * Per-zone ETags for conditional (If-None-Match) zone fetches
+ *
+ * An ETag is only meaningful while the panel RAM still holds the bitmap
+ * it was issued for, so anything that draws over the dashboard (boot,
+ * setup, error screens) must call invalidate().
+ *
+ * The table is mirrored to NVS (namespace "cc-device", key "zone_etags")
+ * as a single blob. Writes are throttled to ZONE_ETAG_PERSIST_MS because
+ * the clock zone changes every minute and NVS lives in flash.
+ *
+ * The /api/zones-sync cursor (epoch + sequence) follows the same rules:
+ * it describes what the panel shows, so invalidate() resets it. A stale
+ * cursor restored from NVS is safe; it only asks for more zones.
+ *
+ * Across deep sleep the table rides in RTC memory instead (save() and
+ * restore(), see sleep-cycle.h), together with the time since the last
+ * NVS write, so waking every minute does not defeat the throttle.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef ZONE_ETAG_CACHE_H
+#define ZONE_ETAG_CACHE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "zone-connection.h"
+
+#ifndef ZONE_ETAG_SLOTS
+#define ZONE_ETAG_SLOTS 12
+#endif
+
+#ifndef ZONE_ETAG_PERSIST_MS
+#define ZONE_ETAG_PERSIST_MS 900000   // 15 min
+#endif
+
+#define ZONE_ETAG_ID_MAX 16
+#define ZONE_ETAG_NVS_KEY "zone_etags"
+#define ZONE_SYNC_NVS_KEY "zone_sync"
+
+class ZoneEtagCache {
+public:
+    ZoneEtagCache() : dirty(false), lastPersist(0) { clear(); }
+
+    uint32_t syncEpoch() const { return sync.epoch; }
+    uint32_t syncSeq() const { return sync.seq; }
+
+    /**
+     * Record the sync cursor once every zone it lists has been drawn
+     */
+    void setSyncCursor(uint32_t epoch, uint32_t seq) {
+        if (sync.epoch == epoch && sync.seq == seq) return;
+        sync.epoch = epoch;
+        sync.seq = seq;
+        dirty = true;
+    }
+
+    /**
+     * ETag last stored for a zone, or nullptr if none
+     */
+    const char* get(const char* id) const {
+        int i = find(id);
+        return (i >= 0 && entries[i].etag[0]) ? entries[i].etag : nullptr;
+    }
+
+    void set(const char* id, const char* etag) {
+        int i = find(id);
+        if (i < 0) i = find("");
+        if (i < 0) return;
+        if (strcmp(entries[i].etag, etag) == 0 && strcmp(entries[i].id, id) == 0) return;
+        strncpy(entries[i].id, id, ZONE_ETAG_ID_MAX - 1);
+        entries[i].id[ZONE_ETAG_ID_MAX - 1] = '\0';
+        strncpy(entries[i].etag, etag, ZONE_ETAG_MAX - 1);
+        entries[i].etag[ZONE_ETAG_MAX - 1] = '\0';
+        dirty = true;
+    }
+
+    void remove(const char* id) {
+        int i = find(id);
+        if (i < 0) return;
+        memset(&entries[i], 0, sizeof(entries[i]));
+        dirty = true;
+    }
+
+    /**
+     * Forget every ETag (panel no longer shows the dashboard)
+     */
+    void invalidate() {
+        bool used = sync.seq != 0;
+        for (int i = 0; i < ZONE_ETAG_SLOTS && !used; i++) {
+            if (entries[i].id[0]) used = true;
+        }
+        if (used) {
+            clear();
+            dirty = true;
+        }
+    }
+
+    /** The cache as carried through deep sleep */
+    struct Snapshot {
+        uint8_t table[(ZONE_ETAG_ID_MAX + ZONE_ETAG_MAX) * ZONE_ETAG_SLOTS];
+        uint32_t epoch;
+        uint32_t seq;
+        uint32_t persistAgeMs;       // UINT32_MAX: never persisted
+        bool dirty;
+    };
+
+    void save(Snapshot& out) const {
+        memcpy(out.table, entries, sizeof(entries));
+        out.epoch = sync.epoch;
+        out.seq = sync.seq;
+        out.persistAgeMs = lastPersist == 0 ? UINT32_MAX : (uint32_t)(millis() - lastPersist);
+        out.dirty = dirty;
+    }
+
+    /**
+     * Take the cache back after a wake. `sleptMs` is the time since save()
+     * that millis() did not see.
+     */
+    void restore(const Snapshot& in, uint32_t sleptMs) {
+        memcpy(entries, in.table, sizeof(entries));
+        for (int i = 0; i < ZONE_ETAG_SLOTS; i++) {
+            entries[i].id[ZONE_ETAG_ID_MAX - 1] = '\0';
+            entries[i].etag[ZONE_ETAG_MAX - 1] = '\0';
+        }
+        sync.epoch = in.epoch;
+        sync.seq = in.seq;
+        dirty = in.dirty;
+        lastPersist = in.persistAgeMs == UINT32_MAX ? 0 : millis() - (in.persistAgeMs + sleptMs);
+    }
+
+    void load(Preferences& prefs) {
+        if (prefs.getBytesLength(ZONE_ETAG_NVS_KEY) == sizeof(entries)) {
+            prefs.getBytes(ZONE_ETAG_NVS_KEY, entries, sizeof(entries));
+            for (int i = 0; i < ZONE_ETAG_SLOTS; i++) {
+                entries[i].id[ZONE_ETAG_ID_MAX - 1] = '\0';
+                entries[i].etag[ZONE_ETAG_MAX - 1] = '\0';
+            }
+        } else {
+            clear();
+        }
+        if (prefs.getBytesLength(ZONE_SYNC_NVS_KEY) == sizeof(sync)) {
+            prefs.getBytes(ZONE_SYNC_NVS_KEY, &sync, sizeof(sync));
+        }
+        dirty = false;
+    }
+
+    /**
+     * Write the table to NVS if it changed and the throttle has elapsed
+     * (or force is set). Opens its own Preferences handle.
+     */
+    void persist(bool force = false) {
+        if (!dirty) return;
+        if (!force && lastPersist != 0 && millis() - lastPersist < ZONE_ETAG_PERSIST_MS) return;
+
+        Preferences prefs;
+        if (!prefs.begin("cc-device", false)) return;
+        prefs.putBytes(ZONE_ETAG_NVS_KEY, entries, sizeof(entries));
+        prefs.putBytes(ZONE_SYNC_NVS_KEY, &sync, sizeof(sync));
+        prefs.end();
+        dirty = false;
+        lastPersist = millis();
+    }
+
+private:
+    struct Entry {
+        char id[ZONE_ETAG_ID_MAX];
+        char etag[ZONE_ETAG_MAX];
+    };
+
+    struct SyncCursor {
+        uint32_t epoch;
+        uint32_t seq;
+    };
+
+    Entry entries[ZONE_ETAG_SLOTS];
+    static_assert(sizeof(Entry) * ZONE_ETAG_SLOTS == sizeof(Snapshot::table), "Snapshot::table size");
+    SyncCursor sync;
+    bool dirty;
+    unsigned long lastPersist;
+
+    void clear() {
+        memset(entries, 0, sizeof(entries));
+        memset(&sync, 0, sizeof(sync));
+    }
+
+    int find(const char* id) const {
+        for (int i = 0; i < ZONE_ETAG_SLOTS; i++) {
+            if (strcmp(entries[i].id, id) == 0) return i;
+        }
+        return -1;
+    }
+};
+
+#endif // ZONE_ETAG_CACHE_H
@@ -0,0 +1,197 @@
+/**
+ * Zone Scheduler
+ * Per-zone refresh deadlines in a min-heap, fetched in merged batches
+ *
+ * The tiered loop kept one timestamp per tier and checked them in turn,
+ * so when tiers 1 and 2 fell due together it made two HTTPS requests and
+ * two panel refreshes a few seconds apart. Here every zone has its own
+ * next-due time (millis) and period, and the earliest sits at the top of
+ * a binary heap:
+ *
+ *   ZoneScheduler sched;
+ *   sched.set("status", 60000, now + 60000);      // learnt from a fetch
+ *   idleUntil(sched.nextDue(), ...);              // sleep to the earliest
+ *   ZoneSchedEntry due[ZONE_SCHED_MAX];
+ *   int n = sched.takeDue(now, due, ZONE_SCHED_MAX);
+ *   ... one fetch and one refresh for all n ...
+ *   sched.reschedule(due, n, now);                // or retry(due, n, at)
+ *
+ * takeDue() also takes every zone due within ZONE_SCHED_MERGE_MS of now,
+ * so deadlines that nearly coincide cost one request, and since those
+ * zones are rescheduled from the same instant they stay in step.
+ * Rescheduling from the start of the fetch rather than its end keeps the
+ * cadence from drifting by the fetch time.
+ *
+ * Deadlines can be inserted or moved at any time: set() for a new zone
+ * or a server hint, pullIn() / pullAllIn() to bring zones forward (the
+ * button). Capacity is ZONE_SCHED_MAX; lookups by id are linear, which
+ * at this size is cheaper than an index.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#ifndef ZONE_SCHEDULER_H
+#define ZONE_SCHEDULER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef ZONE_SCHED_MAX
+#define ZONE_SCHED_MAX 16            // /api/zones-bundle serves at most 16 zones
+#endif
+
+#ifndef ZONE_SCHED_MERGE_MS
+#define ZONE_SCHED_MERGE_MS 10000    // fetch zones due this soon along with the due ones
+#endif
+
+#define ZONE_SCHED_ID_LEN 32
+
+struct ZoneSchedEntry {
+    char id[ZONE_SCHED_ID_LEN];
+    unsigned long due;               // millis
+    uint32_t periodMs;
+};
+
+struct ZoneSchedStats {
+    uint32_t batches;                // takeDue() calls that returned zones
+    uint32_t zones;                  // zones taken
+    uint32_t early;                  // of which taken before their deadline
+};
+
+class ZoneScheduler {
+public:
+    explicit ZoneScheduler(uint32_t mergeMs = ZONE_SCHED_MERGE_MS) : mergeMs(mergeMs) {}
+
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /** Earliest deadline; only meaningful if !empty() */
+    unsigned long nextDue() const { return heap[0].due; }
+
+    bool contains(const char* id) const { return find(id) >= 0; }
+
+    /**
+     * Schedule `id` every `periodMs`, next at `due`. Moves it if already
+     * scheduled. False if the heap is full or the id too long.
+     */
+    bool set(const char* id, uint32_t periodMs, unsigned long due) {
+        int i = find(id);
+        if (i < 0) {
+            if (count == ZONE_SCHED_MAX || strlen(id) >= ZONE_SCHED_ID_LEN) return false;
+            i = count++;
+            strcpy(heap[i].id, id);
+        }
+        heap[i].periodMs = periodMs;
+        heap[i].due = due;
+        fix(i);
+        return true;
+    }
+
+    /** Bring `id` forward to `at` (never later). False if not scheduled. */
+    bool pullIn(const char* id, unsigned long at) {
+        int i = find(id);
+        if (i < 0) return false;
+        if (before(at, heap[i].due)) {
+            heap[i].due = at;
+            siftUp(i);
+        }
+        return true;
+    }
+
+    void pullAllIn(unsigned long at) {
+        for (int i = 0; i < count; i++) {
+            if (before(at, heap[i].due)) heap[i].due = at;
+        }
+        // Re-heapify bottom-up; at this size simpler than sifting each
+        for (int i = count / 2 - 1; i >= 0; i--) siftDown(i);
+    }
+
+    /**
+     * If the earliest zone is due at `now`, remove it and every zone due
+     * within the merge window into `out` (earliest first). Returns how
+     * many; 0 if nothing is due yet.
+     */
+    int takeDue(unsigned long now, ZoneSchedEntry* out, int max) {
+        if (count == 0 || before(now, heap[0].due)) return 0;
+        unsigned long horizon = now + mergeMs;
+        int n = 0;
+        while (count > 0 && n < max && !before(horizon, heap[0].due)) {
+            if (before(now, heap[0].due)) stat.early++;
+            out[n++] = heap[0];
+            heap[0] = heap[--count];
+            siftDown(0);
+        }
+        stat.batches++;
+        stat.zones += n;
+        return n;
+    }
+
+    /** Fetched at `now`: each zone due again one period later */
+    void reschedule(const ZoneSchedEntry* batch, int n, unsigned long now) {
+        for (int i = 0; i < n; i++) set(batch[i].id, batch[i].periodMs, now + batch[i].periodMs);
+    }
+
+    /** Fetch failed: try the same zones again at `at` */
+    void retry(const ZoneSchedEntry* batch, int n, unsigned long at) {
+        for (int i = 0; i < n; i++) set(batch[i].id, batch[i].periodMs, at);
+    }
+
+    const ZoneSchedStats& stats() const { return stat; }
+
+    /** `events` over `elapsedMs`, as a rate per hour */
+    static float perHour(uint32_t events, unsigned long elapsedMs) {
+        return elapsedMs ? events * 3600000.0f / elapsedMs : 0.0f;
+    }
+
+private:
+    // Deadline order on a wrapping millis clock
+    static bool before(unsigned long a, unsigned long b) { return (long)(a - b) < 0; }
+
+    int find(const char* id) const {
+        for (int i = 0; i < count; i++) {
+            if (strcmp(heap[i].id, id) == 0) return i;
+        }
+        return -1;
+    }
+
+    void swap(int a, int b) {
+        ZoneSchedEntry t = heap[a];
+        heap[a] = heap[b];
+        heap[b] = t;
+    }
+
+    void siftUp(int i) {
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!before(heap[i].due, heap[parent].due)) break;
+            swap(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(int i) {
+        for (;;) {
+            int least = i;
+            int l = 2 * i + 1, r = l + 1;
+            if (l < count && before(heap[l].due, heap[least].due)) least = l;
+            if (r < count && before(heap[r].due, heap[least].due)) least = r;
+            if (least == i) break;
+            swap(i, least);
+            i = least;
+        }
+    }
+
+    void fix(int i) {
+        siftUp(i);
+        siftDown(i);
+    }
+
+    ZoneSchedEntry heap[ZONE_SCHED_MAX];
+    int count = 0;
+    uint32_t mergeMs;
+    ZoneSchedStats stat = {};
+};
+
+#endif // ZONE_SCHEDULER_H
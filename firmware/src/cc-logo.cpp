@@ -9,31 +9,22 @@
 #include <Arduino.h>
 #include <bb_epaper.h>
 #include "../include/cc-logo.h"
+#include "../include/blit-1bpp.h"
 
 // External reference to the display object
 extern BBEPAPER bbep;
 
 /**
  * Draw the CC logo at specified position
- * Uses direct pixel drawing for 1-bit bitmap
+ * Blits the 1-bit bitmap (1 = black) into the framebuffer, or straight
+ * into panel RAM when bb_epaper runs without one
  * 
  * @param x X position (top-left of logo)
  * @param y Y position (top-left of logo)
  */
 void drawCCLogo(int x, int y) {
-    for (int row = 0; row < CC_LOGO_HEIGHT; row++) {
-        for (int col = 0; col < CC_LOGO_WIDTH; col++) {
-            int byte_idx = row * CC_LOGO_BYTES_PER_ROW + (col / 8);
-            int bit_idx = 7 - (col % 8);  // MSB first
-            
-            uint8_t byte_val = pgm_read_byte(&CC_LOGO_DATA[byte_idx]);
-            
-            if (byte_val & (1 << bit_idx)) {
-                // Draw black pixel where bit=1 (logo is inverted: 1=black)
-                bbep.drawPixel(x + col, y + row, BBEP_BLACK);
-            }
-        }
-    }
+    blit1bppToDisplay(&bbep, x, y, CC_LOGO_DATA, CC_LOGO_BYTES_PER_ROW,
+                      CC_LOGO_WIDTH, CC_LOGO_HEIGHT, BLIT_INVERT | BLIT_INK_ONLY);
 }
 
 /**
@@ -16,6 +16,7 @@
 
 #include <bb_epaper.h>
 #include <ArduinoJson.h>
+#include "../include/refresh-planner.h"
 
 extern BBEPAPER bbep;
 
@@ -262,6 +263,9 @@ void drawDashboardTemplate(JsonDocument& doc) {
 void updateDashboardTemplateRegions(JsonDocument& doc) {
     JsonArray regions = doc["regions"].as<JsonArray>();
 
+    // Changed regions are refreshed together at the end, not one by one
+    static RefreshPlanner plan(800, 480, millis);
+
     // Static previous values for change detection
     static char prevTime[16] = "";
     static char prevTram1Time[16] = "";
@@ -307,7 +311,7 @@ void updateDashboardTemplateRegions(JsonDocument& doc) {
         bbep.setCursor(timeX + 1, timeY + 1);
         bbep.print(timeText);
 
-        bbep.refresh(REFRESH_PARTIAL, true);
+        plan.add(boxX, boxY, boxW, boxH);
         strncpy(prevTime, timeText, sizeof(prevTime) - 1);
     }
 
@@ -322,7 +326,7 @@ void updateDashboardTemplateRegions(JsonDocument& doc) {
         bbep.print(tram1Time);
         bbep.print(" min*");
 
-        bbep.refresh(REFRESH_PARTIAL, true);
+        plan.add(boxX, boxY, boxW, boxH);
         strncpy(prevTram1Time, tram1Time, sizeof(prevTram1Time) - 1);
     }
 
@@ -337,7 +341,7 @@ void updateDashboardTemplateRegions(JsonDocument& doc) {
         bbep.print(tram2Time);
         bbep.print(" min*");
 
-        bbep.refresh(REFRESH_PARTIAL, true);
+        plan.add(boxX, boxY, boxW, boxH);
         strncpy(prevTram2Time, tram2Time, sizeof(prevTram2Time) - 1);
     }
 
@@ -352,7 +356,7 @@ void updateDashboardTemplateRegions(JsonDocument& doc) {
         bbep.print(train1Time);
         bbep.print(" min*");
 
-        bbep.refresh(REFRESH_PARTIAL, true);
+        plan.add(boxX, boxY, boxW, boxH);
         strncpy(prevTrain1Time, train1Time, sizeof(prevTrain1Time) - 1);
     }
 
@@ -367,9 +371,15 @@ void updateDashboardTemplateRegions(JsonDocument& doc) {
         bbep.print(train2Time);
         bbep.print(" min*");
 
-        bbep.refresh(REFRESH_PARTIAL, true);
+        plan.add(boxX, boxY, boxW, boxH);
         strncpy(prevTrain2Time, train2Time, sizeof(prevTrain2Time) - 1);
     }
+
+    if (!plan.empty()) {
+        int n = plan.execute(&bbep, REFRESH_PARTIAL, REFRESH_PARTIAL);
+        Serial.printf("[Template] %d refresh%s, panel busy %lu ms\n", n, n == 1 ? "" : "es",
+                      (unsigned long)plan.busyMs());
+    }
 }
 
 // ============================================================================
@@ -22,7 +22,6 @@
 #define SCREEN_W 800
 #define SCREEN_H 480
 #define MAX_ZONES 6
-#define ZONE_BMP_MAX_SIZE 20000
 #define ZONE_ID_MAX_LEN 32
 
 // HARDCODED - no NVS needed
@@ -52,7 +51,6 @@ struct Zone {
 };
 Zone zones[MAX_ZONES];
 int zoneCount = 0;
-uint8_t* zoneBmpBuffer = nullptr;
 
 void initDisplay() {
     Serial.println("Initializing display...");
@@ -181,24 +179,21 @@ bool fetchAndDrawZones() {
         if (zone.changed || !initialDrawDone) {
             const char* b64Data = zoneObj["data"];
             if (b64Data) {
-                size_t len = strlen(b64Data);
-                size_t dec = decode_base64_length((unsigned char*)b64Data, len);
-                if (dec <= ZONE_BMP_MAX_SIZE) {
-                    decode_base64((unsigned char*)b64Data, len, zoneBmpBuffer);
-                    // Verify BMP header
-                    if (zoneBmpBuffer[0] == 'B' && zoneBmpBuffer[1] == 'M') {
-                        int result = bbep.loadBMP(zoneBmpBuffer, zone.x, zone.y, BBEP_BLACK, BBEP_WHITE);
-                        if (result == BBEP_SUCCESS) {
-                            anyChanged = true;
-                            Serial.printf("Drew zone %s at (%d,%d) %dx%d\n", zone.id, zone.x, zone.y, zone.w, zone.h);
-                        } else {
-                            Serial.printf("loadBMP failed for zone %s: %d\n", zone.id, result);
-                        }
+                // Decode in place: the document owns this copy of the string
+                // and the BMP is shorter than its base64 text
+                uint8_t* bmp = (uint8_t*)b64Data;
+                size_t dec = decode_base64(bmp, strlen(b64Data), bmp);
+                // Verify BMP header
+                if (dec >= 2 && bmp[0] == 'B' && bmp[1] == 'M') {
+                    int result = bbep.loadBMP(bmp, zone.x, zone.y, BBEP_BLACK, BBEP_WHITE);
+                    if (result == BBEP_SUCCESS) {
+                        anyChanged = true;
+                        Serial.printf("Drew zone %s at (%d,%d) %dx%d\n", zone.id, zone.x, zone.y, zone.w, zone.h);
                     } else {
-                        Serial.printf("Invalid BMP header for zone %s\n", zone.id);
+                        Serial.printf("loadBMP failed for zone %s: %d\n", zone.id, result);
                     }
                 } else {
-                    Serial.printf("Zone %s data too large: %d bytes\n", zone.id, dec);
+                    Serial.printf("Invalid BMP header for zone %s\n", zone.id);
                 }
             } else {
                 Serial.printf("No data for zone %s\n", zone.id);
@@ -235,12 +230,6 @@ void setup() {
     Serial.println("\n=== Commute Compute v" FIRMWARE_VERSION " ===");
     Serial.println("NVS BYPASS MODE - No preferences used");
     
-    // Allocate BMP buffer
-    zoneBmpBuffer = (uint8_t*)malloc(ZONE_BMP_MAX_SIZE);
-    if (!zoneBmpBuffer) {
-        Serial.println("ERROR: Failed to allocate BMP buffer");
-    }
-    
     initDisplay();
     connectWiFi();
     
@@ -15,6 +15,8 @@
 #include <bb_epaper.h>
 #include "soc/soc.h"
 #include "soc/rtc_cntl_reg.h"
+#include "../include/sleep-cycle.h"
+#include "../include/idle-sleep.h"
 
 #define FIRMWARE_VERSION "6.7-sequential"
 #define SCREEN_W 800
@@ -32,6 +34,7 @@ const unsigned long REFRESH_INTERVAL = 20000;  // 20 seconds
 #define EPD_RST_PIN  10
 #define EPD_DC_PIN   5
 #define EPD_BUSY_PIN 4
+#define PIN_INTERRUPT 2
 
 BBEPAPER bbep(EP75_800x480);
 unsigned long lastRefresh = 0;
@@ -204,6 +207,7 @@ void setup() {
     }
     
     initDisplay();
+    idleSleep().begin(PIN_INTERRUPT);
     connectWiFi();
     
     // Initial refresh
@@ -232,5 +236,9 @@ void loop() {
         lastRefresh = millis();
     }
     
-    delay(100);
+    // Modem/light sleep until the next refresh, association kept.
+    // Light sleep would drop a USB console, so only without a host.
+    idleSleep().idleUntil(lastRefresh + REFRESH_INTERVAL, !usbPowered(),
+                          []() { return WiFi.status() == WL_CONNECTED; });
+    logIdleSleep();
 }
@@ -6,7 +6,15 @@
  * - Tier 1 (1 min): Clock, duration boxes, departure times
  * - Tier 2 (2 min): Weather, leg content - only if changed
  * - Tier 3 (5 min): Location bar
- * - Full refresh: 10 minutes (prevents ghosting)
+ * - Cleaning: per-zone ghosting budget (ghost-tracker.h); a zone over it
+ *   gets a full-waveform refresh of its own window, and whole-screen full
+ *   refreshes wait for an idle moment (or GHOST_FULL_MAX_MS at most)
+ *
+ * Each zone has its own deadline (zone-scheduler.h); the loop sleeps until
+ * the earliest, and zones due together or within ZONE_SCHED_MERGE_MS of it
+ * are fetched in one bundle request and drawn in one refresh. Where the
+ * server hints when a zone next changes (X-Zone-Next-Change), that zone
+ * is due then instead of a tier period later.
  * - LiveDash API: 20 seconds (server-side)
  * 
  * Copyright (c) 2026 Angus Bergman
@@ -17,26 +25,45 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
-#include <WiFiClientSecure.h>
 #include <WiFiManager.h>
 #include <Preferences.h>
 #include <ArduinoJson.h>
 #include <bb_epaper.h>
 #include "base64.hpp"
+#include "json-stream.h"
+#include "bmp-stream.h"
+#include "zone-codec.h"
+#include "refresh-planner.h"
+#include "ghost-tracker.h"
+#include "spi-dma.h"
+#include "panel-busy.h"
+#include "sleep-cycle.h"
+#include "idle-sleep.h"
+#include "zone-scheduler.h"
 #include "soc/soc.h"
 #include "soc/rtc_cntl_reg.h"
 #include "../include/config.h"
 
 #define SCREEN_W 800
 #define SCREEN_H 480
-#define MAX_ZONES 10
-#define ZONE_BMP_MAX_SIZE 20000
+#define MAX_ZONES ZONE_SCHED_MAX   // tiers 1 + 2 merged are 15 zones
 #define ZONE_ID_MAX_LEN 32
-#define ZONE_DATA_MAX_LEN 8000
+#define ZONE_READ_CHUNK 512
 // Override config.h version
 #undef FIRMWARE_VERSION
 #define FIRMWARE_VERSION "7.0-tiered"
 
+// Fetch tiers as binary /api/zones-bundle responses (raw BMPs, no base64/JSON);
+// falls back to /api/zones-tiered if the bundle request fails.
+// Either way each zone is decoded straight into the bb_epaper framebuffer
+// while it downloads; no response, JSON document or BMP is held in RAM.
+#ifndef TIERED_USE_BUNDLE
+#define TIERED_USE_BUNDLE 1
+#endif
+
+#include "../include/zone-connection.h"
+#include "../include/zone-bundle.h"
+
 // Default server
 #define DEFAULT_SERVER "https://einkptdashboard.vercel.app"
 #define PAIRING_POLL_INTERVAL 5000
@@ -56,20 +83,27 @@
 #define TIER1_INTERVAL TIER1_REFRESH_INTERVAL
 #define TIER2_INTERVAL TIER2_REFRESH_INTERVAL
 #define TIER3_INTERVAL TIER3_REFRESH_INTERVAL
-#define FULL_REFRESH_INTERVAL DEFAULT_FULL_REFRESH
 
 BBEPAPER bbep(EP75_800x480);
 Preferences preferences;
 char webhookUrl[256] = "";
 char pairingCode[8] = "";
 
-// Timing trackers per tier
-unsigned long lastTier1Refresh = 0;
-unsigned long lastTier2Refresh = 0;
-unsigned long lastTier3Refresh = 0;
+// Next refresh of every zone, learnt from each fetch
+ZoneScheduler schedule;
+unsigned long scheduleStart = 0;
+char zoneHints[ZONE_HINTS_MAX] = "";   // X-Zone-Next-Change of the last bundle
 unsigned long lastFullRefresh = 0;
 int partialRefreshCount = 0;
 
+// Zones of one fetch are refreshed as a single batch
+RefreshPlanner refreshPlan(SCREEN_W, SCREEN_H, millis);
+
+// Ghosting per zone id: localized cleans replace most full refreshes,
+// which are deferred until nobody has pressed the button for a while
+GhostTracker ghosts;
+unsigned long lastInteraction = 0;
+
 bool wifiConnected = false;
 bool devicePaired = false;
 bool initialDrawDone = false;
@@ -79,19 +113,20 @@ int consecutiveErrors = 0;
 const int MAX_BACKOFF_ERRORS = 5;
 unsigned long lastErrorTime = 0;
 
-// Zone storage
+// Zone storage (geometry only - pixels go straight to the framebuffer)
 struct Zone { 
     char id[ZONE_ID_MAX_LEN]; 
     int x, y, w, h;
     int tier;
     bool changed; 
-    char* data;
-    size_t dataLen;
+    bool drawn;         // new bitmap decoded into the framebuffer this fetch
+    int32_t toggled;    // pixels that bitmap flipped
 };
 Zone zones[MAX_ZONES];
 int zoneCount = 0;
-uint8_t* zoneBmpBuffer = nullptr;
-char* zoneDataBuffers[MAX_ZONES] = {nullptr};
+uint8_t zoneBand[BMP_STREAM_BAND_SIZE];
+ZoneImageDecoder zoneDecoder(zoneBand, sizeof(zoneBand));
+ZoneConnection zoneConn;
 
 // Function declarations
 void initDisplay();
@@ -102,31 +137,29 @@ void showErrorScreen(const char* error);
 void connectWiFi();
 void generatePairingCode();
 bool pollPairingServer();
-bool fetchZonesForTier(int tier, bool force);
+bool fetchDueZones(const ZoneSchedEntry* due, int n);
 bool fetchAllZones();
-bool decodeAndDrawZone(Zone& zone);
+bool fetchZonesBundle(const char* query);
+bool fetchZonesJson(const char* tierParam, int defaultTier, bool defaultChanged, bool force);
+void logHeap(const char* label);
 void doFullRefresh();
-void flashAndRefreshZone(Zone& zone);
+void cleanGhostedZone();
+int refreshFetchedZones();
+void scheduleFetchedZones(unsigned long now);
+uint32_t tierInterval(int tier);
 void loadSettings();
 void saveSettings();
 unsigned long getBackoffDelay();
-void initZoneBuffers();
+unsigned long nextZoneDeadline();
 String getBaseUrl();
 
 void setup() {
     WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 0);
     Serial.begin(115200); delay(500);
     Serial.println("\n=== Commute Compute v" FIRMWARE_VERSION " ===");
-    Serial.println("Tiered Refresh: T1=1min, T2=2min, T3=5min, Full=10min");
+    Serial.println("Tiered Refresh: T1=1min, T2=2min, T3=5min, Full=ghost budget");
     
     loadSettings();
-    
-    zoneBmpBuffer = (uint8_t*)malloc(ZONE_BMP_MAX_SIZE);
-    if (!zoneBmpBuffer) {
-        Serial.println("ERROR: Failed to allocate BMP buffer");
-    }
-    
-    initZoneBuffers();
     initDisplay();
     
     Serial.println("Setup complete");
@@ -185,6 +218,7 @@ void loop() {
     
     // Step 3: Tiered dashboard refresh
     unsigned long now = millis();
+    if (digitalRead(PIN_INTERRUPT) == LOW) lastInteraction = now;
     
     // Error backoff
     if (consecutiveErrors > 0) {
@@ -195,28 +229,20 @@ void loop() {
         }
     }
     
-    // Check if full refresh needed (every 10 min or after too many partials)
-    bool needsFull = !initialDrawDone || 
-                     (now - lastFullRefresh >= FULL_REFRESH_INTERVAL) || 
-                     (partialRefreshCount >= MAX_PARTIAL_BEFORE_FULL);
+    // Full refresh on first draw, or once ghosting debt is worth it and the
+    // device is idle (GhostTracker also forces one after GHOST_FULL_MAX_MS)
+    bool idle = now - lastInteraction >= GHOST_IDLE_MS;
+    bool needsFull = !initialDrawDone || ghosts.wholeDue(idle, now - lastFullRefresh);
     
     if (needsFull) {
         Serial.println("=== FULL REFRESH ===");
         if (fetchAllZones()) {
             consecutiveErrors = 0;
             
-            // Draw all zones
-            for (int i = 0; i < zoneCount; i++) {
-                if (zones[i].data) {
-                    decodeAndDrawZone(zones[i]);
-                }
-            }
-            
+            // Zones were decoded into the framebuffer during the fetch
             doFullRefresh();
             lastFullRefresh = now;
-            lastTier1Refresh = now;
-            lastTier2Refresh = now;
-            lastTier3Refresh = now;
+            scheduleFetchedZones(now);
             partialRefreshCount = 0;
             initialDrawDone = true;
             
@@ -230,67 +256,74 @@ void loop() {
         return;
     }
     
-    // Tier 1: Every 1 minute (time-critical)
-    if (now - lastTier1Refresh >= TIER1_INTERVAL) {
-        Serial.println("--- Tier 1 refresh (1 min) ---");
-        if (fetchZonesForTier(1, false)) {
+    // Every zone due now, and those due within the merge window: one
+    // request, one refresh. Rescheduled from `now` so the tiers stay in step.
+    ZoneSchedEntry due[ZONE_SCHED_MAX];
+    int dueCount = schedule.takeDue(now, due, ZONE_SCHED_MAX);
+    if (dueCount > 0) {
+        Serial.printf("--- %d zones due (%s%s) ---\n", dueCount, due[0].id, dueCount > 1 ? ", ..." : "");
+        if (fetchDueZones(due, dueCount)) {
             consecutiveErrors = 0;
-            int drawn = 0;
-            for (int i = 0; i < zoneCount; i++) {
-                if (zones[i].tier == 1 && zones[i].data) {
-                    flashAndRefreshZone(zones[i]);
-                    drawn++;
-                }
-            }
-            lastTier1Refresh = now;
-            Serial.printf("Tier 1: %d zones refreshed\n", drawn);
+            int drawn = refreshFetchedZones();
+            schedule.reschedule(due, dueCount, now);
+            scheduleFetchedZones(now);
+            Serial.printf("%d zones refreshed\n", drawn);
         } else {
             consecutiveErrors++;
             lastErrorTime = now;
+            schedule.retry(due, dueCount, now + getBackoffDelay());
         }
+        const ZoneSchedStats& st = schedule.stats();
+        unsigned long elapsed = millis() - scheduleStart;
+        Serial.printf("[Sched] %lu requests (%lu zones, %lu early), %.1f req/h, %.1f wakes/h\n",
+                      (unsigned long)st.batches, (unsigned long)st.zones, (unsigned long)st.early,
+                      ZoneScheduler::perHour(st.batches, elapsed),
+                      ZoneScheduler::perHour(idleSleep().stats().periods, elapsed));
     }
     
-    // Tier 2: Every 2 minutes (content, only if changed)
-    if (now - lastTier2Refresh >= TIER2_INTERVAL) {
-        Serial.println("--- Tier 2 refresh (2 min, if changed) ---");
-        if (fetchZonesForTier(2, false)) {
-            consecutiveErrors = 0;
-            int drawn = 0;
-            for (int i = 0; i < zoneCount; i++) {
-                if (zones[i].tier == 2 && zones[i].changed && zones[i].data) {
-                    flashAndRefreshZone(zones[i]);
-                    drawn++;
-                }
-            }
-            lastTier2Refresh = now;
-            Serial.printf("Tier 2: %d zones refreshed (changed only)\n", drawn);
-        } else {
-            consecutiveErrors++;
-            lastErrorTime = now;
-        }
+    cleanGhostedZone();
+
+    // Modem/light sleep until the earliest zone deadline. The button ends
+    // it early and brings every zone forward. Light sleep would drop a USB
+    // console, so only without a host.
+    bool pressed = idleSleep().idleUntil(nextZoneDeadline(), !usbPowered(),
+                                         []() { return WiFi.status() == WL_CONNECTED; });
+    if (pressed) {
+        lastInteraction = millis();
+        schedule.pullAllIn(lastInteraction);
     }
-    
-    // Tier 3: Every 5 minutes (static)
-    if (now - lastTier3Refresh >= TIER3_INTERVAL) {
-        Serial.println("--- Tier 3 refresh (5 min) ---");
-        if (fetchZonesForTier(3, false)) {
-            consecutiveErrors = 0;
-            int drawn = 0;
-            for (int i = 0; i < zoneCount; i++) {
-                if (zones[i].tier == 3 && zones[i].data) {
-                    flashAndRefreshZone(zones[i]);
-                    drawn++;
-                }
-            }
-            lastTier3Refresh = now;
-            Serial.printf("Tier 3: %d zones refreshed\n", drawn);
-        } else {
-            consecutiveErrors++;
-            lastErrorTime = now;
-        }
+    logIdleSleep();
+}
+
+/**
+ * When the earliest zone falls due (a tier-1 period out before the
+ * first fetch has filled the schedule)
+ */
+unsigned long nextZoneDeadline() {
+    if (schedule.empty()) return millis() + TIER1_INTERVAL;
+    return schedule.nextDue();
+}
+
+uint32_t tierInterval(int tier) {
+    switch (tier) {
+        case 2: return TIER2_INTERVAL;
+        case 3: return TIER3_INTERVAL;
+        default: return TIER1_INTERVAL;   // tier 1, or none given: keep it fresh
+    }
+}
+
+/**
+ * Put every zone of the last fetch on the schedule: due when the server
+ * says it next changes, else one tier period from `now`. New zones are
+ * added, known ones moved.
+ */
+void scheduleFetchedZones(unsigned long now) {
+    if (schedule.empty()) scheduleStart = now;
+    for (int i = 0; i < zoneCount; i++) {
+        uint32_t period = tierInterval(zones[i].tier);
+        uint32_t wait = nextChangeDelayMs(zoneHintSeconds(zoneHints, zones[i].id), period);
+        schedule.set(zones[i].id, period, now + wait);
     }
-    
-    delay(5000); // Check every 5 seconds
 }
 
 String getBaseUrl() {
@@ -302,94 +335,144 @@ String getBaseUrl() {
     return baseUrl;
 }
 
-bool fetchZonesForTier(int tier, bool force) {
+/**
+ * Fetch the zones in `due` as one bundle (ids=a,b,c). The JSON API only
+ * serves whole tiers, so its fallback fetches everything; all zones it
+ * returns are drawn and rescheduled.
+ */
+bool fetchDueZones(const ZoneSchedEntry* due, int n) {
     if (strlen(webhookUrl) == 0) return false;
-    
-    WiFiClientSecure* client = new WiFiClientSecure();
-    client->setInsecure();
-    HTTPClient http;
-    
-    String baseUrl = getBaseUrl();
-    String url = baseUrl + "/api/zones-tiered?tier=" + String(tier);
-    if (force) url += "&force=1";
-    
-    Serial.printf("Fetch tier %d: %s\n", tier, url.c_str());
-    http.setTimeout(30000);
-    
-    if (!http.begin(*client, url)) {
-        delete client;
-        return false;
+
+#if TIERED_USE_BUNDLE
+    char query[256] = "ids=";
+    size_t len = strlen(query);
+    for (int i = 0; i < n && len < sizeof(query); i++) {
+        len += snprintf(query + len, sizeof(query) - len, "%s%s", i ? "," : "", due[i].id);
     }
-    
-    http.addHeader("User-Agent", "CommuteCompute/" FIRMWARE_VERSION);
-    int code = http.GET();
-    
-    if (code != 200) {
-        Serial.printf("HTTP error: %d\n", code);
-        http.end();
-        delete client;
-        return false;
+    if (len < sizeof(query) && fetchZonesBundle(query)) return true;
+#endif
+
+    return fetchZonesJson("all", 0, false, false);
+}
+
+bool fetchAllZones() {
+    if (strlen(webhookUrl) == 0) return false;
+
+#if TIERED_USE_BUNDLE
+    if (fetchZonesBundle("tier=all")) return true;
+#endif
+
+    return fetchZonesJson("all", 0, true, false);
+}
+
+void logHeap(const char* label) {
+    Serial.printf("[Heap] %s: free %u, min free %u, largest block %u\n", label,
+                  ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+}
+
+/**
+ * Streaming handler for /api/zones-tiered:
+ *   {"tier":..,"zones":[{"id","x","y","w","h","tier","changed","data"}, ...]}
+ * The server sends "data" last, so each zone's geometry is known by the
+ * time its base64 BMP starts; that string is decoded chunk by chunk
+ * (JSON -> base64 -> BMP rows) into the framebuffer at x,y.
+ */
+class TieredZonesHandler : public JsonPathHandler {
+public:
+    TieredZonesHandler(int defaultTier, bool defaultChanged)
+        : defaultTier(defaultTier), defaultChanged(defaultChanged),
+          zone(nullptr), sink(nullptr, 0, 0, -1, -1) {}
+
+    void onEnter(const char* p, bool isArray) override {
+        if (isArray || strcmp(p, "zones[]") != 0 || zoneCount >= MAX_ZONES) return;
+        zone = &zones[zoneCount];
+        strcpy(zone->id, "unknown");
+        zone->x = zone->y = -1;
+        zone->w = zone->h = 0;
+        zone->tier = defaultTier;
+        zone->changed = defaultChanged;
+        zone->drawn = false;
+        zone->toggled = 0;
     }
-    
-    String payload = http.getString();
-    http.end();
-    delete client;
-    
-    JsonDocument doc;
-    if (deserializeJson(doc, payload)) {
-        Serial.println("JSON parse error");
-        return false;
+
+    void onLeave(const char* p, bool isArray) override {
+        if (isArray || !zone || strcmp(p, "zones[]") != 0) return;
+        zoneCount++;
+        zone = nullptr;
     }
-    
-    // Parse zones for this tier
-    zoneCount = 0;
-    JsonArray zonesArr = doc["zones"].as<JsonArray>();
-    
-    for (JsonObject z : zonesArr) {
-        if (zoneCount >= MAX_ZONES) break;
-        
-        Zone& zone = zones[zoneCount];
-        const char* id = z["id"] | "unknown";
-        strncpy(zone.id, id, ZONE_ID_MAX_LEN - 1);
-        
-        zone.x = z["x"] | 0;
-        zone.y = z["y"] | 0;
-        zone.w = z["w"] | 0;
-        zone.h = z["h"] | 0;
-        zone.tier = z["tier"] | tier;
-        zone.changed = z["changed"] | false;
-        
-        const char* data = z["data"] | (const char*)nullptr;
-        if (data && zoneDataBuffers[zoneCount]) {
-            size_t dataLen = strlen(data);
-            if (dataLen < ZONE_DATA_MAX_LEN) {
-                strcpy(zoneDataBuffers[zoneCount], data);
-                zone.data = zoneDataBuffers[zoneCount];
-                zone.dataLen = dataLen;
-            } else {
-                zone.data = nullptr;
-            }
-        } else {
-            zone.data = nullptr;
+
+    void onValue(const char* p, const char* v, bool isString) override {
+        if (!zone || strncmp(p, "zones[].", 8) != 0) return;
+        const char* key = p + 8;
+        if (strcmp(key, "id") == 0) {
+            strncpy(zone->id, v, ZONE_ID_MAX_LEN - 1);
+            zone->id[ZONE_ID_MAX_LEN - 1] = '\0';
+        } else if (strcmp(key, "x") == 0) zone->x = atoi(v);
+        else if (strcmp(key, "y") == 0) zone->y = atoi(v);
+        else if (strcmp(key, "w") == 0) zone->w = atoi(v);
+        else if (strcmp(key, "h") == 0) zone->h = atoi(v);
+        else if (strcmp(key, "tier") == 0) zone->tier = atoi(v);
+        else if (strcmp(key, "changed") == 0) zone->changed = strcmp(v, "true") == 0;
+    }
+
+    bool wantStreamPath(const char* p) override {
+        if (!zone || strcmp(p, "zones[].data") != 0) return false;
+        sink = FramebufferSink(bbep.getBuffer(), SCREEN_W / 8, SCREEN_H, zone->x, zone->y);
+        b64.reset();
+        zoneDecoder.reset(&sink);
+        bmpFailed = false;
+        return true;
+    }
+
+    void onStringData(const char* data, size_t len) override {
+        uint8_t out[(B64_CHUNK * 3) / 4 + 2];
+        while (len > 0 && !bmpFailed) {
+            size_t n = len < B64_CHUNK ? len : B64_CHUNK;
+            size_t dec = b64.decode(data, n, out);
+            if (dec && zoneDecoder.feed(out, dec) == BmpStreamDecoder::FAILED) bmpFailed = true;
+            data += n;
+            len -= n;
         }
-        
-        zoneCount++;
     }
-    
-    return true;
-}
 
-bool fetchAllZones() {
-    if (strlen(webhookUrl) == 0) return false;
-    
-    WiFiClientSecure* client = new WiFiClientSecure();
-    client->setInsecure();
+    void onStringEnd() override {
+        zone->drawn = !bmpFailed && zoneDecoder.done();
+        zone->toggled = sink.toggledPixels();
+        if (!zone->drawn && zone->x >= 0 && zone->y >= 0) {
+            // Never leave a half-decoded zone in the framebuffer
+            bbep.fillRect(zone->x, zone->y, zone->w, zone->h, BBEP_WHITE);
+        }
+    }
+
+private:
+    static const size_t B64_CHUNK = 256;
+
+    int defaultTier;
+    bool defaultChanged;
+    Zone* zone;
+    FramebufferSink sink;
+    Base64StreamDecoder b64;
+    bool bmpFailed;
+};
+
+/**
+ * Fetch /api/zones-tiered and decode every zone into the framebuffer as
+ * the response streams in. Beyond the TLS context this needs only a few
+ * hundred bytes of stack (an estimate; the [Heap] lines around the fetch
+ * give the measured figure); the previous getString() + JsonDocument path
+ * held the whole ~30-60 KB response twice.
+ */
+bool fetchZonesJson(const char* tierParam, int defaultTier, bool defaultChanged, bool force) {
+    zoneHints[0] = '\0';
+    TlsClient* client = new TlsClient();
     HTTPClient http;
     
     String baseUrl = getBaseUrl();
-    String url = baseUrl + "/api/zones-tiered?tier=all";
+    String url = baseUrl + "/api/zones-tiered?tier=" + tierParam;
+    if (force) url += "&force=1";
     
-    Serial.printf("Fetch all: %s\n", url.c_str());
+    Serial.printf("Fetch tier %s: %s\n", tierParam, url.c_str());
+    logHeap("before fetch");
     http.setTimeout(30000);
     
     if (!http.begin(*client, url)) {
@@ -407,51 +490,102 @@ bool fetchAllZones() {
         return false;
     }
     
-    String payload = http.getString();
+    zoneCount = 0;
+    TieredZonesHandler handler(defaultTier, defaultChanged);
+    JsonStreamParser parser(&handler);
+    JsonStreamWriter writer(parser);
+    int written = http.writeToStream(&writer);
     http.end();
     delete client;
+    logHeap("after fetch");
     
-    JsonDocument doc;
-    if (deserializeJson(doc, payload)) {
-        Serial.println("JSON parse error");
+    if (written < 0 || !writer.ok()) {
+        Serial.printf("Zone stream error: %d\n", written);
         return false;
     }
     
-    zoneCount = 0;
-    JsonArray zonesArr = doc["zones"].as<JsonArray>();
-    
-    for (JsonObject z : zonesArr) {
-        if (zoneCount >= MAX_ZONES) break;
-        
-        Zone& zone = zones[zoneCount];
-        const char* id = z["id"] | "unknown";
-        strncpy(zone.id, id, ZONE_ID_MAX_LEN - 1);
-        
-        zone.x = z["x"] | 0;
-        zone.y = z["y"] | 0;
-        zone.w = z["w"] | 0;
-        zone.h = z["h"] | 0;
-        zone.tier = z["tier"] | 0;
-        zone.changed = z["changed"] | true;
-        
-        const char* data = z["data"] | (const char*)nullptr;
-        if (data && zoneDataBuffers[zoneCount]) {
-            size_t dataLen = strlen(data);
-            if (dataLen < ZONE_DATA_MAX_LEN) {
-                strcpy(zoneDataBuffers[zoneCount], data);
-                zone.data = zoneDataBuffers[zoneCount];
-                zone.dataLen = dataLen;
+    return true;
+}
+
+/**
+ * Fetch zones as one binary bundle (`query`: tier=N or ids=a,b,c). Each
+ * zone's BMP is streamed straight into the framebuffer, so no JSON
+ * document, base64 text or BMP is held.
+ */
+bool fetchZonesBundle(const char* query) {
+    if (!zoneConn.begin(getBaseUrl().c_str())) return false;
+    zoneConn.setDefaultHeaders(ZONE_CODEC_HEADER);
+
+    zoneConn.beginCycle();
+    logHeap("before bundle");
+    bool ok = false;
+    zoneHints[0] = '\0';
+
+    if (zoneConn.open()) {
+        char path[288];
+        snprintf(path, sizeof(path), "/api/zones-bundle?%s", query);
+        Serial.printf("Fetch bundle: %s\n", query);
+
+        ZoneResponse resp;
+        if (zoneConn.sendGet(path) && zoneConn.readResponse(resp)) {
+            strcpy(zoneHints, resp.zoneHints);
+            if (resp.status != 200) {
+                Serial.printf("Bundle HTTP error: %d\n", resp.status);
             } else {
-                zone.data = nullptr;
+                ZoneBundleReader bundle(zoneConn);
+                if (bundle.begin() >= 0) {
+                    zoneCount = 0;
+                    ok = true;
+                    ZoneFrame frame;
+                    while (zoneCount < MAX_ZONES && bundle.next(frame)) {
+                        Zone& zone = zones[zoneCount];
+                        strncpy(zone.id, frame.id, ZONE_ID_MAX_LEN - 1);
+                        zone.id[ZONE_ID_MAX_LEN - 1] = '\0';
+                        zone.x = frame.x;
+                        zone.y = frame.y;
+                        zone.w = frame.w;
+                        zone.h = frame.h;
+                        zone.tier = zoneBundleTier(frame.flags);
+                        zone.changed = frame.flags & ZONE_BUNDLE_FLAG_CHANGED;
+                        zone.drawn = false;
+                        zone.toggled = 0;
+
+                        if (frame.length > 0) {
+                            FramebufferSink sink(bbep.getBuffer(), SCREEN_W / 8, SCREEN_H, zone.x, zone.y);
+                            zoneDecoder.reset(&sink);
+                            uint8_t chunk[ZONE_READ_CHUNK];
+                            BmpStreamDecoder::Result r = BmpStreamDecoder::NEED_MORE;
+                            int n;
+                            while ((n = bundle.read(chunk, sizeof(chunk))) > 0) {
+                                if (r == BmpStreamDecoder::NEED_MORE) r = zoneDecoder.feed(chunk, n);
+                            }
+                            if (n < 0) {
+                                ok = false;
+                                break;
+                            }
+                            zone.drawn = r == BmpStreamDecoder::DONE;
+                            zone.toggled = sink.toggledPixels();
+                            if (!zone.drawn) bbep.fillRect(zone.x, zone.y, zone.w, zone.h, BBEP_WHITE);
+                        }
+                        zoneCount++;
+                    }
+                    // next() also stops on a read error: every announced
+                    // frame must have arrived, or the rest were never drawn
+                    if (ok && !bundle.atEnd()) {
+                        Serial.printf("Bundle incomplete: %d of %d zones\n", zoneCount, bundle.zoneCount());
+                        ok = false;
+                    }
+                    ok = ok && zoneCount > 0;
+                }
             }
-        } else {
-            zone.data = nullptr;
         }
-        
-        zoneCount++;
     }
-    
-    return true;
+
+    // Free the TLS context before any panel refresh (Incident #5)
+    zoneConn.close();
+    zoneConn.endCycle();
+    logHeap("after bundle");
+    return ok;
 }
 
 // === PAIRING AND WIFI (unchanged) ===
@@ -499,13 +633,12 @@ void showPairingScreen() {
     bbep.setCursor(200, 420); bbep.print("Waiting for setup to complete...");
     bbep.setCursor(250, 450); bbep.print("(c) 2026 Angus Bergman");
     
-    bbep.refresh(REFRESH_FULL, true);
+    panelRefresh(&bbep, REFRESH_FULL);
     lastFullRefresh = millis();
 }
 
 bool pollPairingServer() {
-    WiFiClientSecure* client = new WiFiClientSecure();
-    client->setInsecure();
+    TlsClient* client = new TlsClient();
     HTTPClient http;
     
     String url = String(DEFAULT_SERVER) + "/api/pair/" + String(pairingCode);
@@ -558,7 +691,7 @@ void showConnectingScreen() {
     bbep.setCursor(280, 200); bbep.print("CONNECTING TO WIFI...");
     bbep.setCursor(200, 250); bbep.print("Network: Connect to CC-Setup");
     
-    bbep.refresh(REFRESH_FULL, true);
+    panelRefresh(&bbep, REFRESH_FULL);
 }
 
 void showPairedScreen() {
@@ -574,7 +707,7 @@ void showPairedScreen() {
     bbep.setCursor(320, 180); bbep.print("PAIRED!");
     bbep.setCursor(220, 240); bbep.print("Loading your dashboard...");
     
-    bbep.refresh(REFRESH_FULL, true);
+    panelRefresh(&bbep, REFRESH_FULL);
 }
 
 void showErrorScreen(const char* error) {
@@ -584,7 +717,7 @@ void showErrorScreen(const char* error) {
     bbep.setCursor(350, 200); bbep.print("ERROR");
     bbep.setCursor(150, 240); bbep.print(error);
     bbep.setCursor(280, 300); bbep.print("Retrying...");
-    bbep.refresh(REFRESH_FULL, true);
+    panelRefresh(&bbep, REFRESH_FULL);
 }
 
 void loadSettings() {
@@ -618,19 +751,17 @@ void connectWiFi() {
 }
 
 void initDisplay() {
-    bbep.initIO(EPD_DC_PIN, EPD_RST_PIN, EPD_BUSY_PIN, EPD_CS_PIN, EPD_MOSI_PIN, EPD_SCK_PIN, 8000000);
+    // Fastest clock the panel reads back reliably, then DMA plane transfers
+    uint32_t spiHz = calibratePanelSpi(EPD_SCK_PIN, EPD_MOSI_PIN, EPD_CS_PIN, EPD_DC_PIN, EPD_RST_PIN, EPD_BUSY_PIN);
+    bbep.initIO(EPD_DC_PIN, EPD_RST_PIN, EPD_BUSY_PIN, EPD_CS_PIN, EPD_MOSI_PIN, EPD_SCK_PIN, spiHz);
+    bool dma = installPanelDataWriter(&bbep, spiHz, EPD_SCK_PIN, EPD_MOSI_PIN, EPD_CS_PIN, EPD_DC_PIN);
+    Serial.printf("[Display] SPI %lu kHz, %s transfers\n", (unsigned long)(spiHz / 1000), dma ? "DMA" : "CPU");
+    panelBusy().begin(EPD_BUSY_PIN);
     bbep.setPanelType(EP75_800x480);
     bbep.setRotation(0);
     bbep.allocBuffer(false);
     pinMode(PIN_INTERRUPT, INPUT_PULLUP);
-}
-
-void initZoneBuffers() {
-    for (int i = 0; i < MAX_ZONES; i++) {
-        zoneDataBuffers[i] = (char*)malloc(ZONE_DATA_MAX_LEN);
-        zones[i].data = nullptr;
-        zones[i].id[0] = '\0';
-    }
+    idleSleep().begin(PIN_INTERRUPT);   // the button also ends idle waits
 }
 
 unsigned long getBackoffDelay() {
@@ -638,36 +769,49 @@ unsigned long getBackoffDelay() {
     return (1UL << capped) * 1000UL;
 }
 
-bool decodeAndDrawZone(Zone& zone) {
-    if (!zone.data || !zoneBmpBuffer) return false;
-    
-    size_t len = strlen(zone.data);
-    size_t dec = decode_base64_length((unsigned char*)zone.data, len);
-    
-    if (dec > ZONE_BMP_MAX_SIZE) return false;
-    
-    decode_base64((unsigned char*)zone.data, len, zoneBmpBuffer);
-    
-    if (zoneBmpBuffer[0] != 'B' || zoneBmpBuffer[1] != 'M') return false;
-    
-    int result = bbep.loadBMP(zoneBmpBuffer, zone.x, zone.y, BBEP_BLACK, BBEP_WHITE);
-    return result == BBEP_SUCCESS;
+void doFullRefresh() {
+    panelRefresh(&bbep, REFRESH_FULL);
+    syncPanelOldPlane(&bbep);   // differential partials start from this image
+    ghosts.reset();
 }
 
-void doFullRefresh() {
-    bbep.refresh(REFRESH_FULL, true);
+/**
+ * Full-waveform refresh of the zone most over its ghosting budget, in its
+ * own window (pushed from the framebuffer). One per loop pass.
+ */
+void cleanGhostedZone() {
+    const GhostZone* z = ghosts.zoneToClean();
+    if (!z) return;
+    PanelWindow win = alignPanelWindow(z->x, z->y, z->w, z->h, SCREEN_W, SCREEN_H);
+    Serial.printf("Cleaning zone %s after %u updates\n", z->id, (unsigned)z->updates);
+    refreshPanelWindow(&bbep, win, REFRESH_FULL);
+    ghosts.noteCleaned(z->id);
 }
 
-void flashAndRefreshZone(Zone& zone) {
-    // Flash to clear ghosting
-    bbep.fillRect(zone.x, zone.y, zone.w, zone.h, BBEP_BLACK);
-    bbep.refresh(REFRESH_PARTIAL, true);
-    delay(150);
-    
-    if (!decodeAndDrawZone(zone)) {
-        bbep.fillRect(zone.x, zone.y, zone.w, zone.h, BBEP_WHITE);
+/**
+ * Refresh every zone decoded this fetch as one plan; tier-2 zones only if
+ * changed. Each window is a differential update (old plane -> new plane),
+ * so a zone needs one refresh and no flash to black.
+ */
+int refreshFetchedZones() {
+    int batched = 0;
+    for (int i = 0; i < zoneCount; i++) {
+        Zone& z = zones[i];
+        if (!z.drawn || (z.tier == 2 && !z.changed)) continue;
+        refreshPlan.add(z.x, z.y, z.w, z.h);
+        ghosts.noteUpdate(z.id, z.x, z.y, z.w, z.h, z.toggled);
+        batched++;
     }
-    
-    bbep.refresh(REFRESH_PARTIAL, true);
+    if (batched == 0) return 0;
+    PanelDataWriter* spi = panelDataWriter();
+    if (spi) spi->resetStats();
+    refreshPlan.execute(&bbep, REFRESH_PARTIAL, REFRESH_PARTIAL);
     partialRefreshCount++;
+    Serial.printf("Refresh: panel busy %lu ms\n", (unsigned long)refreshPlan.busyMs());
+    if (spi) Serial.printf("Refresh: %lu B plane data, CPU blocked %lu us\n",
+                           (unsigned long)spi->bytes, (unsigned long)spi->cpuUs);
+    const PanelBusyStats& busy = panelBusy().stats(REFRESH_PARTIAL);
+    Serial.printf("Refresh: partial BUSY avg %lu ms, max %lu ms over %lu\n",
+                  (unsigned long)busy.avgMs(), (unsigned long)busy.maxMs, (unsigned long)busy.count);
+    return batched;
 }
@@ -15,7 +15,6 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
-#include <WiFiClientSecure.h>
 #include <WiFiManager.h>
 #include <Preferences.h>
 #include <bb_epaper.h>
@@ -24,6 +23,9 @@
 #include "soc/rtc_cntl_reg.h"
 #include "esp_task_wdt.h"
 #include "../include/config.h"
+#include "../include/tls-session.h"
+#include "../include/bmp-stream.h"
+#include "../include/blit-1bpp.h"
 #include "../include/cc-logo-draw.h"
 // Note: prerendered-screens.h removed - too large, causes crash
 
@@ -34,7 +36,6 @@
 #define FIRMWARE_VERSION "6.2.3"
 #define SCREEN_W 800
 #define SCREEN_H 480
-#define ZONE_BUFFER_SIZE 40000  // Needs to fit legs zone (~32KB)
 #define WDT_TIMEOUT_SEC 45
 
 // Timing (milliseconds)
@@ -114,8 +115,9 @@ int consecutiveErrors = 0;
 unsigned long lastErrorTime = 0;
 const int MAX_BACKOFF_ERRORS = 5;
 
-// Zone data
-uint8_t* zoneBuffer = nullptr;
+// Zone data (decoded as it streams in - one row band, no whole-zone buffer)
+uint8_t zoneBand[BMP_STREAM_BAND_SIZE];
+BmpStreamDecoder zoneDecoder(zoneBand, sizeof(zoneBand));
 bool zoneChanged[ZONE_COUNT] = {false};
 
 // WiFiManager
@@ -180,15 +182,6 @@ void setup() {
         saveSettings();
     }
     
-    // Allocate zone buffer
-    zoneBuffer = (uint8_t*)malloc(ZONE_BUFFER_SIZE);
-    if (!zoneBuffer) {
-        Serial.println("✗ FATAL: Failed to allocate zone buffer");
-        currentState = STATE_ERROR;
-    } else {
-        Serial.printf("✓ Zone buffer allocated: %d bytes\n", ZONE_BUFFER_SIZE);
-    }
-    
     // Initialize display (quick, non-blocking)
     initDisplay();
     
@@ -543,23 +536,10 @@ void initDisplay() {
 // Display pre-rendered screen from PROGMEM (1-bit packed, 1=black)
 // ============================================================================
 void displayPrerenderedScreen(const uint8_t* data, int width, int height) {
-    bbep.fillScreen(BBEP_WHITE);
-    
-    int bytes_per_row = (width + 7) / 8;
+    if (width < 800 || height < 480) bbep.fillScreen(BBEP_WHITE);
     
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int byte_idx = y * bytes_per_row + (x / 8);
-            int bit_idx = 7 - (x % 8);  // MSB first
-            
-            uint8_t byte_val = pgm_read_byte(&data[byte_idx]);
-            
-            if (byte_val & (1 << bit_idx)) {
-                // Draw black pixel where bit=1
-                bbep.drawPixel(x, y, BBEP_BLACK);
-            }
-        }
-    }
+    // PROGMEM is memory-mapped on the ESP32, so the blitter reads it directly
+    blit1bppToDisplay(&bbep, 0, 0, data, (width + 7) / 8, width, height, BLIT_INVERT);
     
     bbep.refresh(REFRESH_FULL, true);
     lastFullRefresh = millis();
@@ -575,7 +555,6 @@ void showBootScreen() {
     bbep.setTextColor(BBEP_BLACK, BBEP_WHITE);
     
     // Draw CC logo (150x150) centered
-    // Note: drawCCLogoCentered draws 22,500 pixels which is acceptable
     drawCCLogoCentered(140, 800);
     
     // "COMMUTE COMPUTE" text below logo
@@ -761,8 +740,7 @@ bool registerForPairing() {
         strcpy(serverUrl, DEFAULT_SERVER_URL);
     }
     
-    WiFiClientSecure client;
-    client.setInsecure();
+    TlsClient client;
     HTTPClient http;
     
     String url = String(serverUrl) + "/api/pair/register";
@@ -806,8 +784,7 @@ bool registerForPairing() {
 bool pollPairingStatus() {
     if (strlen(pairingCode) == 0) return false;
     
-    WiFiClientSecure client;
-    client.setInsecure();
+    TlsClient client;
     HTTPClient http;
     
     String url = String(serverUrl) + "/api/pair/" + pairingCode;
@@ -852,17 +829,7 @@ void showPairingScreen() {
     // Draw logo with inverted colors (logo data has 1=black)
     int logoX = (800 - CC_LOGO_WIDTH) / 2;  // Center: 325
     int logoY = 15;
-    for (int row = 0; row < CC_LOGO_HEIGHT; row++) {
-        for (int col = 0; col < CC_LOGO_WIDTH; col++) {
-            int byte_idx = row * CC_LOGO_BYTES_PER_ROW + (col / 8);
-            int bit_idx = 7 - (col % 8);
-            uint8_t byte_val = pgm_read_byte(&CC_LOGO_DATA[byte_idx]);
-            if (byte_val & (1 << bit_idx)) {
-                // Draw black where bit=1 (logo inverted: 1=black)
-                bbep.drawPixel(logoX + col, logoY + row, BBEP_BLACK);
-            }
-        }
-    }
+    drawCCLogo(logoX, logoY);
     
     // ========== TITLE (below logo at y=165) ==========
     bbep.setCursor(310, 165);
@@ -1069,12 +1036,11 @@ bool fetchZoneList(bool forceAll) {
     
     // Quick connectivity check via lightweight metadata endpoint
     {
-        WiFiClientSecure* client = new WiFiClientSecure();
+        TlsClient* client = new TlsClient();
         if (!client) {
             Serial.println("✗ Failed to create client");
             return false;
         }
-        client->setInsecure();
         
         HTTPClient http;
         
@@ -1132,9 +1098,8 @@ bool fetchAndDrawZone(const ZoneDef& zone, bool flash) {
     
     // Isolated scope for HTTP client
     {
-        WiFiClientSecure* client = new WiFiClientSecure();
+        TlsClient* client = new TlsClient();
         if (!client) return false;
-        client->setInsecure();
         
         HTTPClient http;
         
@@ -1176,53 +1141,28 @@ bool fetchAndDrawZone(const ZoneDef& zone, bool flash) {
         int zW = http.hasHeader("X-Zone-Width") ? http.header("X-Zone-Width").toInt() : zone.w;
         int zH = http.hasHeader("X-Zone-Height") ? http.header("X-Zone-Height").toInt() : zone.h;
         
-        int contentLen = http.getSize();
-        
-        if (contentLen <= 0 || contentLen > ZONE_BUFFER_SIZE) {
-            Serial.printf("✗ Zone '%s' size invalid: %d\n", zone.id, contentLen);
-            http.end();
-            delete client;
-            return false;
+        // Flash zone (black) before drawing new content. This now happens
+        // before the body is read because rows go straight to the panel.
+        if (flash) {
+            bbep.fillRect(zX, zY, zW, zH, BBEP_BLACK);
+            bbep.refresh(REFRESH_PARTIAL, true);
+            delay(50);
         }
         
-        // Stream BMP data
-        WiFiClient* stream = http.getStreamPtr();
-        int bytesRead = 0;
-        unsigned long timeout = millis() + 15000;
+        feedWatchdog();
         
-        while (bytesRead < contentLen && millis() < timeout) {
-            feedWatchdog();
-            
-            if (stream->available()) {
-                int toRead = min((int)stream->available(), contentLen - bytesRead);
-                int r = stream->readBytes(zoneBuffer + bytesRead, toRead);
-                bytesRead += r;
-            }
-            yield();
-        }
+        // Stream BMP rows into panel RAM (Content-Length or chunked)
+        PanelWindowSink<BBEPAPER> sink(&bbep, zX, zY, PLANE_0);
+        zoneDecoder.reset(&sink);
+        BmpStreamWriter writer(zoneDecoder);
+        int bytesRead = http.writeToStream(&writer);
         
         http.end();
         delete client;
         client = nullptr;
         
-        // Validate BMP header
-        if (bytesRead != contentLen || zoneBuffer[0] != 'B' || zoneBuffer[1] != 'M') {
-            Serial.printf("✗ Zone '%s' invalid BMP (got %d/%d bytes)\n", zone.id, bytesRead, contentLen);
-            return false;
-        }
-        
-        // Flash zone (black) before drawing new content
-        if (flash) {
-            bbep.fillRect(zX, zY, zW, zH, BBEP_BLACK);
-            bbep.refresh(REFRESH_PARTIAL, true);
-            delay(50);
-        }
-        
-        // Draw BMP
-        int result = bbep.loadBMP(zoneBuffer, zX, zY, BBEP_BLACK, BBEP_WHITE);
-        
-        if (result != BBEP_SUCCESS) {
-            Serial.printf("✗ Zone '%s' loadBMP failed: %d\n", zone.id, result);
+        if (bytesRead < 0 || !writer.ok()) {
+            Serial.printf("✗ Zone '%s' invalid BMP (%d)\n", zone.id, bytesRead);
             return false;
         }
         
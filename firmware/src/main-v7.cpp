@@ -23,11 +23,15 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
-#include <WiFiClientSecure.h>
 #include <Preferences.h>
 #include <bb_epaper.h>
 #include <WiFiManager.h>
 #include "soc/rtc_cntl_reg.h"
+#include "../include/tls-session.h"
+#include "../include/bmp-stream.h"
+#include "../include/panel-window.h"
+#include "../include/panel-busy.h"
+#include "../include/next-change.h"
 
 // ============================================================================
 // VERSION & CONFIG
@@ -35,11 +39,8 @@
 
 #define FIRMWARE_VERSION "7.0.2"
 
-// Buffer size - must be >= 40KB for legs zone (31KB)
-#define ZONE_BUFFER_SIZE 45000
-
 // Timing (per DEVELOPMENT-RULES.md Section 19)
-#define PARTIAL_REFRESH_MS 20000      // 20 seconds
+#define PARTIAL_REFRESH_MS 20000      // 20 seconds, when the server gives no X-Next-Change
 #define FULL_REFRESH_MS    600000     // 10 minutes
 #define HTTP_TIMEOUT_MS    15000      // 15 seconds
 #define WIFI_TIMEOUT_MS    30000      // 30 seconds
@@ -103,12 +104,19 @@ char serverUrl[128] = "";
 bool wifiConnected = false;
 bool initialDrawDone = false;
 
-// Buffers
-uint8_t* zoneBuffer = nullptr;
+// Zone BMPs are decoded as they stream in (one row band, no whole-zone buffer)
+uint8_t zoneBand[BMP_STREAM_BAND_SIZE];
+BmpStreamDecoder zoneDecoder(zoneBand, sizeof(zoneBand));
 bool zoneChanged[ZONE_COUNT] = {true, true, true, true};
 
+// Pipelined partial cycle: zone N refreshes while zone N+1 downloads. The
+// next body is held here (two bands) until the panel is free again.
+uint8_t zoneSpill[2 * BMP_STREAM_BAND_SIZE];
+
 // Timing
 unsigned long lastRefresh = 0;
+uint32_t refreshIntervalMs = PARTIAL_REFRESH_MS;   // until the zones next change
+int32_t cycleNextChangeS = -1;                     // earliest hint this cycle
 unsigned long lastFullRefresh = 0;
 int partialRefreshCount = 0;
 
@@ -125,7 +133,7 @@ void loadSettings();
 void saveSettings();
 bool fetchAndDrawZone(const ZoneDef& zone, bool partial);
 void doFullRefresh();
-void doPartialRefresh();
+void startZoneRefresh(const ZoneDef& zone);
 unsigned long getBackoffDelay();
 
 // ============================================================================
@@ -158,15 +166,6 @@ void setup() {
     }
     Serial.printf("✓ Server URL: %s\n", serverUrl);
     
-    // Allocate zone buffer
-    zoneBuffer = (uint8_t*)malloc(ZONE_BUFFER_SIZE);
-    if (!zoneBuffer) {
-        Serial.println("✗ FATAL: Failed to allocate zone buffer");
-        // Continue anyway - will fail gracefully on fetch
-    } else {
-        Serial.printf("✓ Zone buffer allocated: %d bytes\n", ZONE_BUFFER_SIZE);
-    }
-    
     // Initialize display - per Section 5.4
     // DO NOT call allocBuffer() - causes crash on ESP32-C3
     Serial.println("→ Init display...");
@@ -174,6 +173,7 @@ void setup() {
                 EPD_MOSI_PIN, EPD_SCK_PIN, 8000000);
     bbep.setPanelType(EP75_800x480);
     bbep.setRotation(0);
+    panelBusy().begin(EPD_BUSY_PIN);
     pinMode(PIN_INTERRUPT, INPUT_PULLUP);
     delay(100);  // Let display settle
     Serial.println("✓ Display initialized");
@@ -256,7 +256,7 @@ void loop() {
             
             // Check if refresh needed
             bool needsRefresh = !initialDrawDone || 
-                               (now - lastRefresh >= PARTIAL_REFRESH_MS);
+                               (now - lastRefresh >= refreshIntervalMs);
             
             if (!needsRefresh) {
                 currentState = STATE_IDLE;
@@ -270,20 +270,24 @@ void loop() {
             
             Serial.printf("→ Fetching zones (full=%s)\n", needsFull ? "yes" : "no");
             
-            // Fetch and render each zone
+            // Fetch and render each zone. On a partial cycle each zone's
+            // refresh starts as soon as it is in panel RAM and runs while
+            // the next zone downloads: cycle ~ max(network, panel).
             int drawn = 0;
             bool anyFailed = false;
+            unsigned long cycleStart = millis();
+            unsigned long networkMs = 0;
+            uint32_t panelMsBefore = panelBusy().stats(REFRESH_PARTIAL).totalMs;
+            cycleNextChangeS = -1;
             
             for (int i = 0; i < ZONE_COUNT; i++) {
-                if (fetchAndDrawZone(ZONES[i], !needsFull)) {
+                unsigned long t0 = millis();
+                bool ok = fetchAndDrawZone(ZONES[i], !needsFull);
+                networkMs += millis() - t0;
+                if (ok) {
                     drawn++;
                     zoneChanged[i] = false;
-                    
-                    // Partial refresh per zone (unless doing full)
-                    if (!needsFull) {
-                        doPartialRefresh();
-                        delay(50);  // Brief settle time
-                    }
+                    if (!needsFull) startZoneRefresh(ZONES[i]);
                 } else {
                     anyFailed = true;
                 }
@@ -298,14 +302,20 @@ void loop() {
                 partialRefreshCount = 0;
                 initialDrawDone = true;
             } else if (drawn > 0 && !needsFull) {
+                endPanelWindowRefresh(&bbep);
                 partialRefreshCount++;
+                unsigned long cycleMs = millis() - cycleStart;
+                unsigned long panelMs = panelBusy().stats(REFRESH_PARTIAL).totalMs - panelMsBefore;
+                Serial.printf("→ Cycle %lu ms (network %lu ms, panel %lu ms)\n", cycleMs, networkMs, panelMs);
             }
             
             // Update state
             if (drawn > 0) {
                 consecutiveErrors = 0;
                 lastRefresh = now;
-                Serial.printf("✓ Rendered %d/%d zones\n", drawn, ZONE_COUNT);
+                refreshIntervalMs = nextChangeDelayMs(cycleNextChangeS, PARTIAL_REFRESH_MS);
+                Serial.printf("✓ Rendered %d/%d zones, next in %lu s\n", drawn, ZONE_COUNT,
+                              (unsigned long)(refreshIntervalMs / 1000));
             } else {
                 consecutiveErrors++;
                 lastErrorTime = now;
@@ -322,7 +332,7 @@ void loop() {
             delay(1000);
             
             // Check if refresh needed
-            if (now - lastRefresh >= PARTIAL_REFRESH_MS || !initialDrawDone) {
+            if (now - lastRefresh >= refreshIntervalMs || !initialDrawDone) {
                 currentState = STATE_FETCH_ZONES;
             }
             break;
@@ -376,7 +386,6 @@ void saveSettings() {
 // ============================================================================
 
 bool fetchAndDrawZone(const ZoneDef& zone, bool partial) {
-    if (!zoneBuffer) return false;
     
     // Build URL
     String url = String(serverUrl);
@@ -388,12 +397,11 @@ bool fetchAndDrawZone(const ZoneDef& zone, bool partial) {
     Serial.printf("  → Fetching %s...\n", zone.id);
     
     // Create HTTPS client
-    WiFiClientSecure* client = new WiFiClientSecure();
+    TlsClient* client = new TlsClient();
     if (!client) {
         Serial.println("  ✗ Failed to create client");
         return false;
     }
-    client->setInsecure();  // Skip cert verification for now
     
     HTTPClient http;
     http.setTimeout(HTTP_TIMEOUT_MS);
@@ -405,6 +413,8 @@ bool fetchAndDrawZone(const ZoneDef& zone, bool partial) {
     }
     
     http.addHeader("User-Agent", "CCFirmTRMNL/" FIRMWARE_VERSION);
+    static const char* hintHeaders[] = { "X-Next-Change" };
+    http.collectHeaders(hintHeaders, 1);
     
     int httpCode = http.GET();
     
@@ -414,90 +424,31 @@ bool fetchAndDrawZone(const ZoneDef& zone, bool partial) {
         delete client;
         return false;
     }
-    
-    // Get response size
-    int contentLength = http.getSize();
-    if (contentLength <= 0 || contentLength > ZONE_BUFFER_SIZE) {
-        Serial.printf("  ✗ Invalid size: %d\n", contentLength);
-        http.end();
-        delete client;
-        return false;
+    if (http.hasHeader("X-Next-Change")) {
+        cycleNextChangeS = nextChangeEarliest(cycleNextChangeS, http.header("X-Next-Change").toInt());
     }
     
-    // Read BMP data into buffer
-    WiFiClient* stream = http.getStreamPtr();
-    int bytesRead = 0;
-    
-    while (bytesRead < contentLength && stream->available()) {
-        int chunk = stream->readBytes(zoneBuffer + bytesRead, 
-                                      min(1024, contentLength - bytesRead));
-        bytesRead += chunk;
-        yield();
-    }
+    // Decode rows straight into panel RAM as they arrive. writeToStream()
+    // handles both Content-Length and chunked bodies. While the previous
+    // zone is still refreshing, the first bands wait in zoneSpill.
+    PanelWindowSink<BBEPAPER> sink(&bbep, zone.x, zone.y, PLANE_0);
+    zoneDecoder.reset(&sink);
+    GatedBmpWriter writer(zoneDecoder, zoneSpill, sizeof(zoneSpill),
+                          []() { return panelBusy().pending() && !panelBusy().poll(); },
+                          []() { finishPanelRefresh(); });
+    int bytesRead = http.writeToStream(&writer);
+    writer.finish();
     
     http.end();
     delete client;
     
-    if (bytesRead != contentLength) {
-        Serial.printf("  ✗ Incomplete read: %d/%d\n", bytesRead, contentLength);
-        return false;
-    }
-    
-    Serial.printf("  ✓ %s: %d bytes\n", zone.id, bytesRead);
-    
-    // Parse BMP header and draw to display
-    // BMP header: 14 bytes file header + 40 bytes DIB header
-    if (bytesRead < 54) {
-        Serial.println("  ✗ BMP too small");
-        return false;
-    }
-    
-    // Verify BMP magic
-    if (zoneBuffer[0] != 'B' || zoneBuffer[1] != 'M') {
-        Serial.println("  ✗ Not a BMP file");
-        return false;
-    }
-    
-    // Get pixel data offset
-    uint32_t pixelOffset = *(uint32_t*)(zoneBuffer + 10);
-    
-    // Get dimensions from DIB header
-    int32_t bmpWidth = *(int32_t*)(zoneBuffer + 18);
-    int32_t bmpHeight = *(int32_t*)(zoneBuffer + 22);
-    uint16_t bitsPerPixel = *(uint16_t*)(zoneBuffer + 28);
-    
-    // Height is positive for bottom-up (per Appendix D.2)
-    bool bottomUp = bmpHeight > 0;
-    if (bmpHeight < 0) bmpHeight = -bmpHeight;
-    
-    // Verify 1-bit
-    if (bitsPerPixel != 1) {
-        Serial.printf("  ✗ Not 1-bit BMP: %d bpp\n", bitsPerPixel);
+    if (bytesRead < 0 || !writer.ok()) {
+        Serial.printf("  ✗ %s: bad or incomplete BMP (%d)\n", zone.id, bytesRead);
         return false;
     }
     
-    // Row stride (padded to 4 bytes)
-    int rowBytes = ((bmpWidth + 31) / 32) * 4;
-    
-    // Draw pixels to display
-    uint8_t* pixels = zoneBuffer + pixelOffset;
-    
-    for (int row = 0; row < bmpHeight && row < zone.h; row++) {
-        // Source row (bottom-up means row 0 is at bottom)
-        int srcRow = bottomUp ? (bmpHeight - 1 - row) : row;
-        uint8_t* rowData = pixels + (srcRow * rowBytes);
-        
-        for (int col = 0; col < bmpWidth && col < zone.w; col++) {
-            int byteIdx = col / 8;
-            int bitIdx = 7 - (col % 8);
-            bool isBlack = !((rowData[byteIdx] >> bitIdx) & 1);
-            
-            // Draw pixel at zone offset
-            bbep.drawPixel(zone.x + col, zone.y + row, 
-                          isBlack ? BBEP_BLACK : BBEP_WHITE);
-        }
-    }
-    
+    Serial.printf("  ✓ %s: %d bytes (%dx%d)\n", zone.id, bytesRead,
+                  zoneDecoder.imageWidth(), zoneDecoder.imageHeight());
     return true;
 }
 
@@ -507,12 +458,19 @@ bool fetchAndDrawZone(const ZoneDef& zone, bool partial) {
 
 void doFullRefresh() {
     Serial.println("→ Full refresh...");
-    bbep.refresh(REFRESH_FULL, true);
-    Serial.println("✓ Full refresh complete");
+    panelRefresh(&bbep, REFRESH_FULL);
+    Serial.printf("✓ Full refresh complete, panel busy %lu ms\n",
+                  (unsigned long)panelBusy().stats(REFRESH_FULL).lastMs);
 }
 
-void doPartialRefresh() {
-    bbep.refresh(REFRESH_PARTIAL, true);
+/**
+ * Start the partial refresh of one zone just drawn and return while the
+ * panel is busy; the next fetch overlaps it.
+ */
+void startZoneRefresh(const ZoneDef& zone) {
+    PanelWindow win = alignPanelWindow(zone.x, zone.y, zone.w, zone.h, 800, 480);
+    startPanelWindowRefresh(&bbep, win, REFRESH_PARTIAL);
+    Serial.printf("  → %s refreshing (%dx%d)\n", zone.id, win.w, win.h);
 }
 
 // ============================================================================
@@ -15,7 +15,6 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
-#include <WiFiClientSecure.h>
 #include <Preferences.h>
 #include <BLEDevice.h>
 #include <BLEServer.h>
@@ -28,6 +27,20 @@
 #include "soc/rtc_cntl_reg.h"
 #include "../include/config.h"
 #include "../include/cc_logo_data.h"
+#include "../include/zone-connection.h"
+#include "../include/zone-bundle.h"
+#include "../include/zone-etag-cache.h"
+#include "../include/bmp-stream.h"
+#include "../include/zone-codec.h"
+#include "../include/json-stream.h"
+#include "../include/refresh-planner.h"
+#include "../include/ghost-tracker.h"
+#include "../include/spi-dma.h"
+#include "../include/panel-busy.h"
+#include "../include/fast-lut.h"
+#include "../include/sleep-cycle.h"
+#include "../include/idle-sleep.h"
+#include "../include/wifi-fast.h"
 
 // ============================================================================
 // CONFIGURATION
@@ -58,7 +71,23 @@
   #define PANEL_TYPE EP75_800x480
 #endif
 
-#define ZONE_BMP_MAX_SIZE 35000
+#define ZONE_READ_CHUNK 512
+
+// Refresh cadence when the server gives no X-Next-Change hint; with one,
+// the next refresh is when the zones are next expected to change
+#define DASHBOARD_REFRESH_MS 60000
+
+// Fetch all zones as one /api/zones-bundle response (falls back to
+// per-zone requests if the server does not serve bundles)
+#ifndef USE_ZONE_BUNDLE
+#define USE_ZONE_BUNDLE 1
+#endif
+
+// Ask /api/zones-sync what changed since the last applied sequence number
+// before anything else; one request and no refresh for an unchanged minute
+#ifndef USE_ZONE_SYNC
+#define USE_ZONE_SYNC 1
+#endif
 #define DEFAULT_SERVER "https://einkptdashboard.vercel.app"
 
 // BLE UUIDs (Hybrid: WiFi credentials ONLY - URL comes via pairing code)
@@ -76,14 +105,15 @@
 struct ZoneDef {
     const char* id;
     int x, y, w, h;
+    bool fast;      // small high-churn content (clock, countdown): fast LUT
 };
 
 const ZoneDef ZONE_DEFS[] = {
-    {"header",  0,   0, 800,  94},
-    {"divider", 0,  94, 800,   2},
-    {"summary", 0,  96, 800,  28},
-    {"legs",    0, 132, 800, 316},
-    {"footer",  0, 448, 800,  32}
+    {"header",  0,   0, 800,  94, true},
+    {"divider", 0,  94, 800,   2, false},
+    {"summary", 0,  96, 800,  28, true},
+    {"legs",    0, 132, 800, 316, false},
+    {"footer",  0, 448, 800,  32, false}
 };
 const int NUM_ZONES = 5;
 
@@ -131,14 +161,56 @@ String wifiNetworkList = "";
 
 // Timing
 unsigned long lastRefresh = 0;
+uint32_t refreshIntervalMs = DASHBOARD_REFRESH_MS;   // until the next refresh
+int32_t cycleNextChangeS = -1;                       // earliest hint this fetch
 unsigned long lastFullRefresh = 0;
 unsigned long pairingStartTime = 0;
 unsigned long lastPollTime = 0;
 int partialRefreshCount = 0;
 int consecutiveErrors = 0;
 
-// Buffers
-uint8_t* zoneBmpBuffer = nullptr;
+// Zone images (BMP or rle1) are decoded as they arrive; only one row band is held
+uint8_t zoneBand[BMP_STREAM_BAND_SIZE];
+ZoneImageDecoder zoneDecoder(zoneBand, sizeof(zoneBand));
+
+// One keep-alive TLS session per refresh cycle
+ZoneConnection zoneConn;
+
+// ETag of the bitmap currently in panel RAM, per zone
+ZoneEtagCache zoneEtags;
+
+// Everything redrawn this cycle (full zones and delta rects), refreshed as one plan
+RefreshPlanner refreshPlan(SCREEN_W, SCREEN_H, millis);
+
+// Rects of fast zones, refreshed with the fast LUT after the normal plan
+RefreshPlanner fastPlan(SCREEN_W, SCREEN_H, millis);
+
+// Ghosting per zone: localized cleans when a zone runs out of budget,
+// whole-screen full refreshes only when idle (no recent button press)
+GhostTracker ghosts;
+unsigned long lastInteraction = 0;
+
+// Carried through deep sleep between refreshes (sleep-cycle.h). Ages are
+// relative to the moment of sleeping; millis() restarts on every wake.
+struct SleepState {
+    uint64_t savedAtMs;              // rtcClockMs() when going to sleep
+    uint32_t sinceRefreshMs;
+    uint32_t sinceFullMs;
+    uint32_t sinceInteractionMs;
+    int32_t partialRefreshCount;
+    uint32_t spiHz;
+    uint32_t cycles;
+    uint32_t refreshIntervalMs;
+    uint8_t ghosts[sizeof(GhostTracker)];
+    ZoneEtagCache::Snapshot etags;
+};
+RTC_DATA_ATTR RtcBlock<SleepState> rtcState;
+bool resumedFromSleep = false;
+
+// Charge accounting for the current cycle
+SleepCycleTimes cycleTimes;
+unsigned long radioOnAt = 0;
+uint32_t panelSpiHz = 0;
 
 // ============================================================================
 // FUNCTION DECLARATIONS
@@ -158,23 +230,21 @@ String scanWiFiNetworks();
 bool connectWiFi();
 void generatePairingCode();
 bool pollPairingServer();
-bool fetchZoneUpdates(bool forceAll);
-int fetchAndRenderZone(const char* baseUrl, const ZoneDef& def, bool forceAll);
+int fetchZoneUpdates();
+int fetchZoneSync(int& unchanged);
+int fetchZoneBundle(int& unchanged);
+int renderZoneResponse(const ZoneDef& def, const ZoneResponse& resp);
+void markZoneDirty(const char* id, int zx, int zy, int zw, int zh, int x, int y, int w, int h);
+void logRefreshPlan();
 void doFullRefresh();
-
-// ============================================================================
-// JSON HELPERS
-// ============================================================================
-
-String jsonGetString(const String& json, const char* key) {
-    String search = String("\"") + key + "\":\"";
-    int start = json.indexOf(search);
-    if (start < 0) return "";
-    start += search.length();
-    int end = json.indexOf("\"", start);
-    if (end < 0) return "";
-    return json.substring(start, end);
-}
+void doPartialRefresh();
+void doFastRefresh();
+void logPlaneTransfers();
+void logPanelBusy();
+void cleanGhostedZone();
+bool restoreSleepState();
+bool sleepCycleAllowed(unsigned long now);
+void sleepUntilNextRefresh(unsigned long now);
 
 // ============================================================================
 // BLE CALLBACKS
@@ -289,16 +359,13 @@ void setup() {
     // Load settings
     loadSettings();
 
-    // Allocate buffer
-    zoneBmpBuffer = (uint8_t*)malloc(ZONE_BMP_MAX_SIZE);
-    if (!zoneBmpBuffer) {
-        Serial.println("[ERROR] Buffer alloc failed");
-    }
+    // Woken from a sleep cycle: keep the dashboard, go straight to the fetch
+    resumedFromSleep = restoreSleepState();
 
     // Init display
     initDisplay();
 
-    currentState = STATE_BOOT;
+    currentState = resumedFromSleep ? STATE_WIFI_CONNECT : STATE_BOOT;
 }
 
 // ============================================================================
@@ -307,6 +374,8 @@ void setup() {
 
 void loop() {
     unsigned long now = millis();
+    if (digitalRead(PIN_INTERRUPT) == LOW) lastInteraction = now;
+    if (panelBusy().pending() && panelBusy().poll()) logPanelBusy();   // async full refresh done
 
     switch (currentState) {
         // ==== BOOT: Show logo ====
@@ -368,7 +437,8 @@ void loop() {
         // ==== WIFI CONNECT ====
         case STATE_WIFI_CONNECT: {
             Serial.println("[STATE] WiFi Connect");
-            showConnectingScreen();
+            // A wake from sleep connects silently; the dashboard stays up
+            if (!resumedFromSleep || consecutiveErrors > 0) showConnectingScreen();
 
             if (connectWiFi()) {
                 wifiConnected = true;
@@ -459,20 +529,36 @@ void loop() {
         case STATE_FETCH_DASHBOARD: {
             Serial.println("[STATE] Fetch Dashboard");
 
-            bool needsFull = !initialDrawDone ||
-                            (now - lastFullRefresh >= 300000) ||
-                            (partialRefreshCount >= MAX_PARTIAL_BEFORE_FULL);
-
-            if (fetchZoneUpdates(needsFull)) {
+            bool idle = now - lastInteraction >= GHOST_IDLE_MS;
+            bool needsFull = !initialDrawDone || ghosts.wholeDue(idle, now - lastFullRefresh);
+
+            int changed = fetchZoneUpdates();
+            static bool wakeLogged = false;
+            if (resumedFromSleep && !wakeLogged && zoneConn.stats.firstByteMs) {
+                // millis() restarted at the wake
+                Serial.printf("[Sleep] Wake to first byte %lu ms (Wi-Fi %lu ms, %s)\n",
+                              zoneConn.stats.cycleStart + zoneConn.stats.firstByteMs,
+                              (unsigned long)wifiFast().lastConnectMs(), wifiFastPathName(wifiFast().lastPath()));
+                wakeLogged = true;
+            }
+            if (changed >= 0) {
                 if (needsFull) {
                     doFullRefresh();
                     lastFullRefresh = now;
                     partialRefreshCount = 0;
-                } else {
-                    bbep->refresh(REFRESH_PARTIAL, true);
+                } else if (changed > 0) {
+                    doPartialRefresh();
+                    cleanGhostedZone();
                     partialRefreshCount++;
+                } else {
+                    Serial.println("[Fetch] No zone changes - refresh skipped");
                 }
                 lastRefresh = now;
+                refreshIntervalMs = nextChangeDelayMs(cycleNextChangeS, DASHBOARD_REFRESH_MS);
+                if (cycleNextChangeS >= 0) {
+                    Serial.printf("[Fetch] Next change in %ld s, refresh in %lu s\n",
+                                  (long)cycleNextChangeS, (unsigned long)(refreshIntervalMs / 1000));
+                }
                 initialDrawDone = true;
                 consecutiveErrors = 0;
                 currentState = STATE_IDLE;
@@ -489,16 +575,25 @@ void loop() {
 
         // ==== IDLE ====
         case STATE_IDLE: {
-            if (now - lastRefresh >= 60000) {
-                currentState = STATE_FETCH_DASHBOARD;
-            }
-
             if (WiFi.status() != WL_CONNECTED) {
                 wifiConnected = false;
                 currentState = STATE_WIFI_CONNECT;
+            } else if (now - lastRefresh >= refreshIntervalMs) {
+                currentState = STATE_FETCH_DASHBOARD;
+            } else if (sleepCycleAllowed(now)) {
+                sleepUntilNextRefresh(now);   // does not return; the wake is a reset
+            } else {
+                // Awake between refreshes: modem sleep, and light sleep unless a
+                // USB console would drop; the association is kept for the fetch
+                bool pressed = idleSleep().idleUntil(lastRefresh + refreshIntervalMs, !usbPowered(),
+                                                     []() { return WiFi.status() == WL_CONNECTED; });
+                if (pressed) {
+                    // The next hint may be far off: show fresh data now
+                    lastInteraction = millis();
+                    currentState = STATE_FETCH_DASHBOARD;
+                }
+                logIdleSleep();
             }
-
-            delay(1000);
             break;
         }
 
@@ -569,18 +664,9 @@ void stopBLE() {
 // ============================================================================
 
 bool connectWiFi() {
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(wifiSSID, wifiPassword);
-
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 30) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
-    }
-    Serial.println();
-
-    return WiFi.status() == WL_CONNECTED;
+    radioOnAt = millis();
+    // Last AP without a scan (and its lease while young), full scan on failure
+    return wifiFast().connect(wifiSSID, wifiPassword);
 }
 
 // ============================================================================
@@ -597,9 +683,39 @@ void generatePairingCode() {
     Serial.printf("[PAIR] Code: %s\n", pairingCode);
 }
 
+/**
+ * Picks "status" and "webhookUrl" out of a /api/pair/<code> response
+ */
+class PairingHandler : public JsonPathHandler {
+public:
+    char status[16] = "";
+    char webhook[sizeof(webhookUrl)] = "";
+
+    void onValue(const char* p, const char* value, bool isString) override {
+        if (strcmp(p, "status") == 0) {
+            strncpy(status, value, sizeof(status) - 1);
+            status[sizeof(status) - 1] = '\0';
+        }
+    }
+
+    // webhookUrl can exceed JSON_STREAM_SCALAR_MAX, so it is streamed
+    bool wantStreamPath(const char* p) override {
+        if (strcmp(p, "webhookUrl") != 0) return false;
+        webhookLen = 0;
+        return true;
+    }
+
+    void onStringData(const char* data, size_t len) override {
+        while (len-- > 0 && webhookLen + 1 < sizeof(webhook)) webhook[webhookLen++] = *data++;
+        webhook[webhookLen] = '\0';
+    }
+
+private:
+    size_t webhookLen = 0;
+};
+
 bool pollPairingServer() {
-    WiFiClientSecure client;
-    client.setInsecure();
+    TlsClient client;
     HTTPClient http;
 
     String url = String(DEFAULT_SERVER) + "/api/pair/" + String(pairingCode);
@@ -614,17 +730,17 @@ bool pollPairingServer() {
         return false;
     }
 
-    String payload = http.getString();
+    // Scan the response as it arrives - no String copy of the body
+    PairingHandler handler;
+    JsonStreamParser parser(&handler);
+    JsonStreamWriter writer(parser);
+    http.writeToStream(&writer);
     http.end();
 
-    String status = jsonGetString(payload, "status");
-    if (status == "paired") {
-        String webhook = jsonGetString(payload, "webhookUrl");
-        if (webhook.length() > 0) {
-            strncpy(webhookUrl, webhook.c_str(), sizeof(webhookUrl) - 1);
-            Serial.printf("[PAIR] Success! URL: %s\n", webhookUrl);
-            return true;
-        }
+    if (strcmp(handler.status, "paired") == 0 && handler.webhook[0]) {
+        strncpy(webhookUrl, handler.webhook, sizeof(webhookUrl) - 1);
+        Serial.printf("[PAIR] Success! URL: %s\n", webhookUrl);
+        return true;
     }
 
     return false;
@@ -635,23 +751,40 @@ bool pollPairingServer() {
 // ============================================================================
 
 void initDisplay() {
-    bbep->initIO(EPD_DC_PIN, EPD_RST_PIN, EPD_BUSY_PIN, EPD_CS_PIN, EPD_MOSI_PIN, EPD_SCK_PIN, 0);
+    // Fastest clock the panel reads back reliably, then DMA plane transfers.
+    // After a sleep cycle the panel still holds the dashboard: no reset, reuse the clock.
+    uint32_t spiHz = resumedFromSleep && rtcState.data.spiHz
+        ? rtcState.data.spiHz
+        : calibratePanelSpi(EPD_SCK_PIN, EPD_MOSI_PIN, EPD_CS_PIN, EPD_DC_PIN, EPD_RST_PIN, EPD_BUSY_PIN);
+    panelSpiHz = spiHz;
+    bbep->initIO(EPD_DC_PIN, EPD_RST_PIN, EPD_BUSY_PIN, EPD_CS_PIN, EPD_MOSI_PIN, EPD_SCK_PIN, spiHz);
+    bool dma = installPanelDataWriter(bbep, spiHz, EPD_SCK_PIN, EPD_MOSI_PIN, EPD_CS_PIN, EPD_DC_PIN);
+    Serial.printf("[Display] SPI %lu kHz, %s transfers\n", (unsigned long)(spiHz / 1000), dma ? "DMA" : "CPU");
+    panelBusy().begin(EPD_BUSY_PIN);
+    // Light sleep through refreshes only with both radios off; it drops links
+    panelBusy().canSleep = []() { return WiFi.getMode() == WIFI_OFF && !btStarted(); };
     bbep->setPanelType(PANEL_TYPE);
     bbep->setRotation(0);
     pinMode(PIN_INTERRUPT, INPUT_PULLUP);
+    idleSleep().begin(PIN_INTERRUPT);   // the button also ends idle waits
     Serial.println("[Display] Ready");
 }
 
 void showBootScreen() {
+    zoneEtags.invalidate();
+    finishPanelRefresh();
     bbep->fillScreen(BBEP_WHITE);
     int bootX = (SCREEN_W - LOGO_BOOT_W) / 2;
     int bootY = (SCREEN_H - LOGO_BOOT_H) / 2;
     bbep->loadBMP(LOGO_BOOT, bootX, bootY, BBEP_BLACK, BBEP_WHITE);
-    bbep->refresh(REFRESH_FULL, true);
+    panelRefresh(bbep, REFRESH_FULL);
     lastFullRefresh = millis();
+    ghosts.reset();
 }
 
 void showSetupScreen() {
+    zoneEtags.invalidate();
+    finishPanelRefresh();
     Serial.println("[Setup] Rendering setup screen...");
     
     // Unified setup screen - shows BOTH BLE and pairing code options
@@ -722,10 +855,12 @@ void showSetupScreen() {
     bbep->setCursor(220, 455); bbep->print("(c) 2026 Angus Bergman - CC BY-NC 4.0");
     bbep->setCursor(360, 470); bbep->print("v" FIRMWARE_VERSION);
 
-    bbep->refresh(REFRESH_FULL, true);
+    panelRefresh(bbep, REFRESH_FULL);
 }
 
 void showConnectingScreen() {
+    zoneEtags.invalidate();
+    finishPanelRefresh();
     bbep->fillScreen(BBEP_WHITE);
     bbep->setFont(FONT_8x8);
     bbep->setTextColor(BBEP_BLACK, BBEP_WHITE);
@@ -741,12 +876,14 @@ void showConnectingScreen() {
     bbep->drawLine(50, 440, 750, 440, BBEP_BLACK);
     bbep->setCursor(360, 455); bbep->print("v" FIRMWARE_VERSION);
 
-    bbep->refresh(REFRESH_FULL, true);
+    panelRefresh(bbep, REFRESH_FULL);
 }
 
 // showPairingScreen removed - unified into showSetupScreen()
 
 void showPairedScreen() {
+    zoneEtags.invalidate();
+    finishPanelRefresh();
     bbep->fillScreen(BBEP_WHITE);
     bbep->setFont(FONT_8x8);
     bbep->setTextColor(BBEP_BLACK, BBEP_WHITE);
@@ -763,10 +900,12 @@ void showPairedScreen() {
     bbep->setCursor(220, 455); bbep->print("(c) 2026 Angus Bergman - CC BY-NC 4.0");
     bbep->setCursor(360, 470); bbep->print("v" FIRMWARE_VERSION);
 
-    bbep->refresh(REFRESH_FULL, true);
+    panelRefresh(bbep, REFRESH_FULL);
 }
 
 void showErrorScreen(const char* msg) {
+    zoneEtags.invalidate();
+    finishPanelRefresh();
     bbep->fillScreen(BBEP_WHITE);
     bbep->setFont(FONT_8x8);
     bbep->setTextColor(BBEP_BLACK, BBEP_WHITE);
@@ -783,7 +922,7 @@ void showErrorScreen(const char* msg) {
     bbep->drawLine(50, 440, 750, 440, BBEP_BLACK);
     bbep->setCursor(360, 455); bbep->print("v" FIRMWARE_VERSION);
 
-    bbep->refresh(REFRESH_FULL, true);
+    panelRefresh(bbep, REFRESH_FULL);
 }
 
 // ============================================================================
@@ -797,6 +936,8 @@ void loadSettings() {
     String pass = preferences.getString("wifi_pass", "");
     String url = preferences.getString("webhookUrl", "");
     devicePaired = preferences.getBool("paired", false);
+    zoneEtags.load(preferences);
+    wifiFast().load(preferences);
 
     strncpy(wifiSSID, ssid.c_str(), sizeof(wifiSSID) - 1);
     strncpy(wifiPassword, pass.c_str(), sizeof(wifiPassword) - 1);
@@ -823,61 +964,609 @@ void saveSettings() {
 // DASHBOARD FETCHING
 // ============================================================================
 
-int fetchAndRenderZone(const char* baseUrl, const ZoneDef& def, bool forceAll) {
-    WiFiClientSecure client;
-    client.setInsecure();
-    HTTPClient http;
+/**
+ * Decode one zone image (BMP or rle1) from `read` straight into panel RAM at (x, y).
+ * `read` follows readBody(): bytes read, 0 at end, -1 on error.
+ * Returns 1 if drawn, 0 if the image was bad (body drained), -1 on I/O error.
+ */
+template <typename Reader>
+int streamZoneBmp(Reader read, int x, int y) {
+    PanelWindowSink<BBEPAPER> sink(bbep, x, y, PLANE_0);
+    zoneDecoder.reset(&sink);
+
+    uint8_t chunk[ZONE_READ_CHUNK];
+    bool failed = false;
+    for (;;) {
+        int n = read(chunk, sizeof(chunk));
+        if (n < 0) return -1;
+        if (n == 0) break;
+        if (!failed && zoneDecoder.feed(chunk, n) == BmpStreamDecoder::FAILED) failed = true;
+    }
+    return (!failed && zoneDecoder.done()) ? 1 : 0;
+}
 
-    String url = String(baseUrl) + "/api/zone/" + def.id;
-    if (forceAll) url += "?force=true";
+const ZoneDef* findZoneDef(const char* id) {
+    for (int i = 0; i < NUM_ZONES; i++) {
+        if (strcmp(ZONE_DEFS[i].id, id) == 0) return &ZONE_DEFS[i];
+    }
+    return nullptr;
+}
 
-    Serial.printf("[Fetch] %s\n", def.id);
-    http.setTimeout(15000);
+/**
+ * Queue the rect (x, y, w, h) drawn into zone `id` at (zx, zy, zw, zh).
+ * Fast zones go to the fast-LUT plan until their run of fast updates is
+ * used up; then one normal update clears the extra residue.
+ */
+void markZoneDirty(const char* id, int zx, int zy, int zw, int zh, int x, int y, int w, int h) {
+    const ZoneDef* def = findZoneDef(id);
+    bool fast = def && def->fast && ghosts.fastAllowed(id);
+    (fast ? fastPlan : refreshPlan).add(x, y, w, h);
+    ghosts.noteUpdate(id, zx, zy, zw, zh, (int32_t)w * h, fast);
+}
 
-    if (!http.begin(client, url)) return 0;
+void logRefreshPlan() {
+    switch (refreshPlan.plan()) {
+        case RefreshPlanner::PLAN_WINDOWS:
+            for (int i = 0; i < refreshPlan.windowCount(); i++) {
+                const PanelWindow& w = refreshPlan.window(i);
+                Serial.printf("[Fetch] Changed area %dx%d at %d,%d\n", w.w, w.h, w.x, w.y);
+            }
+            break;
+        case RefreshPlanner::PLAN_WHOLE:
+            Serial.println("[Fetch] Changed area: most of the screen");
+            break;
+        default:
+            break;
+    }
+    if (fastPlan.plan() != RefreshPlanner::PLAN_NONE) {
+        for (int i = 0; i < fastPlan.windowCount(); i++) {
+            const PanelWindow& w = fastPlan.window(i);
+            Serial.printf("[Fetch] Fast area %dx%d at %d,%d\n", w.w, w.h, w.x, w.y);
+        }
+    }
+}
 
-    int code = http.GET();
-    if (code != 200) {
-        http.end();
-        return 0;
+int renderZoneResponse(const ZoneDef& def, const ZoneResponse& resp) {
+    if (resp.status != 200) {
+        Serial.printf("[Fetch] %s: HTTP %d\n", def.id, resp.status);
+        zoneEtags.remove(def.id);
+        return zoneConn.skipBody() ? 0 : -1;
     }
 
-    int len = http.getSize();
-    if (len <= 0 || len > ZONE_BMP_MAX_SIZE) {
-        http.end();
+    // A delta covers only the changed rectangle of the zone we already show
+    int x = def.x, y = def.y, w = def.w, h = def.h;
+    if (resp.deltaW > 0) {
+        x += resp.deltaX;
+        y += resp.deltaY;
+        w = resp.deltaW;
+        h = resp.deltaH;
+        Serial.printf("[Fetch] %s: delta %dx%d at +%d,+%d\n", def.id, w, h, resp.deltaX, resp.deltaY);
+    }
+
+    // Content-Length or chunked - the decoder does not need the size
+    int r = streamZoneBmp([](uint8_t* buf, size_t len) { return zoneConn.readBody(buf, len); }, x, y);
+    if (r != 1) {
+        if (r == 0) Serial.printf("[Fetch] %s: bad BMP\n", def.id);
+        zoneEtags.remove(def.id);
+        return r;
+    }
+    if (resp.etag[0]) zoneEtags.set(def.id, resp.etag);
+    markZoneDirty(def.id, def.x, def.y, def.w, def.h, x, y, w, h);
+    return 1;
+}
+
+/**
+ * Append "header,divider,..." to out
+ */
+void formatZoneIds(char* out, size_t len) {
+    int n = 0;
+    out[0] = '\0';
+    for (int i = 0; i < NUM_ZONES && n < (int)len; i++) {
+        n += snprintf(out + n, len - n, "%s%s", i ? "," : "", ZONE_DEFS[i].id);
+    }
+}
+
+/**
+ * Build "X-Zone-ETags: header=\"...\",legs=\"...\"\r\n". Returns the number
+ * of ETags listed (0 = send no header).
+ */
+int formatEtagHeader(char* out, size_t len) {
+    int n = snprintf(out, len, "X-Zone-ETags: ");
+    int known = 0;
+    for (int i = 0; i < NUM_ZONES; i++) {
+        const char* etag = zoneEtags.get(ZONE_DEFS[i].id);
+        if (!etag) continue;
+        int w = snprintf(out + n, len - n, "%s%s=%s", known ? "," : "", ZONE_DEFS[i].id, etag);
+        if (w <= 0 || n + w >= (int)len - 2) break;
+        n += w;
+        known++;
+    }
+    strcpy(out + n, "\r\n");
+    return known;
+}
+
+/**
+ * Draw one changed bundle frame (full zone or delta rect).
+ * Returns 1 if drawn, 0 if the image was bad, -1 on I/O error.
+ */
+int drawBundleFrame(ZoneBundleReader& bundle, const ZoneFrame& frame) {
+    int x = frame.x + frame.dx;
+    int y = frame.y + frame.dy;
+    int r = streamZoneBmp([&bundle](uint8_t* buf, size_t len) { return bundle.read(buf, len); }, x, y);
+    if (r == 1) {
+        if (frame.etag[0]) zoneEtags.set(frame.id, frame.etag);
+        markZoneDirty(frame.id, frame.x, frame.y, frame.w, frame.h, x, y, frame.dw, frame.dh);
+    } else if (r == 0) {
+        Serial.printf("[Fetch] %s: bad BMP\n", frame.id);
+        zoneEtags.remove(frame.id);
+    }
+    return r;
+}
+
+/**
+ * Fetch one zone on the open connection (conditional on its ETag).
+ * Returns 1 if drawn, 2 if unchanged (304), 0 if the image was bad, -1 on
+ * I/O error.
+ */
+int fetchOneZone(const ZoneDef& def) {
+    char path[64];
+    snprintf(path, sizeof(path), "/api/zone/%s", def.id);
+
+    char ifNoneMatch[ZONE_ETAG_MAX + 24];
+    const char* etag = zoneEtags.get(def.id);
+    if (etag) snprintf(ifNoneMatch, sizeof(ifNoneMatch), "If-None-Match: %s\r\n", etag);
+
+    ZoneResponse resp;
+    if (!zoneConn.open() || !zoneConn.sendGet(path, etag ? ifNoneMatch : nullptr) ||
+        !zoneConn.readResponse(resp)) {
+        zoneConn.close();
+        return -1;
+    }
+    cycleNextChangeS = nextChangeEarliest(cycleNextChangeS, resp.nextChangeS);
+    int r = resp.status == 304 ? 2 : renderZoneResponse(def, resp);
+    if (r < 0 || !resp.keepAlive) zoneConn.close();
+    return r;
+}
+
+/**
+ * Ask /api/zones-sync which zones changed since the stored cursor. Small
+ * changed zones arrive inlined; deferred ones are fetched one by one on
+ * the same connection. The cursor only advances once every listed zone
+ * is drawn or found already shown (304, or a frame without the changed
+ * flag), so a failed cycle is retried from the old cursor.
+ * Returns zones rendered (0 for an unchanged minute), or -1 to fall back.
+ */
+int fetchZoneSync(int& unchanged) {
+    if (!zoneConn.open()) return -1;
+
+    char path[128];
+    int n = snprintf(path, sizeof(path), "/api/zones-sync?since=%lu&epoch=%lu&ids=",
+                     (unsigned long)zoneEtags.syncSeq(), (unsigned long)zoneEtags.syncEpoch());
+    formatZoneIds(path + n, sizeof(path) - n);
+
+    char etagHeader[224];
+    int known = formatEtagHeader(etagHeader, sizeof(etagHeader));
+
+    Serial.printf("[Sync] Since %lu\n", (unsigned long)zoneEtags.syncSeq());
+    if (!zoneConn.sendGet(path, known ? etagHeader : nullptr)) return -1;
+
+    ZoneResponse resp;
+    if (!zoneConn.readResponse(resp)) return -1;
+    cycleNextChangeS = nextChangeEarliest(cycleNextChangeS, resp.nextChangeS);
+    if (resp.status == 204 && resp.syncSeq) {
+        if (!resp.keepAlive) zoneConn.close();
+        zoneEtags.setSyncCursor(resp.syncEpoch, resp.syncSeq);
+        unchanged = NUM_ZONES;
+        Serial.printf("[Sync] Up to date at %lu\n", (unsigned long)resp.syncSeq);
         return 0;
     }
+    if (resp.status != 200 || !resp.syncSeq) {
+        Serial.printf("[Sync] HTTP %d\n", resp.status);
+        if (!zoneConn.skipBody() || !resp.keepAlive) zoneConn.close();
+        return -1;
+    }
 
-    WiFiClient* stream = http.getStreamPtr();
-    int read = stream->readBytes(zoneBmpBuffer, len);
-    http.end();
+    ZoneBundleReader bundle(zoneConn);
+    if (bundle.begin() < 0) {
+        zoneConn.close();
+        return -1;
+    }
 
-    if (read != len) return 0;
-    if (zoneBmpBuffer[0] != 'B' || zoneBmpBuffer[1] != 'M') return 0;
+    bool deferred[NUM_ZONES] = {};
+    bool complete = true;
+    int listed = 0;
+    int shown = 0;
+    int rendered = 0;
+    ZoneFrame frame;
+    while (bundle.next(frame)) {
+        listed++;
+        if (frame.flags & ZONE_BUNDLE_FLAG_DEFERRED) {
+            for (int i = 0; i < NUM_ZONES; i++) {
+                if (strcmp(ZONE_DEFS[i].id, frame.id) == 0) deferred[i] = true;
+            }
+            continue;
+        }
+        if (!(frame.flags & ZONE_BUNDLE_FLAG_CHANGED)) {
+            shown++;
+            continue;
+        }
+        int r = drawBundleFrame(bundle, frame);
+        if (r < 0) {
+            complete = false;
+            break;
+        }
+        if (r == 1) rendered++;
+        else complete = false;
+        yield();
+    }
+    // next() also ends on a dropped connection: the unread zones were not received
+    if (!bundle.atEnd()) complete = false;
+    if (!zoneConn.skipBody() || !resp.keepAlive) zoneConn.close();
+
+    for (int i = 0; i < NUM_ZONES && complete; i++) {
+        if (!deferred[i]) continue;
+        int r = fetchOneZone(ZONE_DEFS[i]);
+        if (r == 1) rendered++;
+        else if (r == 2) shown++;
+        else complete = false;
+        yield();
+    }
 
-    int result = bbep->loadBMP(zoneBmpBuffer, def.x, def.y, BBEP_BLACK, BBEP_WHITE);
-    return result == BBEP_SUCCESS ? 1 : 0;
+    // Zones the bundle announced but we never read are not "unchanged"
+    unchanged = NUM_ZONES - bundle.zoneCount() + shown;
+    if (complete) zoneEtags.setSyncCursor(resp.syncEpoch, resp.syncSeq);
+    Serial.printf("[Sync] %d listed, %d drawn, seq %lu%s\n", listed, rendered,
+                  (unsigned long)resp.syncSeq, complete ? "" : " (incomplete, cursor kept)");
+    return rendered;
 }
 
-bool fetchZoneUpdates(bool forceAll) {
-    if (strlen(webhookUrl) == 0) return false;
+/**
+ * Fetch every zone in one bundle request and draw each changed frame as it
+ * arrives. Returns zones rendered (unchanged zones counted in `unchanged`),
+ * or -1 if the bundle path is unavailable and the caller should fall back
+ * to per-zone requests.
+ */
+int fetchZoneBundle(int& unchanged) {
+    if (!zoneConn.open()) return -1;
+
+    char path[96];
+    int n = snprintf(path, sizeof(path), "/api/zones-bundle?ids=");
+    formatZoneIds(path + n, sizeof(path) - n);
+
+    char etagHeader[224];
+    int known = formatEtagHeader(etagHeader, sizeof(etagHeader));
+
+    Serial.printf("[Fetch] Bundle (%d ETags)\n", known);
+    if (!zoneConn.sendGet(path, known ? etagHeader : nullptr)) return -1;
+
+    ZoneResponse resp;
+    if (!zoneConn.readResponse(resp)) return -1;
+    cycleNextChangeS = nextChangeEarliest(cycleNextChangeS, resp.nextChangeS);
+    if (resp.status != 200) {
+        Serial.printf("[Fetch] Bundle: HTTP %d\n", resp.status);
+        if (!zoneConn.skipBody() || !resp.keepAlive) zoneConn.close();
+        return -1;
+    }
+
+    ZoneBundleReader bundle(zoneConn);
+    if (bundle.begin() < 0) {
+        zoneConn.close();
+        return -1;
+    }
+
+    int rendered = 0;
+    ZoneFrame frame;
+    while (bundle.next(frame)) {
+        if (!(frame.flags & ZONE_BUNDLE_FLAG_CHANGED)) {
+            unchanged++;
+            continue;
+        }
+        int r = drawBundleFrame(bundle, frame);
+        if (r < 0) break;
+        rendered += r;
+        yield();
+    }
+
+    if (!zoneConn.skipBody() || !resp.keepAlive) zoneConn.close();
+    return rendered;
+}
+
+/**
+ * Fetch all zones with conditional requests and draw the changed ones.
+ * Returns the number of zones redrawn (0 = nothing changed), or -1 if no
+ * zone could be fetched.
+ */
+int fetchZoneUpdates() {
+    if (strlen(webhookUrl) == 0) return -1;
 
     String baseUrl = String(webhookUrl);
     int idx = baseUrl.indexOf("/api/device/");
     if (idx > 0) baseUrl = baseUrl.substring(0, idx);
-
+    if (!zoneConn.begin(baseUrl.c_str())) return -1;
+    zoneConn.setDefaultHeaders(ZONE_CODEC_HEADER ZONE_DELTA_HEADER);
+
+    // Zones stream into panel RAM: an async full refresh must be over
+    finishPanelRefresh();
+    zoneConn.beginCycle();
+    refreshPlan.reset();
+    fastPlan.reset();
     int rendered = 0;
-    for (int i = 0; i < NUM_ZONES; i++) {
-        if (fetchAndRenderZone(baseUrl.c_str(), ZONE_DEFS[i], forceAll)) {
-            rendered++;
+    int unchanged = 0;
+    cycleNextChangeS = -1;
+
+#if USE_ZONE_SYNC
+    rendered = fetchZoneSync(unchanged);
+    if (rendered >= 0) {
+        zoneConn.close();
+        zoneConn.endCycle();
+        zoneEtags.persist();
+        Serial.printf("[Fetch] Rendered %d/%d zones, %d unchanged (sync)\n",
+                      rendered, NUM_ZONES, unchanged);
+        logRefreshPlan();
+        return rendered;
+    }
+    rendered = 0;
+    unchanged = 0;
+#endif
+
+#if USE_ZONE_BUNDLE
+    rendered = fetchZoneBundle(unchanged);
+    if (rendered >= 0) {
+        zoneConn.close();
+        zoneConn.endCycle();
+        zoneEtags.persist();
+        Serial.printf("[Fetch] Rendered %d/%d zones, %d unchanged (bundle)\n",
+                      rendered, NUM_ZONES, unchanged);
+        logRefreshPlan();
+        return (rendered + unchanged) > 0 ? rendered : -1;
+    }
+    rendered = 0;
+    unchanged = 0;
+#endif
+
+    // All zone GETs share one TLS session; up to pipelineDepth() requests
+    // are in flight. On a dropped connection the unanswered ones are re-sent.
+    int sent = 0;
+    int done = 0;
+    int reconnects = 0;
+
+    while (done < NUM_ZONES) {
+        if (!zoneConn.connected()) {
+            if (sent > done) {
+                zoneConn.stats.resent += sent - done;
+                if (sent - done > 1) zoneConn.disablePipelining();
+            }
+            if (reconnects++ > 2 || !zoneConn.open()) break;
+            sent = done;
+        }
+
+        while (sent < NUM_ZONES && sent - done < zoneConn.pipelineDepth()) {
+            char path[64];
+            snprintf(path, sizeof(path), "/api/zone/%s", ZONE_DEFS[sent].id);
+
+            char ifNoneMatch[ZONE_ETAG_MAX + 24];
+            const char* etag = zoneEtags.get(ZONE_DEFS[sent].id);
+            if (etag) snprintf(ifNoneMatch, sizeof(ifNoneMatch), "If-None-Match: %s\r\n", etag);
+
+            if (!zoneConn.sendGet(path, etag ? ifNoneMatch : nullptr)) break;
+            Serial.printf("[Fetch] %s%s\n", ZONE_DEFS[sent].id, etag ? " (conditional)" : "");
+            sent++;
         }
+
+        ZoneResponse resp;
+        if (sent == done || !zoneConn.readResponse(resp)) {
+            zoneConn.close();
+            continue;
+        }
+        cycleNextChangeS = nextChangeEarliest(cycleNextChangeS, resp.nextChangeS);
+
+        if (resp.status == 304) {
+            // Panel RAM already holds this zone: no download, no loadBMP
+            unchanged++;
+        } else {
+            int r = renderZoneResponse(ZONE_DEFS[done], resp);
+            if (r < 0) {
+                zoneConn.close();
+                continue;
+            }
+            rendered += r;
+        }
+        done++;
+        reconnects = 0;
+
+        if (!resp.keepAlive) zoneConn.close();
         yield();
     }
 
-    Serial.printf("[Fetch] Rendered %d/%d zones\n", rendered, NUM_ZONES);
-    return rendered > 0;
+    // Free the ~42KB TLS context before the panel refresh (Incident #5)
+    zoneConn.close();
+    zoneConn.endCycle();
+    zoneEtags.persist();
+
+    Serial.printf("[Fetch] Rendered %d/%d zones, %d unchanged\n", rendered, NUM_ZONES, unchanged);
+    logRefreshPlan();
+    return (rendered + unchanged) > 0 ? rendered : -1;
 }
 
+/**
+ * Start the whole-screen full refresh and return: the ~3.5 s waveform runs
+ * while the loop goes idle. The next panel access waits for it.
+ */
 void doFullRefresh() {
-    bbep->refresh(REFRESH_FULL, true);
+    startPanelRefresh(bbep, REFRESH_FULL);
+    ghosts.reset();
+}
+
+/**
+ * Measured panel-busy time per refresh type
+ */
+void logPanelBusy() {
+    static const struct { int kind; const char* name; } kinds[] = {
+        { REFRESH_FULL, "full" }, { REFRESH_PARTIAL, "partial" }, { PANEL_BUSY_FAST_LUT, "fast" },
+    };
+    for (const auto& k : kinds) {
+        const PanelBusyStats& s = panelBusy().stats(k.kind);
+        if (!s.count) continue;
+        Serial.printf("[Display] Busy %s: last %lu ms, avg %lu ms, max %lu ms (%lu)\n", k.name,
+                      (unsigned long)s.lastMs, (unsigned long)s.avgMs(), (unsigned long)s.maxMs,
+                      (unsigned long)s.count);
+    }
+}
+
+/**
+ * Partial refresh of just the areas the last fetch drew into panel RAM,
+ * merged into as few windows as pay off (or one whole-plane partial).
+ */
+void doPartialRefresh() {
+    int n = refreshPlan.execute(bbep, REFRESH_PARTIAL, REFRESH_PARTIAL);
+    Serial.printf("[Display] %d refresh%s (%s), panel busy %lu ms\n", n, n == 1 ? "" : "es",
+                  refreshPlan.lastPlan() == RefreshPlanner::PLAN_WHOLE ? "whole" : "windows",
+                  (unsigned long)refreshPlan.busyMs());
+    doFastRefresh();
+    logPlaneTransfers();
+    logPanelBusy();
+}
+
+/**
+ * Plane bytes sent this cycle (streamed zones and window pushes) and how
+ * long the CPU was held up by them. Compare builds with PANEL_SPI_DMA=0.
+ */
+void logPlaneTransfers() {
+    PanelDataWriter* spi = panelDataWriter();
+    if (!spi) return;
+    Serial.printf("[Display] Plane data %lu B, CPU blocked %lu us\n",
+                  (unsigned long)spi->bytes, (unsigned long)spi->cpuUs);
+    spi->resetStats();
+}
+
+/**
+ * Fast-LUT refresh of the clock/countdown rects. The planner only merges
+ * them; a fast plan that grew to most of the screen still goes window by
+ * window, since the fast waveform is never used on the whole panel.
+ */
+void doFastRefresh() {
+    if (fastPlan.plan() == RefreshPlanner::PLAN_NONE) return;
+    unsigned long t0 = millis();
+    for (int i = 0; i < fastPlan.windowCount(); i++) {
+        refreshPanelWindowFast(bbep, fastPlan.window(i), []() {
+            panelBusy().start(PANEL_BUSY_FAST_LUT);
+            panelBusy().finish(FAST_LUT_TIMEOUT_MS);
+        });
+    }
+    Serial.printf("[Display] %d fast refresh%s, panel busy %lu ms\n", fastPlan.windowCount(),
+                  fastPlan.windowCount() == 1 ? "" : "es", millis() - t0);
+    fastPlan.reset();
+}
+
+/**
+ * Full-waveform refresh of the one zone most over its ghosting budget,
+ * in its own window. At most one per cycle to bound panel-busy time.
+ */
+void cleanGhostedZone() {
+    const GhostZone* z = ghosts.zoneToClean();
+    if (!z) return;
+    PanelWindow win = alignPanelWindow(z->x, z->y, z->w, z->h, SCREEN_W, SCREEN_H);
+    Serial.printf("[Display] Cleaning %s after %u updates\n", z->id, (unsigned)z->updates);
+    refreshPanelWindow(bbep, win, REFRESH_FULL);
+    ghosts.noteCleaned(z->id);
+}
+
+// ============================================================================
+// SLEEP CYCLE
+// ============================================================================
+
+/**
+ * Called from setup() before initDisplay(): after a timer or button wake
+ * with valid RTC state, put the timing, ghosting and ETag state back so
+ * the next fetch sends conditional requests and draws partially.
+ */
+bool restoreSleepState() {
+    // The panel reset line was held high through the sleep
+    gpio_hold_dis((gpio_num_t)EPD_RST_PIN);
+    gpio_deep_sleep_hold_dis();
+
+    if (!wokeFromSleep() || !rtcState.valid()) return false;
+
+    const SleepState& s = rtcState.data;
+    uint32_t slept = (uint32_t)(rtcClockMs() - s.savedAtMs);
+    unsigned long now = millis();
+    lastRefresh = now - (s.sinceRefreshMs + slept);
+    lastFullRefresh = now - (s.sinceFullMs + slept);
+    lastInteraction = wokeByButton() ? now : now - (s.sinceInteractionMs + slept);
+    partialRefreshCount = s.partialRefreshCount;
+    refreshIntervalMs = s.refreshIntervalMs;
+    memcpy((void*)&ghosts, s.ghosts, sizeof(ghosts));
+    zoneEtags.restore(s.etags, slept);
+    initialDrawDone = true;
+    cycleTimes.sleptMs = slept;
+
+    Serial.printf("[Sleep] Woke (%s) after %lu ms, cycle %lu\n", wokeByButton() ? "button" : "timer",
+                  (unsigned long)slept, (unsigned long)s.cycles);
+    return true;
+}
+
+/**
+ * Deep sleep only with the dashboard on the panel and the refresh done.
+ * A cold boot stays awake for SLEEP_BOOT_GRACE_MS so the device can be
+ * reflashed; USB power (a host on the port) or SLEEP_ALWAYS_ON keep it
+ * awake for good.
+ */
+bool sleepCycleAllowed(unsigned long now) {
+#if SLEEP_CYCLE_ENABLE && !SLEEP_ALWAYS_ON
+    if (!initialDrawDone || !devicePaired || !wifiConnected) return false;
+    if (!resumedFromSleep && now < SLEEP_BOOT_GRACE_MS) return false;
+    if (usbPowered()) return false;
+    if (digitalRead(PIN_INTERRUPT) == LOW) return false;   // would wake at once
+    return sleepCycleRemaining(now - lastRefresh, refreshIntervalMs) > 0;
+#else
+    (void)now;
+    return false;
+#endif
+}
+
+/**
+ * Save the cycle's state to RTC memory, report its charge and deep-sleep
+ * until the next refresh is due.
+ */
+void sleepUntilNextRefresh(unsigned long now) {
+    uint32_t ms = sleepCycleRemaining(now - lastRefresh, refreshIntervalMs);
+    finishPanelRefresh();
+    zoneConn.close();
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+
+    unsigned long t = millis();
+    cycleTimes.awakeMs = t;
+    cycleTimes.radioMs = t - radioOnAt;
+    cycleTimes.panelMs = 0;
+    for (int k = 0; k < PANEL_BUSY_KINDS; k++) cycleTimes.panelMs += panelBusy().stats(k).totalMs;
+
+    SleepState& s = rtcState.data;
+    uint32_t cycles = rtcState.valid() ? s.cycles + 1 : 1;
+    float mAs = sleepCycleCharge(cycleTimes);
+    uint32_t cycleMs = cycleTimes.sleptMs + cycleTimes.awakeMs;
+    Serial.printf("[Sleep] Cycle %lu: slept %lu ms, awake %lu ms (radio %lu, panel %lu) = %.1f mA*s, avg %.2f mA\n",
+                  (unsigned long)cycles, (unsigned long)cycleTimes.sleptMs, (unsigned long)cycleTimes.awakeMs,
+                  (unsigned long)cycleTimes.radioMs, (unsigned long)cycleTimes.panelMs,
+                  mAs, cycleMs ? mAs * 1000.0f / cycleMs : 0.0f);
+
+    s.sinceRefreshMs = t - lastRefresh;
+    s.sinceFullMs = t - lastFullRefresh;
+    s.sinceInteractionMs = t - lastInteraction;
+    s.partialRefreshCount = partialRefreshCount;
+    s.spiHz = panelSpiHz;
+    s.cycles = cycles;
+    s.refreshIntervalMs = refreshIntervalMs;
+    memcpy(s.ghosts, (const void*)&ghosts, sizeof(s.ghosts));
+    zoneEtags.save(s.etags);
+    s.savedAtMs = rtcClockMs();
+    rtcState.seal();
+
+    // A floating reset line would wipe the panel RAM the next partial relies on
+    digitalWrite(EPD_RST_PIN, HIGH);
+    gpio_hold_en((gpio_num_t)EPD_RST_PIN);
+    gpio_deep_sleep_hold_en();
+
+    Serial.printf("[Sleep] Sleeping %lu ms\n", (unsigned long)ms);
+    sleepUntilNextCycle(ms, PIN_INTERRUPT);
 }
@@ -13,7 +13,6 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
-#include <WiFiClientSecure.h>
 #include <WiFiManager.h>
 #include <Preferences.h>
 #include <ArduinoJson.h>
@@ -23,6 +22,9 @@
 #include "soc/soc.h"
 #include "soc/rtc_cntl_reg.h"
 #include "../include/config.h"
+#include "../include/tls-session.h"
+#include "../include/json-stream.h"
+#include "../include/refresh-planner.h"
 
 #define SCREEN_W 800
 #define SCREEN_H 480
@@ -40,6 +42,8 @@ const unsigned long REFRESH_INTERVAL = 20000;
 unsigned long lastFullRefresh = 0;
 const unsigned long FULL_REFRESH_INTERVAL = 300000;
 int partialCount = 0;
+PanelWindow drawnWindow = { 0, 0, 0, 0 };   // where the last zone landed, for a windowed refresh
+RefreshPlanner refreshPlan(SCREEN_W, SCREEN_H, millis);
 WiFiManagerParameter customServerUrl("server", "Server URL", "", 120);
 
 struct ZoneDef { const char* id; int16_t x, y, w, h; uint8_t refreshPriority; };
@@ -60,7 +64,7 @@ void connectWiFi();
 void loadSettings();
 void saveSettings();
 bool fetchChangedZoneList(bool forceAll, bool* changedFlags);
-bool fetchAndDrawZone(const ZoneDef& zone, bool doFlash);
+bool fetchAndDrawZone(const ZoneDef& zone);
 void doFullRefresh();
 
 void setup() {
@@ -87,21 +91,46 @@ void loop() {
         int drawn = 0;
         for (int i = 0; i < ZONE_COUNT; i++) {
             if (changedFlags[i] || needsFull) {
-                if (fetchAndDrawZone(ZONES[i], !needsFull)) {
+                if (fetchAndDrawZone(ZONES[i])) {
                     drawn++;
-                    if (!needsFull) { bbep.refresh(REFRESH_PARTIAL, true); partialCount++; delay(50); }
+                    if (!needsFull) refreshPlan.add(drawnWindow.x, drawnWindow.y, drawnWindow.w, drawnWindow.h);
                 }
                 yield();
             }
         }
         if (needsFull && drawn > 0) { doFullRefresh(); lastFullRefresh = now; partialCount = 0; initialDrawDone = true; }
+        else if (!refreshPlan.empty()) { refreshPlan.execute(&bbep, REFRESH_PARTIAL, REFRESH_PARTIAL); partialCount++; Serial.printf("Panel busy %lu ms\n", (unsigned long)refreshPlan.busyMs()); }
     }
     delay(1000);
 }
 
+/**
+ * Marks every zone id listed in "changed":[...] of a /api/zones response
+ */
+class ChangedZonesHandler : public JsonPathHandler {
+public:
+    explicit ChangedZonesHandler(bool* changedFlags) : flags(changedFlags), seen(false) {}
+
+    void onEnter(const char* p, bool isArray) override {
+        if (isArray && strcmp(p, "changed") == 0) seen = true;
+    }
+
+    void onValue(const char* p, const char* value, bool isString) override {
+        if (strcmp(p, "changed[]") != 0) return;
+        for (int i = 0; i < ZONE_COUNT; i++) {
+            if (strcmp(value, ZONES[i].id) == 0) { flags[i] = true; Serial.printf("Zone %s changed\n", ZONES[i].id); break; }
+        }
+    }
+
+    bool sawChanged() const { return seen; }
+
+private:
+    bool* flags;
+    bool seen;
+};
+
 bool fetchChangedZoneList(bool forceAll, bool* changedFlags) {
-    WiFiClientSecure* client = new WiFiClientSecure(); if (!client) return false;
-    client->setInsecure();
+    TlsClient* client = new TlsClient(); if (!client) return false;
     HTTPClient http;
     String url = String(serverUrl) + "/api/zones?batch=0"; if (forceAll) url += "&force=true";
     url.replace("//api", "/api");
@@ -109,34 +138,18 @@ bool fetchChangedZoneList(bool forceAll, bool* changedFlags) {
     http.addHeader("User-Agent", "PTV-TRMNL/" FIRMWARE_VERSION);
     int httpCode = http.GET();
     if (httpCode != 200) { http.end(); delete client; return false; }
-    String payload = http.getString(); Serial.printf("Got payload: %d bytes\n", payload.length()); http.end(); Serial.println("HTTP end"); delete client; Serial.println("Client deleted");
-    // Manual JSON parsing (ArduinoJson crashes on ESP32-C3)
-    Serial.println("Parsing changed zones...");
-    int start = payload.indexOf("\"changed\":");
-    if (start < 0) { Serial.println("No changed field"); return false; }
-    int arrStart = payload.indexOf('[', start);
-    int arrEnd = payload.indexOf(']', arrStart);
-    if (arrStart < 0 || arrEnd < 0) { Serial.println("No array"); return false; }
-    String arr = payload.substring(arrStart + 1, arrEnd);
-    int pos = 0;
-    while (pos < (int)arr.length()) {
-        int q1 = arr.indexOf('"', pos);
-        if (q1 < 0) break;
-        int q2 = arr.indexOf('"', q1 + 1);
-        if (q2 < 0) break;
-        String zid = arr.substring(q1 + 1, q2);
-        for (int i = 0; i < ZONE_COUNT; i++) {
-            if (zid.equals(ZONES[i].id)) { changedFlags[i] = true; Serial.printf("Zone %s changed\n", ZONES[i].id); break; }
-        }
-        pos = q2 + 1;
-    }
-    Serial.println("Parsing done");
+    // Scan the body as it streams in (ArduinoJson crashes on ESP32-C3; no String copy)
+    ChangedZonesHandler handler(changedFlags);
+    JsonStreamParser parser(&handler);
+    JsonStreamWriter writer(parser);
+    int len = http.writeToStream(&writer); Serial.printf("Scanned payload: %d bytes\n", len);
+    http.end(); delete client;
+    if (!handler.sawChanged()) { Serial.println("No changed field"); return false; }
     return true;
 }
 
-bool fetchAndDrawZone(const ZoneDef& zone, bool doFlash) {
-    WiFiClientSecure* client = new WiFiClientSecure(); if (!client) return false;
-    client->setInsecure();
+bool fetchAndDrawZone(const ZoneDef& zone) {
+    TlsClient* client = new TlsClient(); if (!client) return false;
     HTTPClient http;
     String url = String(serverUrl) + "/api/zonedata?id=" + zone.id; url.replace("//api", "/api");
     http.setTimeout(15000);
@@ -162,7 +175,8 @@ bool fetchAndDrawZone(const ZoneDef& zone, bool doFlash) {
     }
     http.end(); delete client;
     if (read != len || zoneBuffer[0] != 'B' || zoneBuffer[1] != 'M') return false;
-    if (doFlash) { bbep.fillRect(zX, zY, zW, zH, BBEP_BLACK); bbep.refresh(REFRESH_PARTIAL, true); delay(30); }
+    drawnWindow = alignPanelWindow(zX, zY, zW, zH, SCREEN_W, SCREEN_H);
+    // No flash to black: the window refresh is differential against the old plane
     Serial.printf("Drawing zone at %d,%d (%dx%d)\n", zX, zY, zW, zH); bool ok = bbep.loadBMP(zoneBuffer, zX, zY, BBEP_BLACK, BBEP_WHITE) == BBEP_SUCCESS; Serial.printf("loadBMP result: %s\n", ok ? "OK" : "FAIL"); return ok;
 }
 
@@ -181,7 +195,7 @@ void showWelcomeScreen() {
     bbep.refresh(REFRESH_FULL, true); lastFullRefresh = millis();
 }
 
-void doFullRefresh() { bbep.refresh(REFRESH_FULL, true); }
+void doFullRefresh() { bbep.refresh(REFRESH_FULL, true); syncPanelOldPlane(&bbep); }
 void loadSettings() { preferences.begin("ptv-trmnl", true); String url = preferences.getString("serverUrl", ""); url.toCharArray(serverUrl, sizeof(serverUrl)); preferences.end(); }
 void saveSettings() { preferences.begin("ptv-trmnl", false); preferences.putString("serverUrl", serverUrl); preferences.end(); }
 void saveParamCallback() { strncpy(serverUrl, customServerUrl.getValue(), sizeof(serverUrl) - 1); saveSettings(); }
@@ -0,0 +1,214 @@
+/**
+ * Host tests and benchmarks for base64.hpp
+ * Run with: pio test -e native -f test_base64
+ *
+ * The benchmark compares against the previous one-character-at-a-time
+ * decoder on zone-sized payloads (8-40 KB of BMP, as base64).
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "base64.hpp"
+
+// ---------------------------------------------------------------------------
+// Previous implementation
+// ---------------------------------------------------------------------------
+
+static int legacyCharValue(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+static size_t legacyDecode(const unsigned char* input, size_t inputLen, unsigned char* output) {
+    size_t outputLen = 0;
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (size_t i = 0; i < inputLen; i++) {
+        char c = input[i];
+        if (c == '\n' || c == '\r' || c == ' ' || c == '\t') continue;
+        if (c == '=') break;
+        int value = legacyCharValue(c);
+        if (value < 0) continue;
+        buffer = (buffer << 6) | value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            output[outputLen++] = (buffer >> bits) & 0xFF;
+        }
+    }
+    return outputLen;
+}
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static std::string encode(const std::vector<uint8_t>& d) {
+    std::string o;
+    size_t i = 0;
+    for (; i + 2 < d.size(); i += 3) {
+        uint32_t v = (d[i] << 16) | (d[i + 1] << 8) | d[i + 2];
+        for (int k = 3; k >= 0; k--) o += base64_chars[(v >> (6 * k)) & 63];
+    }
+    if (d.size() - i == 1) {
+        uint32_t v = d[i] << 16;
+        o += base64_chars[v >> 18];
+        o += base64_chars[(v >> 12) & 63];
+        o += "==";
+    } else if (d.size() - i == 2) {
+        uint32_t v = (d[i] << 16) | (d[i + 1] << 8);
+        o += base64_chars[v >> 18];
+        o += base64_chars[(v >> 12) & 63];
+        o += base64_chars[(v >> 6) & 63];
+        o += '=';
+    }
+    return o;
+}
+
+/** Zone-like payload: BMP header then mostly-white rows with some ink */
+static std::vector<uint8_t> zonePayload(size_t size, unsigned seed) {
+    srand(seed);
+    std::vector<uint8_t> d(size, 0xFF);
+    for (size_t i = 0; i < size; i++) {
+        if (rand() % 4 == 0) d[i] = (uint8_t)rand();
+    }
+    return d;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_matches_legacy_all_lengths(void) {
+    for (size_t n = 0; n < 200; n++) {
+        std::vector<uint8_t> d = zonePayload(n, (unsigned)n);
+        std::string b64 = encode(d);
+        std::vector<uint8_t> a(n + 4), b(n + 4);
+        size_t la = legacyDecode((const unsigned char*)b64.data(), b64.size(), a.data());
+        size_t lb = decode_base64((const unsigned char*)b64.data(), b64.size(), b.data());
+        TEST_ASSERT_EQUAL(n, lb);
+        TEST_ASSERT_EQUAL(la, lb);
+        if (n) TEST_ASSERT_EQUAL_MEMORY(d.data(), b.data(), n);
+        TEST_ASSERT_EQUAL(n, decode_base64_length((const unsigned char*)b64.data(), b64.size()));
+    }
+}
+
+void test_whitespace_and_junk_are_skipped(void) {
+    std::vector<uint8_t> d = zonePayload(300, 7);
+    std::string b64 = encode(d);
+    std::string messy;
+    for (size_t i = 0; i < b64.size(); i++) {
+        messy += b64[i];
+        if (i % 76 == 75) messy += "\r\n";
+        if (i % 37 == 0) messy += ' ';
+    }
+    std::vector<uint8_t> out(messy.size());
+    size_t n = decode_base64((const unsigned char*)messy.data(), messy.size(), out.data());
+    TEST_ASSERT_EQUAL(d.size(), n);
+    TEST_ASSERT_EQUAL_MEMORY(d.data(), out.data(), n);
+}
+
+void test_stops_at_padding(void) {
+    std::string s = "TWE=TWFu";
+    unsigned char out[8];
+    TEST_ASSERT_EQUAL(2, (int)decode_base64((const unsigned char*)s.data(), s.size(), out));
+    TEST_ASSERT_EQUAL_MEMORY("Ma", out, 2);
+}
+
+void test_in_place(void) {
+    for (size_t n = 1; n < 2000; n += 97) {
+        std::vector<uint8_t> d = zonePayload(n, (unsigned)n);
+        std::string b64 = encode(d);
+        for (size_t offset = 0; offset < 4; offset++) {   // aligned and unaligned
+            std::vector<unsigned char> buf(b64.size() + offset);
+            memcpy(buf.data() + offset, b64.data(), b64.size());
+            unsigned char* p = buf.data() + offset;
+            size_t got = decode_base64(p, b64.size(), p);
+            TEST_ASSERT_EQUAL(n, got);
+            TEST_ASSERT_EQUAL_MEMORY(d.data(), p, n);
+        }
+    }
+}
+
+void test_streaming_any_split(void) {
+    std::vector<uint8_t> d = zonePayload(5000, 99);
+    std::string b64 = encode(d);
+    srand(1);
+    for (int round = 0; round < 50; round++) {
+        Base64StreamDecoder dec;
+        std::vector<uint8_t> out;
+        size_t pos = 0;
+        while (pos < b64.size()) {
+            size_t n = 1 + rand() % 300;
+            if (pos + n > b64.size()) n = b64.size() - pos;
+            unsigned char tmp[(300 * 3) / 4 + 2];
+            size_t got = dec.decode(b64.data() + pos, n, tmp);
+            out.insert(out.end(), tmp, tmp + got);
+            pos += n;
+        }
+        TEST_ASSERT_EQUAL(d.size(), out.size());
+        TEST_ASSERT_EQUAL_MEMORY(d.data(), out.data(), d.size());
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------
+
+template <typename F>
+static double mbPerSec(size_t inputBytes, F fn) {
+    int runs = (int)(200000000 / inputBytes);   // ~200 MB of input per measurement
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) fn();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return (double)inputBytes * runs / secs / 1e6;
+}
+
+void bench_zone_payloads(void) {
+    const size_t sizes[] = { 8 * 1024, 16 * 1024, 24 * 1024, 32 * 1024, 40 * 1024 };
+    for (size_t size : sizes) {
+        std::vector<uint8_t> d = zonePayload(size, (unsigned)size);
+        std::string b64 = encode(d);
+        std::vector<unsigned char> out(b64.size() + 4);
+        std::vector<unsigned char> work(b64.size());
+        volatile size_t sink = 0;
+
+        double legacy = mbPerSec(b64.size(), [&] {
+            sink += legacyDecode((const unsigned char*)b64.data(), b64.size(), out.data());
+        });
+        double table = mbPerSec(b64.size(), [&] {
+            sink += decode_base64((const unsigned char*)b64.data(), b64.size(), out.data());
+        });
+        double inPlace = mbPerSec(b64.size(), [&] {
+            memcpy(work.data(), b64.data(), b64.size());   // restore input (included in time)
+            sink += decode_base64(work.data(), work.size(), work.data());
+        });
+
+        char msg[160];
+        snprintf(msg, sizeof(msg), "%2u KB BMP (%5u chars): legacy %6.1f MB/s, table %6.1f MB/s (%.1fx), in-place+copy %6.1f MB/s",
+                 (unsigned)(size / 1024), (unsigned)b64.size(), legacy, table, table / legacy, inPlace);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_legacy_all_lengths);
+    RUN_TEST(test_whitespace_and_junk_are_skipped);
+    RUN_TEST(test_stops_at_padding);
+    RUN_TEST(test_in_place);
+    RUN_TEST(test_streaming_any_split);
+    RUN_TEST(bench_zone_payloads);
+    return UNITY_END();
+}
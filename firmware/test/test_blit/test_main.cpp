@@ -0,0 +1,175 @@
+/**
+ * Host tests and benchmarks for blit-1bpp.h
+ * Run with: pio test -e native -f test_blit
+ *
+ * Every blit is checked against a per-pixel reference that behaves like
+ * the drawPixel() loops it replaces. The benchmark times a full 800x480
+ * screen both ways.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "blit-1bpp.h"
+
+#define FB_W 800
+#define FB_H 480
+#define FB_PITCH (FB_W / 8)
+
+// ---------------------------------------------------------------------------
+// Reference: bb_epaper-style drawPixel into a 1 = white framebuffer
+// ---------------------------------------------------------------------------
+
+static void drawPixel(uint8_t* fb, int x, int y, bool black) {
+    if (x < 0 || y < 0 || x >= FB_W || y >= FB_H) return;
+    uint8_t* p = fb + y * FB_PITCH + (x >> 3);
+    uint8_t m = 0x80 >> (x & 7);
+    if (black) *p &= ~m;
+    else *p |= m;
+}
+
+static void referenceBlit(uint8_t* fb, int x, int y, const uint8_t* src, int stride,
+                          int w, int h, uint8_t flags) {
+    for (int r = 0; r < h; r++) {
+        const uint8_t* row = src + ((flags & BLIT_FLIP_Y) ? h - 1 - r : r) * stride;
+        for (int c = 0; c < w; c++) {
+            bool bit = row[c >> 3] & (0x80 >> (c & 7));
+            bool black = (flags & BLIT_INVERT) ? bit : !bit;
+            if (black) drawPixel(fb, x + c, y + r, true);
+            else if (!(flags & BLIT_INK_ONLY)) drawPixel(fb, x + c, y + r, false);
+        }
+    }
+}
+
+static std::vector<uint8_t> randomBytes(size_t n, unsigned seed) {
+    std::vector<uint8_t> v(n);
+    srand(seed);
+    for (auto& b : v) b = (uint8_t)rand();
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_matches_reference(void) {
+    const uint8_t flagSets[] = { 0, BLIT_INVERT, BLIT_FLIP_Y, BLIT_INK_ONLY,
+                                 BLIT_INVERT | BLIT_INK_ONLY, BLIT_INVERT | BLIT_FLIP_Y | BLIT_INK_ONLY };
+    unsigned seed = 1;
+    for (int trial = 0; trial < 600; trial++) {
+        int w = 1 + rand() % 200;
+        int h = 1 + rand() % 20;
+        int stride = ((w + 31) / 32) * 4 + (rand() % 3);   // BMP padding and then some
+        int x = rand() % (FB_W - 1);
+        int y = rand() % (FB_H - 1);
+        uint8_t flags = flagSets[trial % 6];
+
+        std::vector<uint8_t> src = randomBytes(stride * h, seed++);
+        std::vector<uint8_t> a = randomBytes(FB_PITCH * FB_H, seed++);
+        std::vector<uint8_t> b = a;
+
+        referenceBlit(a.data(), x, y, src.data(), stride, w, h, flags);
+        blit1bpp(b.data(), FB_PITCH, FB_W, FB_H, x, y, src.data(), stride, w, h, flags);
+
+        if (a != b) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "x=%d y=%d w=%d h=%d stride=%d flags=%d", x, y, w, h, stride, flags);
+            TEST_FAIL_MESSAGE(msg);
+        }
+    }
+}
+
+void test_clips_to_framebuffer(void) {
+    std::vector<uint8_t> src = randomBytes(40 * 60, 7);
+    std::vector<uint8_t> a(FB_PITCH * FB_H, 0xFF), b = a;
+    referenceBlit(a.data(), 700, 450, src.data(), 40, 300, 60, BLIT_INVERT);
+    blit1bpp(b.data(), FB_PITCH, FB_W, FB_H, 700, 450, src.data(), 40, 300, 60, BLIT_INVERT);
+    TEST_ASSERT_TRUE(a == b);
+
+    std::vector<uint8_t> c(FB_PITCH * FB_H, 0xFF), d = c;
+    referenceBlit(c.data(), 13, -25, src.data(), 40, 300, 60, BLIT_FLIP_Y);
+    blit1bpp(d.data(), FB_PITCH, FB_W, FB_H, 13, -25, src.data(), 40, 300, 60, BLIT_FLIP_Y);
+    TEST_ASSERT_TRUE(c == d);
+
+    TEST_ASSERT_FALSE(blit1bpp(d.data(), FB_PITCH, FB_W, FB_H, FB_W, 0, src.data(), 40, 8, 8));
+}
+
+// Minimal bufferless panel: records what goes through the address window
+struct FakePanel {
+    std::vector<uint8_t> ram = std::vector<uint8_t>(FB_PITCH * FB_H, 0xFF);
+    int wx = 0, wy = 0, ww = 0, pos = 0;
+    int width() { return FB_W; }
+    int height() { return FB_H; }
+    void* getBuffer() { return nullptr; }
+    void setAddrWindow(int x, int y, int w, int) { wx = x; wy = y; ww = w; pos = 0; }
+    void startWrite(int) {}
+    void writeData(uint8_t* p, int n) {
+        int rowBytes = ww / 8;
+        for (int i = 0; i < n; i++, pos++) {
+            ram[(wy + pos / rowBytes) * FB_PITCH + wx / 8 + pos % rowBytes] = p[i];
+        }
+    }
+};
+
+void test_panel_window(void) {
+    std::vector<uint8_t> logo = randomBytes(19 * 150, 11);
+    FakePanel panel;
+    std::vector<uint8_t> ref(FB_PITCH * FB_H, 0xFF);
+    referenceBlit(ref.data(), 325, 15, logo.data(), 19, 150, 150, BLIT_INVERT | BLIT_INK_ONLY);
+    TEST_ASSERT_TRUE(blit1bppToDisplay(&panel, 325, 15, logo.data(), 19, 150, 150,
+                                       BLIT_INVERT | BLIT_INK_ONLY));
+    TEST_ASSERT_TRUE(panel.ram == ref);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------
+
+template <typename F>
+static double msPerRun(int runs, F fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / runs;
+}
+
+void bench_full_screen(void) {
+    // A prerendered screen: 1 = black, about 15% ink
+    std::vector<uint8_t> screen(FB_PITCH * FB_H);
+    srand(3);
+    for (auto& b : screen) b = (rand() % 100 < 15) ? (uint8_t)rand() : 0;
+    std::vector<uint8_t> fb(FB_PITCH * FB_H, 0xFF);
+
+    struct Case { const char* name; int x; uint8_t flags; };
+    const Case cases[] = {
+        { "800x480 x=0 invert+ink", 0, BLIT_INVERT | BLIT_INK_ONLY },
+        { "800x480 x=0 invert", 0, BLIT_INVERT },
+        { "792x480 x=5 invert", 5, BLIT_INVERT },
+    };
+    for (const Case& c : cases) {
+        int w = FB_W - (c.x ? 8 : 0);
+        double pixel = msPerRun(20, [&] {
+            referenceBlit(fb.data(), c.x, 0, screen.data(), FB_PITCH, w, FB_H, c.flags);
+        });
+        double word = msPerRun(500, [&] {
+            blit1bpp(fb.data(), FB_PITCH, FB_W, FB_H, c.x, 0, screen.data(), FB_PITCH, w, FB_H, c.flags);
+        });
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%-24s per-pixel %7.3f ms, blit %6.3f ms (%.0fx)",
+                 c.name, pixel, word, pixel / word);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_reference);
+    RUN_TEST(test_clips_to_framebuffer);
+    RUN_TEST(test_panel_window);
+    RUN_TEST(bench_full_screen);
+    return UNITY_END();
+}
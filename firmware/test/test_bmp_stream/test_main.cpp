@@ -0,0 +1,254 @@
+/**
+ * Host tests for bmp-stream.h
+ * Run with: pio test -e native -f test_bmp_stream
+ *
+ * Random 1-bit BMPs are encoded here (either row order, either palette
+ * order, odd widths) and fed to BmpStreamDecoder in random chunk sizes.
+ * Rows must come out top to bottom with 1 = white, and FramebufferSink
+ * must place them at any x without touching the pixels around them.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "bmp-stream.h"
+
+#define FB_W 800
+#define FB_H 480
+#define FB_PITCH (FB_W / 8)
+
+// ---------------------------------------------------------------------------
+// Test images
+// ---------------------------------------------------------------------------
+
+struct TestImage {
+    int w, h;
+    std::vector<bool> white;             // w*h, top row first
+    bool pixel(int x, int y) const { return white[y * w + x]; }
+};
+
+static TestImage randomImage(int w, int h) {
+    TestImage img;
+    img.w = w;
+    img.h = h;
+    img.white.resize(w * h);
+    for (int i = 0; i < w * h; i++) img.white[i] = rand() & 1;
+    return img;
+}
+
+static void put32(std::vector<uint8_t>& v, size_t at, uint32_t x) {
+    for (int i = 0; i < 4; i++) v[at + i] = (uint8_t)(x >> (8 * i));
+}
+
+/**
+ * 1-bpp BMP of `img`. whiteIsZero puts white at palette index 0 (bits
+ * then mean 1 = black). Pad bits are set to garbage, as encoders may.
+ */
+static std::vector<uint8_t> encodeBmp(const TestImage& img, bool bottomUp, bool whiteIsZero) {
+    int stride = ((img.w + 31) / 32) * 4;
+    size_t offset = 14 + 40 + 8;
+    std::vector<uint8_t> v(offset + stride * img.h, 0);
+    v[0] = 'B';
+    v[1] = 'M';
+    put32(v, 2, v.size());
+    put32(v, 10, offset);
+    put32(v, 14, 40);
+    put32(v, 18, img.w);
+    put32(v, 22, bottomUp ? img.h : (uint32_t)-img.h);
+    v[26] = 1;
+    v[28] = 1;                           // bpp
+    uint8_t light = whiteIsZero ? 0 : 4;
+    v[54 + light] = v[55 + light] = v[56 + light] = 0xFF;
+
+    for (int y = 0; y < img.h; y++) {
+        uint8_t* row = &v[offset + (bottomUp ? img.h - 1 - y : y) * stride];
+        for (int x = 0; x < stride * 8; x++) {
+            bool bit = x < img.w ? img.pixel(x, y) != whiteIsZero : (rand() & 1);
+            if (bit) row[x >> 3] |= 0x80 >> (x & 7);
+        }
+    }
+    return v;
+}
+
+/** Feed in random pieces of 1..maxChunk bytes; the last result */
+static BmpStreamDecoder::Result feedChunked(BmpStreamDecoder& dec, const std::vector<uint8_t>& bmp,
+                                            int maxChunk) {
+    BmpStreamDecoder::Result r = BmpStreamDecoder::NEED_MORE;
+    for (size_t pos = 0; pos < bmp.size() && r == BmpStreamDecoder::NEED_MORE;) {
+        size_t n = 1 + rand() % maxChunk;
+        if (n > bmp.size() - pos) n = bmp.size() - pos;
+        r = dec.feed(&bmp[pos], n);
+        pos += n;
+    }
+    return r;
+}
+
+// Keeps every row it is given, and checks they arrive whole and in range
+struct RowCollector : public BmpRowSink {
+    int w = 0, h = 0, bands = 0, rowsSeen = 0, ends = 0;
+    std::vector<uint8_t> rows;
+    int rowBytes = 0;
+
+    bool begin(int width, int height) override {
+        w = width;
+        h = height;
+        rowBytes = (w + 7) / 8;
+        rows.assign(rowBytes * h, 0);
+        return true;
+    }
+    bool writeRows(int y, int n, const uint8_t* data, int rb) override {
+        TEST_ASSERT_EQUAL(rowBytes, rb);
+        TEST_ASSERT_TRUE(y >= 0 && y + n <= h);
+        memcpy(&rows[y * rowBytes], data, n * rowBytes);
+        bands++;
+        rowsSeen += n;
+        return true;
+    }
+    void end() override { ends++; }
+
+    bool pixel(int x, int y) const { return rows[y * rowBytes + (x >> 3)] & (0x80 >> (x & 7)); }
+};
+
+static bool fbPixel(const std::vector<uint8_t>& fb, int x, int y) {
+    return fb[y * FB_PITCH + (x >> 3)] & (0x80 >> (x & 7));
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_row_orders_and_palettes(void) {
+    srand(1);
+    uint8_t band[64];                    // a few rows per band: many bands
+    for (int bottomUp = 0; bottomUp < 2; bottomUp++) {
+        for (int whiteIsZero = 0; whiteIsZero < 2; whiteIsZero++) {
+            TestImage img = randomImage(37, 23);
+            std::vector<uint8_t> bmp = encodeBmp(img, bottomUp, whiteIsZero);
+
+            RowCollector sink;
+            BmpStreamDecoder dec(band, sizeof(band));
+            dec.reset(&sink);
+            TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, dec.feed(bmp.data(), bmp.size()));
+            TEST_ASSERT_EQUAL(37, dec.imageWidth());
+            TEST_ASSERT_EQUAL(23, dec.imageHeight());
+            TEST_ASSERT_EQUAL(23, sink.rowsSeen);
+            TEST_ASSERT_EQUAL(1, sink.ends);
+            TEST_ASSERT_TRUE(sink.bands > 1);
+
+            for (int y = 0; y < img.h; y++) {
+                for (int x = 0; x < img.w; x++) TEST_ASSERT_EQUAL(img.pixel(x, y), sink.pixel(x, y));
+                // Pad bits past the width read as white
+                for (int x = img.w; x < sink.rowBytes * 8; x++) TEST_ASSERT_TRUE(sink.pixel(x, y));
+            }
+        }
+    }
+}
+
+void test_random_images_into_framebuffer(void) {
+    srand(2);
+    std::vector<uint8_t> fb(FB_PITCH * FB_H);
+    std::vector<uint8_t> before;
+    static uint8_t band[BMP_STREAM_BAND_SIZE];
+
+    for (int iter = 0; iter < 200; iter++) {
+        int w = 1 + rand() % 200;
+        int h = 1 + rand() % 60;
+        int x = rand() % (FB_W - w);
+        int y = rand() % (FB_H - h);
+        bool bottomUp = rand() & 1;
+        bool whiteIsZero = rand() & 1;
+        TestImage img = randomImage(w, h);
+        std::vector<uint8_t> bmp = encodeBmp(img, bottomUp, whiteIsZero);
+
+        for (auto& b : fb) b = rand();
+        before = fb;
+
+        FramebufferSink sink(fb.data(), FB_PITCH, FB_H, x, y);
+        BmpStreamDecoder dec(band, sizeof(band));
+        dec.reset(&sink);
+        TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, feedChunked(dec, bmp, 1 + rand() % 300));
+
+        int32_t toggled = 0;
+        for (int py = 0; py < FB_H; py++) {
+            for (int px = 0; px < FB_W; px++) {
+                bool inside = px >= x && px < x + w && py >= y && py < y + h;
+                bool want = inside ? img.pixel(px - x, py - y) : fbPixel(before, px, py);
+                if (fbPixel(fb, px, py) != want) {
+                    char msg[96];
+                    snprintf(msg, sizeof(msg), "iter %d: %dx%d at %d,%d, pixel %d,%d", iter, w, h, x, y, px, py);
+                    TEST_FAIL_MESSAGE(msg);
+                }
+                if (inside && want != fbPixel(before, px, py)) toggled++;
+            }
+        }
+        TEST_ASSERT_EQUAL(toggled, sink.toggledPixels());
+    }
+}
+
+void test_one_byte_at_a_time(void) {
+    srand(3);
+    TestImage img = randomImage(13, 9);
+    std::vector<uint8_t> bmp = encodeBmp(img, true, false);
+    uint8_t band[2];                     // one 13 px row per band
+    RowCollector sink;
+    BmpStreamDecoder dec(band, sizeof(band));
+    dec.reset(&sink);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, feedChunked(dec, bmp, 1));
+    TEST_ASSERT_EQUAL(9, sink.bands);
+    for (int y = 0; y < img.h; y++) {
+        for (int x = 0; x < img.w; x++) TEST_ASSERT_EQUAL(img.pixel(x, y), sink.pixel(x, y));
+    }
+}
+
+void test_rejects_bad_images(void) {
+    srand(4);
+    uint8_t band[BMP_STREAM_BAND_SIZE];
+    TestImage img = randomImage(16, 4);
+    std::vector<uint8_t> good = encodeBmp(img, true, false);
+
+    std::vector<uint8_t> bmp = good;
+    bmp[0] = 'X';                        // magic
+    BmpStreamDecoder dec(band, sizeof(band));
+    dec.reset(nullptr);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, dec.feed(bmp.data(), bmp.size()));
+
+    bmp = good;
+    bmp[28] = 24;                        // not 1 bpp
+    dec.reset(nullptr);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, dec.feed(bmp.data(), bmp.size()));
+
+    bmp = good;
+    bmp[30] = 1;                         // compressed
+    dec.reset(nullptr);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, dec.feed(bmp.data(), bmp.size()));
+
+    // Row wider than the band
+    uint8_t tiny[1];
+    BmpStreamDecoder small(tiny, sizeof(tiny));
+    small.reset(nullptr);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, small.feed(good.data(), good.size()));
+
+    // Truncated: still waiting, never done
+    dec.reset(nullptr);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::NEED_MORE, dec.feed(good.data(), good.size() - 1));
+    TEST_ASSERT_FALSE(dec.done());
+
+    // Off the framebuffer
+    std::vector<uint8_t> fb(FB_PITCH * FB_H, 0xFF);
+    FramebufferSink off(fb.data(), FB_PITCH, FB_H, FB_W - 8, 0);
+    dec.reset(&off);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, dec.feed(good.data(), good.size()));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_row_orders_and_palettes);
+    RUN_TEST(test_random_images_into_framebuffer);
+    RUN_TEST(test_one_byte_at_a_time);
+    RUN_TEST(test_rejects_bad_images);
+    return UNITY_END();
+}
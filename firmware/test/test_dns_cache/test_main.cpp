@@ -0,0 +1,143 @@
+/**
+ * Host tests for dns-cache.h
+ * Run with: pio test -e native -f test_dns_cache
+ *
+ * Builds a query and parses hand-assembled responses (CNAME chains, name
+ * compression, errors), and checks the cache's TTL clamping, expiry and
+ * slot reuse on a plain RtcBlock.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <vector>
+#include "dns-cache.h"
+
+static const char* HOST = "einkptdashboard.vercel.app";
+
+static void put16(std::vector<uint8_t>& m, uint16_t v) {
+    m.push_back(v >> 8);
+    m.push_back(v & 0xFF);
+}
+
+static void put32(std::vector<uint8_t>& m, uint32_t v) {
+    put16(m, v >> 16);
+    put16(m, v & 0xFFFF);
+}
+
+// The query echoed back with `an` answers appended by the caller
+static std::vector<uint8_t> responseHead(uint16_t id, int an, uint8_t rcode = 0) {
+    uint8_t q[DNS_MSG_MAX];
+    int n = dnsBuildQuery(q, sizeof(q), id, HOST);
+    std::vector<uint8_t> m(q, q + n);
+    m[2] |= 0x80;                    // QR
+    m[3] = 0x80 | rcode;             // RA
+    m[7] = an;
+    return m;
+}
+
+static void answer(std::vector<uint8_t>& m, uint16_t type, uint32_t ttl, const std::vector<uint8_t>& rdata) {
+    put16(m, 0xC00C);                // name: pointer to the question
+    put16(m, type);
+    put16(m, 1);
+    put32(m, ttl);
+    put16(m, rdata.size());
+    m.insert(m.end(), rdata.begin(), rdata.end());
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_build_query(void) {
+    uint8_t q[DNS_MSG_MAX];
+    int n = dnsBuildQuery(q, sizeof(q), 0xBEEF, "a.bc");
+    const uint8_t expect[] = { 0xBE, 0xEF, 0x01, 0, 0, 1, 0, 0, 0, 0, 0, 0,
+                               1, 'a', 2, 'b', 'c', 0, 0, 1, 0, 1 };
+    TEST_ASSERT_EQUAL((int)sizeof(expect), n);
+    TEST_ASSERT_EQUAL(0, memcmp(q, expect, sizeof(expect)));
+
+    TEST_ASSERT_EQUAL(-1, dnsBuildQuery(q, sizeof(q), 1, "bad..name"));
+    TEST_ASSERT_EQUAL(-1, dnsBuildQuery(q, 10, 1, HOST));
+}
+
+void test_parse_a_record(void) {
+    std::vector<uint8_t> m = responseHead(0x1234, 1);
+    answer(m, 1, 1800, { 76, 76, 21, 21 });
+    uint32_t addr = 0, ttl = 0;
+    TEST_ASSERT_TRUE(dnsParseResponse(m.data(), m.size(), 0x1234, addr, ttl));
+    const uint8_t* b = (const uint8_t*)&addr;
+    TEST_ASSERT_EQUAL(76, b[0]);
+    TEST_ASSERT_EQUAL(21, b[3]);
+    TEST_ASSERT_EQUAL(1800, (int)ttl);
+
+    // Wrong id, truncated, or an error code: no answer
+    TEST_ASSERT_FALSE(dnsParseResponse(m.data(), m.size(), 0x1235, addr, ttl));
+    TEST_ASSERT_FALSE(dnsParseResponse(m.data(), m.size() - 2, 0x1234, addr, ttl));
+    std::vector<uint8_t> nx = responseHead(0x1234, 0, 3);
+    TEST_ASSERT_FALSE(dnsParseResponse(nx.data(), nx.size(), 0x1234, addr, ttl));
+}
+
+void test_parse_cname_chain_takes_lowest_ttl(void) {
+    std::vector<uint8_t> m = responseHead(7, 2);
+    answer(m, 5, 60, { 3, 'c', 'd', 'n', 0xC0, 0x0C });    // CNAME, compressed tail
+    answer(m, 1, 3600, { 10, 0, 0, 9 });
+    uint32_t addr = 0, ttl = 0;
+    TEST_ASSERT_TRUE(dnsParseResponse(m.data(), m.size(), 7, addr, ttl));
+    TEST_ASSERT_EQUAL(9, ((const uint8_t*)&addr)[3]);
+    TEST_ASSERT_EQUAL(60, (int)ttl);
+}
+
+void test_cache_expiry_and_clamp(void) {
+    static RtcBlock<DnsCacheTable> slot;
+    memset(&slot, 0x5A, sizeof(slot));         // power-on garbage
+    DnsCache cache(slot);
+    uint32_t addr = 0;
+    TEST_ASSERT_FALSE(cache.lookup(HOST, 0, addr));
+
+    // A 60 s TTL is held for the floor
+    cache.store(HOST, 0x01020304, 60, 1000);
+    TEST_ASSERT_TRUE(cache.lookup(HOST, 1000 + DNS_CACHE_MIN_TTL_S * 1000ULL - 1, addr));
+    TEST_ASSERT_EQUAL(0x01020304, (int)addr);
+    TEST_ASSERT_FALSE(cache.lookup(HOST, 1000 + DNS_CACHE_MIN_TTL_S * 1000ULL, addr));
+
+    cache.store(HOST, 0x05060708, 1000000, 0);
+    TEST_ASSERT_TRUE(cache.lookup(HOST, DNS_CACHE_MAX_TTL_S * 1000ULL - 1, addr));
+    TEST_ASSERT_FALSE(cache.lookup(HOST, DNS_CACHE_MAX_TTL_S * 1000ULL, addr));
+
+    cache.forget(HOST);
+    TEST_ASSERT_FALSE(cache.lookup(HOST, 0, addr));
+    TEST_ASSERT_TRUE(slot.valid());
+}
+
+void test_cache_slots(void) {
+    static RtcBlock<DnsCacheTable> slot;
+    slot.clear();
+    DnsCache cache(slot);
+    cache.store("a.example", 1, 600, 0);
+    cache.store("b.example", 2, 1200, 0);
+    cache.store("a.example", 3, 900, 0);       // same name reuses its slot
+    uint32_t addr;
+    TEST_ASSERT_TRUE(cache.lookup("a.example", 1, addr));
+    TEST_ASSERT_EQUAL(3, (int)addr);
+    TEST_ASSERT_TRUE(cache.lookup("b.example", 1, addr));
+
+    // Table full: the entry expiring first (a) makes room
+    cache.store("c.example", 4, 600, 10);
+    TEST_ASSERT_TRUE(cache.lookup("c.example", 11, addr));
+    TEST_ASSERT_EQUAL(4, (int)addr);
+    TEST_ASSERT_FALSE(cache.lookup("a.example", 11, addr));
+    TEST_ASSERT_TRUE(cache.lookup("b.example", 11, addr));
+    TEST_ASSERT_EQUAL(2, (int)addr);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_build_query);
+    RUN_TEST(test_parse_a_record);
+    RUN_TEST(test_parse_cname_chain_takes_lowest_ttl);
+    RUN_TEST(test_cache_expiry_and_clamp);
+    RUN_TEST(test_cache_slots);
+    return UNITY_END();
+}
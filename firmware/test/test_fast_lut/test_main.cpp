@@ -0,0 +1,119 @@
+/**
+ * Host tests for fast-lut.h
+ * Run with: pio test -e native -f test_fast_lut
+ *
+ * A fake panel logs commands, LUT payloads and plane writes, so the tests
+ * can check the register tables and the order of a fast refresh: new
+ * plane, LUTs, refresh command, BUSY wait, old plane, window restore.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "fast-lut.h"
+
+#define PANEL_W 800
+#define PANEL_H 480
+#define PITCH (PANEL_W / 8)
+
+struct FakePanel {
+    std::vector<uint8_t> fb;             // empty = bufferless
+    std::string log;                     // one letter per step
+    std::vector<uint8_t> lastCmd;
+    std::vector<std::vector<uint8_t>> luts;
+    int wx = 0, wy = 0, ww = PANEL_W, wh = PANEL_H, plane = -1;
+    int planeBytes[2] = { 0, 0 };
+
+    int width() { return PANEL_W; }
+    int height() { return PANEL_H; }
+    void* getBuffer() { return fb.empty() ? nullptr : fb.data(); }
+    void setAddrWindow(int x, int y, int w, int h) { wx = x; wy = y; ww = w; wh = h; }
+    void startWrite(int p) {
+        plane = p;
+        log += p == PANEL_PLANE_NEW ? 'N' : 'O';
+    }
+    void writeCmd(uint8_t c) {
+        lastCmd.push_back(c);
+        plane = -1;
+        if (c == FAST_CMD_REFRESH) log += 'R';
+    }
+    void writeData(uint8_t* p, int n) {
+        if (plane < 0) {
+            luts.push_back(std::vector<uint8_t>(p, p + n));
+            log += 'L';
+        } else {
+            planeBytes[plane] += n;
+        }
+    }
+    int refresh(int mode, bool) { log += 'X'; return mode; }   // must not be used
+};
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_lut_table(void) {
+    uint8_t lut[FAST_LUT_LEN];
+    memset(lut, 0xAA, sizeof(lut));
+    fastLutTable(lut, FAST_LEVEL_BLACK);
+    TEST_ASSERT_EQUAL_HEX8(FAST_LEVEL_BLACK, lut[0]);
+    TEST_ASSERT_EQUAL(FAST_LUT_FRAMES, lut[1]);
+    TEST_ASSERT_EQUAL(1, lut[5]);
+    for (int i = 6; i < FAST_LUT_LEN; i++) TEST_ASSERT_EQUAL(0, lut[i]);
+}
+
+void test_framebuffer_sequence(void) {
+    FakePanel panel;
+    panel.fb.assign(PITCH * PANEL_H, 0xFF);
+    PanelWindow win = alignPanelWindow(600, 20, 180, 60, PANEL_W, PANEL_H);
+    bool waited = false;
+    std::string atWait;
+    TEST_ASSERT_EQUAL(0, refreshPanelWindowFast(&panel, win, [&]() { waited = true; atWait = panel.log; }));
+
+    TEST_ASSERT_TRUE(waited);
+    TEST_ASSERT_EQUAL_STRING("NLLLLLR", atWait.c_str());
+    TEST_ASSERT_EQUAL_STRING("NLLLLLRO", panel.log.c_str());
+
+    // Both planes get exactly the window
+    int bytes = (win.w / 8) * win.h;
+    TEST_ASSERT_EQUAL(bytes, panel.planeBytes[PANEL_PLANE_NEW]);
+    TEST_ASSERT_EQUAL(bytes, panel.planeBytes[PANEL_PLANE_OLD]);
+
+    // Registers in order, W->K drives black, K->W drives white
+    const uint8_t regs[] = { FAST_LUT_VCOM, FAST_LUT_WW, FAST_LUT_KW, FAST_LUT_WK, FAST_LUT_KK, FAST_CMD_REFRESH };
+    TEST_ASSERT_EQUAL(6, (int)panel.lastCmd.size());
+    for (int i = 0; i < 6; i++) TEST_ASSERT_EQUAL_HEX8(regs[i], panel.lastCmd[i]);
+    TEST_ASSERT_EQUAL(5, (int)panel.luts.size());
+    TEST_ASSERT_EQUAL(FAST_LUT_LEN, (int)panel.luts[0].size());
+    TEST_ASSERT_EQUAL_HEX8(FAST_LEVEL_HOLD, panel.luts[1][0]);
+    TEST_ASSERT_EQUAL_HEX8(FAST_LEVEL_WHITE, panel.luts[2][0]);
+    TEST_ASSERT_EQUAL_HEX8(FAST_LEVEL_BLACK, panel.luts[3][0]);
+
+    TEST_ASSERT_EQUAL(PANEL_W, panel.ww);
+    TEST_ASSERT_EQUAL(PANEL_H, panel.wh);
+}
+
+void test_bufferless_sets_window_only(void) {
+    FakePanel panel;
+    PanelWindow win = alignPanelWindow(0, 96, 800, 28, PANEL_W, PANEL_H);
+    int waits = 0;
+    refreshPanelWindowFast(&panel, win, [&]() { waits++; });
+    TEST_ASSERT_EQUAL(1, waits);
+    TEST_ASSERT_EQUAL_STRING("LLLLLR", panel.log.c_str());
+    TEST_ASSERT_EQUAL(0, panel.planeBytes[0] + panel.planeBytes[1]);
+    TEST_ASSERT_EQUAL(0, panel.wy);
+
+    TEST_ASSERT_EQUAL(-1, refreshPanelWindowFast(&panel, PanelWindow{ 0, 0, 0, 0 }, [&]() { waits++; }));
+    TEST_ASSERT_EQUAL(1, waits);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lut_table);
+    RUN_TEST(test_framebuffer_sequence);
+    RUN_TEST(test_bufferless_sets_window_only);
+    return UNITY_END();
+}
@@ -0,0 +1,124 @@
+/**
+ * Host tests for ghost-tracker.h
+ * Run with: pio test -e native -f test_ghost_tracker
+ *
+ * Simulates a day of minute updates on the main.cpp layout: the clock
+ * header changes every minute, the legs every few minutes. Checks that
+ * only the busy zone is cleaned and that the whole-screen full refresh
+ * waits for an idle period.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include "ghost-tracker.h"
+
+#define MINUTE 60000UL
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_score_grows_with_toggles(void) {
+    GhostTracker g;
+    g.noteUpdate("header", 0, 0, 800, 94, 0);
+    TEST_ASSERT_EQUAL(GHOST_UPDATE_COST, g.score("header"));
+    g.noteUpdate("legs", 0, 132, 800, 316, 800 * 316);
+    TEST_ASSERT_EQUAL(GHOST_UPDATE_COST + GHOST_TOGGLE_COST, g.score("legs"));
+    g.noteUpdate("legs", 0, 132, 800, 316, 800 * 316 / 2);
+    TEST_ASSERT_EQUAL(2 * GHOST_UPDATE_COST + GHOST_TOGGLE_COST * 3 / 2, g.score("legs"));
+    TEST_ASSERT_EQUAL(0, g.score("footer"));
+}
+
+void test_busy_zone_cleaned_alone(void) {
+    GhostTracker g;
+    int cleans = 0;
+    for (int minute = 0; minute < 100; minute++) {
+        // Minute digits: a small delta rect inside the header
+        g.noteUpdate("header", 0, 0, 800, 94, 48 * 24);
+        if (minute % 5 == 0) g.noteUpdate("legs", 0, 132, 800, 316, 800 * 40);
+        const GhostZone* z = g.zoneToClean();
+        if (z) {
+            TEST_ASSERT_EQUAL_STRING("header", z->id);
+            TEST_ASSERT_EQUAL(94, z->h);
+            g.noteCleaned(z->id);
+            cleans++;
+        }
+    }
+    // ~30 light updates per budget
+    TEST_ASSERT_TRUE(cleans >= 3 && cleans <= 4);
+    TEST_ASSERT_TRUE(g.score("legs") < GHOST_ZONE_BUDGET);
+}
+
+void test_whole_refresh_waits_for_idle(void) {
+    GhostTracker g;
+    for (int i = 0; i < 20; i++) g.noteUpdate("header", 0, 0, 800, 94, 1000);
+    TEST_ASSERT_TRUE(g.debt() >= GHOST_WHOLE_BUDGET);
+    TEST_ASSERT_FALSE(g.wholeDue(false, 30 * MINUTE));
+    TEST_ASSERT_TRUE(g.wholeDue(true, 30 * MINUTE));
+
+    // Too little debt: no reason to blank the screen even when idle
+    GhostTracker quiet;
+    quiet.noteUpdate("footer", 0, 448, 800, 32, 10);
+    TEST_ASSERT_FALSE(quiet.wholeDue(true, 60 * MINUTE));
+
+    // Never idle: forced after GHOST_FULL_MAX_MS
+    TEST_ASSERT_TRUE(quiet.wholeDue(false, GHOST_FULL_MAX_MS));
+}
+
+void test_clean_leaves_residue_and_reset_clears(void) {
+    GhostTracker g;
+    for (int i = 0; i < 40; i++) g.noteUpdate("summary", 0, 96, 800, 28, 0);
+    const GhostZone* z = g.zoneToClean();
+    TEST_ASSERT_NOT_NULL(z);
+    g.noteCleaned(z->id);
+    TEST_ASSERT_EQUAL(0, g.score("summary"));
+    TEST_ASSERT_EQUAL(GHOST_CLEAN_RESIDUE, g.debt());
+    TEST_ASSERT_NULL(g.zoneToClean());
+
+    g.reset();
+    TEST_ASSERT_EQUAL(0, g.debt());
+}
+
+void test_fast_run_forces_normal_update(void) {
+    GhostTracker g;
+    TEST_ASSERT_TRUE(g.fastAllowed("header"));
+    for (int i = 0; i < GHOST_FAST_MAX; i++) {
+        TEST_ASSERT_TRUE(g.fastAllowed("header"));
+        g.noteUpdate("header", 0, 0, 800, 94, 0, true);
+    }
+    TEST_ASSERT_FALSE(g.fastAllowed("header"));
+    TEST_ASSERT_EQUAL(GHOST_FAST_MAX * (GHOST_UPDATE_COST + GHOST_FAST_COST), g.score("header"));
+
+    // One normal update and the run starts again
+    g.noteUpdate("header", 0, 0, 800, 94, 0);
+    TEST_ASSERT_TRUE(g.fastAllowed("header"));
+
+    for (int i = 0; i < GHOST_FAST_MAX; i++) g.noteUpdate("header", 0, 0, 800, 94, 0, true);
+    g.noteCleaned("header");
+    TEST_ASSERT_TRUE(g.fastAllowed("header"));
+}
+
+void test_slots_full(void) {
+    GhostTracker g;
+    char id[8];
+    for (int i = 0; i < GHOST_SLOTS + 3; i++) {
+        snprintf(id, sizeof(id), "z%d", i);
+        g.noteUpdate(id, 0, 0, 8, 8, 64);
+    }
+    TEST_ASSERT_EQUAL(0, g.score("z13"));     // dropped, not crashed
+    TEST_ASSERT_EQUAL((uint32_t)GHOST_SLOTS * (GHOST_UPDATE_COST + GHOST_TOGGLE_COST), g.debt());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_score_grows_with_toggles);
+    RUN_TEST(test_busy_zone_cleaned_alone);
+    RUN_TEST(test_whole_refresh_waits_for_idle);
+    RUN_TEST(test_clean_leaves_residue_and_reset_clears);
+    RUN_TEST(test_fast_run_forces_normal_update);
+    RUN_TEST(test_slots_full);
+    return UNITY_END();
+}
@@ -0,0 +1,129 @@
+/**
+ * Host tests for idle-sleep.h
+ * Run with: pio test -e native -f test_idle_sleep
+ *
+ * A fake clock advances by whatever the idle loop waits, so the tests can
+ * check that it sleeps up to the deadline in bounded slices, that the
+ * button and keepWaiting() end it early, and the lateness bookkeeping.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include "idle-sleep.h"
+
+static unsigned long fakeNow;
+static unsigned long overshoot;      // extra time each wait takes (wake-up latency)
+static int waits;
+static uint32_t longestWait;
+static unsigned long pressAt;        // 0: never
+static bool wifiUp;
+static IdleSleep* pressing;
+
+static unsigned long fakeClock() { return fakeNow; }
+
+static void fakeWait(uint32_t ms) {
+    waits++;
+    if (ms > longestWait) longestWait = ms;
+    fakeNow += ms + overshoot;
+}
+
+static bool fakeButton() { return pressAt && fakeNow >= pressAt; }
+static bool fakeWifi() { return wifiUp; }
+
+static void reset(IdleSleep& idle, unsigned long t) {
+    idle = IdleSleep();
+    idle.clockMs = fakeClock;
+    idle.waitMs = fakeWait;
+    idle.buttonDown = fakeButton;
+    fakeNow = t;
+    overshoot = 0;
+    waits = 0;
+    longestWait = 0;
+    pressAt = 0;
+    wifiUp = true;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_sleeps_until_deadline_in_slices(void) {
+    IdleSleep idle;
+    reset(idle, 1000);
+    TEST_ASSERT_FALSE(idle.idleUntil(1000 + 57000, false));
+    TEST_ASSERT_TRUE(idle.lastIdled());
+    TEST_ASSERT_EQUAL(58000, (int)fakeNow);
+    TEST_ASSERT_TRUE(longestWait <= IDLE_SLICE_MS);
+    TEST_ASSERT_EQUAL((57000 + IDLE_SLICE_MS - 1) / IDLE_SLICE_MS, waits);
+    TEST_ASSERT_EQUAL(57000, (int)idle.stats().lastIdleMs);
+    TEST_ASSERT_EQUAL(0, (int)idle.stats().lastLateMs);
+    TEST_ASSERT_EQUAL(IdleSleep::IDLE_DELAY, idle.lastMode());   // no power management on the host
+}
+
+void test_lateness_is_recorded(void) {
+    IdleSleep idle;
+    reset(idle, 0);
+    overshoot = 12;
+    idle.idleUntil(3000, true);
+    TEST_ASSERT_EQUAL(12, (int)idle.stats().lastLateMs);
+    TEST_ASSERT_EQUAL(12, (int)idle.stats().maxLateMs);
+    TEST_ASSERT_EQUAL(1, (int)idle.stats().periods);
+}
+
+void test_button_and_wifi_end_the_wait(void) {
+    IdleSleep idle;
+    reset(idle, 0);
+    pressAt = 12000;
+    TEST_ASSERT_TRUE(idle.idleUntil(60000, true));
+    TEST_ASSERT_TRUE(fakeNow >= 12000 && fakeNow < 12000 + IDLE_SLICE_MS);
+    TEST_ASSERT_EQUAL(1, (int)idle.stats().buttonWakes);
+
+    // A press seen only by the ISR (released before the wait returns)
+    reset(idle, 0);
+    pressing = &idle;
+    idle.waitMs = [](uint32_t) {
+        fakeNow += 1000;
+        pressing->press();
+    };
+    idle.buttonDown = nullptr;
+    TEST_ASSERT_TRUE(idle.idleUntil(60000, true));
+    TEST_ASSERT_EQUAL(1000, (int)fakeNow);
+
+    // Lost association: back to the caller to reconnect
+    reset(idle, 0);
+    wifiUp = false;
+    TEST_ASSERT_FALSE(idle.idleUntil(60000, true, fakeWifi));
+    TEST_ASSERT_EQUAL(0, (int)fakeNow);
+}
+
+void test_short_or_held_waits_do_not_sleep(void) {
+    IdleSleep idle;
+    reset(idle, 5000);
+    idle.idleUntil(5000 + IDLE_MIN_MS - 1, true);
+    TEST_ASSERT_FALSE(idle.lastIdled());
+    TEST_ASSERT_EQUAL(5000 + IDLE_MIN_MS - 1, (int)fakeNow);
+    TEST_ASSERT_EQUAL(0, (int)idle.stats().periods);
+
+    // Deadline already passed: nothing to wait for
+    idle.idleUntil(4000, true);
+    TEST_ASSERT_EQUAL(5000 + IDLE_MIN_MS - 1, (int)fakeNow);
+
+    // Button held: plain wait of one slice at most, no sleep
+    reset(idle, 0);
+    pressAt = 1;
+    fakeNow = 1;
+    TEST_ASSERT_FALSE(idle.idleUntil(60000, true));
+    TEST_ASSERT_FALSE(idle.lastIdled());
+    TEST_ASSERT_EQUAL(1 + IDLE_SLICE_MS, (int)fakeNow);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sleeps_until_deadline_in_slices);
+    RUN_TEST(test_lateness_is_recorded);
+    RUN_TEST(test_button_and_wifi_end_the_wait);
+    RUN_TEST(test_short_or_held_waits_do_not_sleep);
+    return UNITY_END();
+}
@@ -0,0 +1,280 @@
+/**
+ * Host tests and benchmarks for json-stream.h
+ * Run with: pio test -e native -f test_json_stream
+ *
+ * The benchmarks compare against std::string ports of the scanners this
+ * replaced (main.cpp jsonGetString, zones-v12 "changed":[...] scan).
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "json-stream.h"
+
+// ---------------------------------------------------------------------------
+// Previous implementations (semantics kept, Arduino String -> std::string)
+// ---------------------------------------------------------------------------
+
+static std::string legacyJsonGetString(const std::string& json, const char* key) {
+    std::string search = std::string("\"") + key + "\":\"";
+    size_t start = json.find(search);
+    if (start == std::string::npos) return "";
+    start += search.length();
+    size_t end = json.find("\"", start);
+    if (end == std::string::npos) return "";
+    return json.substr(start, end - start);
+}
+
+static int legacyChangedScan(const std::string& payload, std::vector<std::string>& out) {
+    size_t start = payload.find("\"changed\":");
+    if (start == std::string::npos) return -1;
+    size_t arrStart = payload.find('[', start);
+    size_t arrEnd = payload.find(']', arrStart);
+    if (arrStart == std::string::npos || arrEnd == std::string::npos) return -1;
+    std::string arr = payload.substr(arrStart + 1, arrEnd - arrStart - 1);
+    size_t pos = 0;
+    while (pos < arr.length()) {
+        size_t q1 = arr.find('"', pos);
+        if (q1 == std::string::npos) break;
+        size_t q2 = arr.find('"', q1 + 1);
+        if (q2 == std::string::npos) break;
+        out.push_back(arr.substr(q1 + 1, q2 - q1 - 1));
+        pos = q2 + 1;
+    }
+    return (int)out.size();
+}
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+struct Recorder : public JsonPathHandler {
+    std::vector<std::string> events;
+    void onValue(const char* p, const char* v, bool isString) override {
+        events.push_back(std::string(p) + "=" + v + (isString ? "" : "#"));
+    }
+    void onEnter(const char* p, bool isArray) override {
+        events.push_back(std::string(isArray ? "[ " : "{ ") + p);
+    }
+    void onLeave(const char* p, bool isArray) override {
+        events.push_back(std::string(isArray ? "] " : "} ") + p);
+    }
+};
+
+struct ChangedCollector : public JsonPathHandler {
+    std::vector<std::string> ids;
+    void onValue(const char* p, const char* v, bool) override {
+        if (strcmp(p, "changed[]") == 0) ids.push_back(v);
+    }
+};
+
+static std::vector<std::string> record(const std::string& json, size_t chunk) {
+    Recorder rec;
+    JsonStreamParser parser(&rec);
+    for (size_t i = 0; i < json.size(); i += chunk) {
+        parser.feed(json.data() + i, std::min(chunk, json.size() - i));
+    }
+    TEST_ASSERT_TRUE(parser.complete());
+    return rec.events;
+}
+
+static std::string find(const std::string& json, const char* path) {
+    char out[256];
+    if (!jsonFindString(json.data(), json.size(), path, out, sizeof(out))) return "<missing>";
+    return out;
+}
+
+static const char* PAIR_JSON =
+    "{\"success\":true,\"status\":\"paired\",\"message\":\"Device paired successfully\","
+    "\"webhookUrl\":\"https://einkptdashboard.vercel.app/api/device/eyJhZGRyZXNzZXMiOnsiaG9tZSI6IjEgQ2xhcmVuZG9uIFN0In19\"}";
+
+static const char* ZONES_JSON =
+    "{\"timestamp\":\"2026-01-29T07:41:00.000Z\",\"changed\":[\"time\",\"trains\",\"coffee\"],"
+    "\"zones\":[{\"id\":\"time\",\"x\":20,\"y\":45,\"w\":180,\"h\":70,\"tier\":1},"
+    "{\"id\":\"trains\",\"x\":20,\"y\":155,\"w\":370,\"h\":150,\"tier\":1}]}";
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_find_top_level_fields(void) {
+    TEST_ASSERT_EQUAL_STRING("paired", find(PAIR_JSON, "status").c_str());
+    TEST_ASSERT_EQUAL_STRING(legacyJsonGetString(PAIR_JSON, "webhookUrl").c_str(),
+                             find(PAIR_JSON, "webhookUrl").c_str());
+    TEST_ASSERT_EQUAL_STRING("true", find(PAIR_JSON, "success").c_str());
+    TEST_ASSERT_EQUAL_STRING("<missing>", find(PAIR_JSON, "device").c_str());
+}
+
+void test_find_ignores_nested_and_reordered_keys(void) {
+    std::string json = "{ \"meta\" : {\"status\":\"pending\"} ,\n \"status\" : \"paired\" }";
+    TEST_ASSERT_EQUAL_STRING("paired", find(json, "status").c_str());
+    TEST_ASSERT_EQUAL_STRING("pending", find(json, "meta.status").c_str());
+    // The old scanner took the first match at any depth
+    TEST_ASSERT_EQUAL_STRING("pending", legacyJsonGetString(json, "status").c_str());
+}
+
+void test_find_handles_escapes(void) {
+    std::string json = "{\"webhookUrl\":\"https:\\/\\/x.app\\/api\\/d\\/\\\"q\\\"\",\"s\":\"caf\\u00e9\"}";
+    TEST_ASSERT_EQUAL_STRING("https://x.app/api/d/\"q\"", find(json, "webhookUrl").c_str());
+    TEST_ASSERT_EQUAL_STRING("caf\xc3\xa9", find(json, "s").c_str());
+}
+
+void test_find_streams_long_strings(void) {
+    std::string url(200, 'a');
+    std::string json = "{\"webhookUrl\":\"" + url + "\"}";
+    TEST_ASSERT_EQUAL_STRING(url.c_str(), find(json, "webhookUrl").c_str());
+
+    char small[8];
+    TEST_ASSERT_TRUE(jsonFindString(json.data(), json.size(), "webhookUrl", small, sizeof(small)));
+    TEST_ASSERT_EQUAL_STRING("aaaaaaa", small);
+}
+
+void test_changed_array(void) {
+    ChangedCollector c;
+    JsonStreamParser parser(&c);
+    std::string json = std::string(ZONES_JSON);
+    parser.feed(json.data(), json.size());
+    TEST_ASSERT_EQUAL(3, (int)c.ids.size());
+    TEST_ASSERT_EQUAL_STRING("time", c.ids[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("coffee", c.ids[2].c_str());
+
+    // An escaped quote broke the old scan; a "]" inside a string ended it early
+    ChangedCollector c2;
+    parser.reset(&c2);
+    std::string tricky = "{\"changed\":[\"a\\\"b\",\"x]y\",\"z\"]}";
+    parser.feed(tricky.data(), tricky.size());
+    TEST_ASSERT_EQUAL(3, (int)c2.ids.size());
+    TEST_ASSERT_EQUAL_STRING("a\"b", c2.ids[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("x]y", c2.ids[1].c_str());
+}
+
+void test_zone_paths(void) {
+    std::vector<std::string> ev = record(ZONES_JSON, 4096);
+    const char* expected[] = {
+        "{ ", "timestamp=2026-01-29T07:41:00.000Z",
+        "[ changed", "changed[]=time", "changed[]=trains", "changed[]=coffee", "] changed",
+        "[ zones", "{ zones[]", "zones[].id=time", "zones[].x=20#", "zones[].y=45#",
+        "zones[].w=180#", "zones[].h=70#", "zones[].tier=1#", "} zones[]",
+        "{ zones[]", "zones[].id=trains", "zones[].x=20#", "zones[].y=155#",
+        "zones[].w=370#", "zones[].h=150#", "zones[].tier=1#", "} zones[]",
+        "] zones", "} ",
+    };
+    TEST_ASSERT_EQUAL((int)(sizeof(expected) / sizeof(expected[0])), (int)ev.size());
+    for (size_t i = 0; i < ev.size(); i++) {
+        TEST_ASSERT_EQUAL_STRING(expected[i], ev[i].c_str());
+    }
+}
+
+void test_chunking_is_invisible(void) {
+    std::vector<std::string> whole = record(ZONES_JSON, 4096);
+    for (size_t chunk = 1; chunk < 17; chunk++) {
+        std::vector<std::string> split = record(ZONES_JSON, chunk);
+        TEST_ASSERT_EQUAL((int)whole.size(), (int)split.size());
+        for (size_t i = 0; i < whole.size(); i++) {
+            TEST_ASSERT_EQUAL_STRING(whole[i].c_str(), split[i].c_str());
+        }
+    }
+}
+
+void test_nested_arrays_and_literals(void) {
+    std::vector<std::string> ev = record("[1,[true,null],{\"a\":-2.5e3}]", 4096);
+    const char* expected[] = {
+        "[ ", "[]=1#", "[ []", "[][]=true#", "[][]=null#", "] []",
+        "{ []", "[].a=-2.5e3#", "} []", "] ",
+    };
+    TEST_ASSERT_EQUAL((int)(sizeof(expected) / sizeof(expected[0])), (int)ev.size());
+    for (size_t i = 0; i < ev.size(); i++) {
+        TEST_ASSERT_EQUAL_STRING(expected[i], ev[i].c_str());
+    }
+}
+
+void test_malformed_input(void) {
+    JsonStreamParser parser(nullptr);
+    TEST_ASSERT_FALSE(parser.feed("{}}", 3));
+
+    parser.reset(nullptr);
+    TEST_ASSERT_FALSE(parser.feed("\"\\uZZZZ\"", 8));
+
+    parser.reset(nullptr);
+    std::string deep(JSON_STREAM_MAX_DEPTH, '[');
+    TEST_ASSERT_FALSE(parser.feed(deep.data(), deep.size()));
+
+    parser.reset(nullptr);
+    TEST_ASSERT_TRUE(parser.feed("{\"a\":", 5));
+    TEST_ASSERT_FALSE(parser.complete());
+}
+
+// ---------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------
+
+template <typename F>
+static double mbPerSec(size_t bytesPerRun, F fn) {
+    const int runs = 20000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) fn();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return (double)bytesPerRun * runs / secs / 1e6;
+}
+
+void bench_pairing_fields(void) {
+    std::string json = PAIR_JSON;
+    volatile size_t sink = 0;
+    double legacy = mbPerSec(json.size(), [&] {
+        std::string payload(json.data(), json.size());   // http.getString() copy
+        std::string s = legacyJsonGetString(payload, "status");
+        std::string w = legacyJsonGetString(payload, "webhookUrl");
+        sink += s.size() + w.size();
+    });
+    double scanner = mbPerSec(json.size(), [&] {
+        char s[16], w[256];
+        jsonFindString(json.data(), json.size(), "status", s, sizeof(s));
+        jsonFindString(json.data(), json.size(), "webhookUrl", w, sizeof(w));
+        sink += strlen(s) + strlen(w);
+    });
+    char msg[128];
+    snprintf(msg, sizeof(msg), "pairing fields: jsonGetString %.1f MB/s, jsonFindString %.1f MB/s",
+             legacy, scanner);
+    TEST_MESSAGE(msg);
+}
+
+void bench_changed_list(void) {
+    std::string json = ZONES_JSON;
+    volatile size_t sink = 0;
+    double legacy = mbPerSec(json.size(), [&] {
+        std::string payload(json.data(), json.size());   // http.getString() copy
+        std::vector<std::string> ids;
+        sink += legacyChangedScan(payload, ids);
+    });
+    double scanner = mbPerSec(json.size(), [&] {
+        ChangedCollector c;
+        JsonStreamParser parser(&c);
+        parser.feed(json.data(), json.size());
+        sink += c.ids.size();
+    });
+    char msg[128];
+    snprintf(msg, sizeof(msg), "changed list: indexOf scan %.1f MB/s, JsonPathHandler %.1f MB/s",
+             legacy, scanner);
+    TEST_MESSAGE(msg);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_find_top_level_fields);
+    RUN_TEST(test_find_ignores_nested_and_reordered_keys);
+    RUN_TEST(test_find_handles_escapes);
+    RUN_TEST(test_find_streams_long_strings);
+    RUN_TEST(test_changed_array);
+    RUN_TEST(test_zone_paths);
+    RUN_TEST(test_chunking_is_invisible);
+    RUN_TEST(test_nested_arrays_and_literals);
+    RUN_TEST(test_malformed_input);
+    RUN_TEST(bench_pairing_fields);
+    RUN_TEST(bench_changed_list);
+    return UNITY_END();
+}
@@ -0,0 +1,82 @@
+/**
+ * Host tests for next-change.h
+ * Run with: pio test -e native -f test_next_change
+ *
+ * Checks the clamp of hints into refresh delays, the earliest-of-cycle
+ * fold, per-zone lookup in X-Zone-Next-Change, and that a truncated
+ * header never yields a hint for the wrong zone.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include "next-change.h"
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_delay_clamp(void) {
+    TEST_ASSERT_EQUAL_UINT32(60000, nextChangeDelayMs(-1, 60000));          // no hint
+    TEST_ASSERT_EQUAL_UINT32(42000, nextChangeDelayMs(42, 60000));
+    TEST_ASSERT_EQUAL_UINT32(NEXT_CHANGE_MIN_MS, nextChangeDelayMs(0, 60000));
+    TEST_ASSERT_EQUAL_UINT32(NEXT_CHANGE_MIN_MS, nextChangeDelayMs(3, 60000));
+    TEST_ASSERT_EQUAL_UINT32(NEXT_CHANGE_MAX_MS, nextChangeDelayMs(3600, 60000));
+    TEST_ASSERT_EQUAL_UINT32(NEXT_CHANGE_MAX_MS, nextChangeDelayMs(INT32_MAX, 60000));
+}
+
+void test_earliest(void) {
+    TEST_ASSERT_EQUAL(-1, nextChangeEarliest(-1, -1));
+    TEST_ASSERT_EQUAL(30, nextChangeEarliest(-1, 30));
+    TEST_ASSERT_EQUAL(30, nextChangeEarliest(30, -1));
+    TEST_ASSERT_EQUAL(12, nextChangeEarliest(30, 12));
+
+    // Folding a cycle's responses, one without the header
+    int32_t h = -1;
+    h = nextChangeEarliest(h, 3600);
+    h = nextChangeEarliest(h, -1);
+    h = nextChangeEarliest(h, 58);
+    TEST_ASSERT_EQUAL(58, h);
+}
+
+void test_zone_lookup(void) {
+    const char* hints = "header=42,leg1.time=45,leg1=50,footer=3600";
+    TEST_ASSERT_EQUAL(42, zoneHintSeconds(hints, "header"));
+    TEST_ASSERT_EQUAL(45, zoneHintSeconds(hints, "leg1.time"));
+    TEST_ASSERT_EQUAL(50, zoneHintSeconds(hints, "leg1"));              // not leg1.time
+    TEST_ASSERT_EQUAL(3600, zoneHintSeconds(hints, "footer"));
+    TEST_ASSERT_EQUAL(-1, zoneHintSeconds(hints, "head"));              // prefix only
+    TEST_ASSERT_EQUAL(-1, zoneHintSeconds(hints, "status"));
+    TEST_ASSERT_EQUAL(-1, zoneHintSeconds("", "header"));
+}
+
+void test_copy_truncated(void) {
+    char out[ZONE_HINTS_MAX];
+
+    copyZoneHints(out, sizeof(out), "header=42,footer=3600", false);
+    TEST_ASSERT_EQUAL_STRING("header=42,footer=3600", out);
+
+    // Cut by the line reader: last entry dropped
+    copyZoneHints(out, sizeof(out), "header=42,leg1.time=4", true);
+    TEST_ASSERT_EQUAL_STRING("header=42", out);
+
+    // Longer than the buffer: the cut "leg1.time=4..." entry is dropped
+    char small[16];
+    copyZoneHints(small, sizeof(small), "header=42,leg1.time=45", false);
+    TEST_ASSERT_EQUAL_STRING("header=42", small);
+    TEST_ASSERT_EQUAL(-1, zoneHintSeconds(small, "leg1.time"));
+
+    // A single cut entry leaves nothing
+    copyZoneHints(small, sizeof(small), "summary.departures=58", false);
+    TEST_ASSERT_EQUAL_STRING("", small);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_delay_clamp);
+    RUN_TEST(test_earliest);
+    RUN_TEST(test_zone_lookup);
+    RUN_TEST(test_copy_truncated);
+    return UNITY_END();
+}
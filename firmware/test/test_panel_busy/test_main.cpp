@@ -0,0 +1,122 @@
+/**
+ * Host tests for panel-busy.h
+ * Run with: pio test -e native -f test_panel_busy
+ *
+ * A fake clock and BUSY line stand in for millis() and the pin, so the
+ * tests can check that an async refresh returns at once, that busy time
+ * is recorded per refresh type, and the blocking fallback without begin().
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include "panel-busy.h"
+
+#define MODE_FULL 0
+#define MODE_PARTIAL 2
+
+static unsigned long fakeNow;
+static unsigned long busyUntil;
+
+static unsigned long fakeClock() { return fakeNow++; }   // time passes on every look
+static bool fakeLine() { return fakeNow < busyUntil; }
+
+struct FakePanel {
+    int calls = 0;
+    bool lastWait = false;
+    int refresh(int mode, bool wait) {
+        calls++;
+        lastWait = wait;
+        return mode;
+    }
+};
+
+static void useFakeBusy(PanelBusy& b) {
+    b.clockMs = fakeClock;
+    b.lineBusy = fakeLine;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_async_refresh_returns_busy(void) {
+    PanelBusy& busy = panelBusy();
+    useFakeBusy(busy);
+    FakePanel panel;
+    fakeNow = 0;
+    busyUntil = 3500;
+
+    startPanelRefresh(&panel, MODE_FULL);
+    TEST_ASSERT_FALSE(panel.lastWait);
+    TEST_ASSERT_TRUE(busy.pending());
+    TEST_ASSERT_FALSE(busy.poll());
+
+    // Caller keeps working; the refresh ends on its own
+    fakeNow = 3600;
+    TEST_ASSERT_TRUE(busy.poll());
+    TEST_ASSERT_FALSE(busy.pending());
+    TEST_ASSERT_EQUAL(1, busy.stats(MODE_FULL).count);
+    TEST_ASSERT_TRUE(busy.stats(MODE_FULL).lastMs >= 3500);
+
+    // Polling again records nothing more
+    TEST_ASSERT_TRUE(busy.poll());
+    TEST_ASSERT_EQUAL(1, busy.stats(MODE_FULL).count);
+}
+
+void test_finish_waits_and_keeps_stats_per_kind(void) {
+    PanelBusy& busy = panelBusy();
+    useFakeBusy(busy);
+    FakePanel panel;
+    fakeNow = 10000;
+    for (int i = 0; i < 3; i++) {
+        busyUntil = fakeNow + 600 + i * 100;
+        panelRefresh(&panel, MODE_PARTIAL);
+        TEST_ASSERT_FALSE(busy.pending());
+        TEST_ASSERT_TRUE(fakeNow >= busyUntil);
+    }
+    const PanelBusyStats& s = busy.stats(MODE_PARTIAL);
+    TEST_ASSERT_EQUAL(3, s.count);
+    TEST_ASSERT_TRUE(s.maxMs >= 800 && s.maxMs < 820);
+    TEST_ASSERT_TRUE(s.avgMs() >= 700 && s.avgMs() < 720);
+    TEST_ASSERT_EQUAL(1, busy.stats(MODE_FULL).count);   // from the previous test
+}
+
+void test_edge_release_and_timeout(void) {
+    PanelBusy& busy = panelBusy();
+    useFakeBusy(busy);
+    fakeNow = 20000;
+    busyUntil = 1000000;
+
+    busy.start(PANEL_BUSY_FAST_LUT);
+    TEST_ASSERT_FALSE(busy.poll());
+    busy.release();                      // the ISR saw the rising edge
+    TEST_ASSERT_TRUE(busy.poll());
+    TEST_ASSERT_EQUAL(1, busy.stats(PANEL_BUSY_FAST_LUT).count);
+
+    busy.start(PANEL_BUSY_FAST_LUT);
+    TEST_ASSERT_FALSE(busy.finish(300));
+    TEST_ASSERT_FALSE(busy.pending());
+    TEST_ASSERT_EQUAL(1, busy.timeoutCount());
+    TEST_ASSERT_EQUAL(1, busy.stats(PANEL_BUSY_FAST_LUT).count);
+}
+
+void test_without_begin_blocks_as_before(void) {
+    PanelBusy& busy = panelBusy();
+    busy.lineBusy = nullptr;             // nothing attached
+    FakePanel panel;
+    TEST_ASSERT_EQUAL(MODE_PARTIAL, panelRefresh(&panel, MODE_PARTIAL));
+    TEST_ASSERT_TRUE(panel.lastWait);
+    TEST_ASSERT_EQUAL(1, panel.calls);
+    TEST_ASSERT_TRUE(finishPanelRefresh());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_async_refresh_returns_busy);
+    RUN_TEST(test_finish_waits_and_keeps_stats_per_kind);
+    RUN_TEST(test_edge_release_and_timeout);
+    RUN_TEST(test_without_begin_blocks_as_before);
+    return UNITY_END();
+}
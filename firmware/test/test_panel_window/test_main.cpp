@@ -0,0 +1,173 @@
+/**
+ * Host tests for panel-window.h
+ * Run with: pio test -e native -f test_panel_window
+ *
+ * A fake panel records the address window and every byte sent to each
+ * RAM plane, so the tests can check that a windowed refresh sends only the
+ * window rows, keeps the old plane in step with the new one, and leaves
+ * the full-screen window programmed afterwards.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "panel-window.h"
+
+#define PANEL_W 800
+#define PANEL_H 480
+#define PITCH (PANEL_W / 8)
+#define MODE_PARTIAL 2
+
+struct FakePanel {
+    std::vector<uint8_t> fb;             // empty = bufferless
+    std::vector<uint8_t> ram[2] = { std::vector<uint8_t>(PITCH * PANEL_H, 0xFF),
+                                    std::vector<uint8_t>(PITCH * PANEL_H, 0xFF) };
+    int wx = 0, wy = 0, ww = PANEL_W, wh = PANEL_H, pos = 0, plane = 0;
+    int sent = 0;                        // bytes over "SPI"
+    int refreshes = 0;
+    bool newBeforeRefresh = false;       // new plane written before the waveform
+    bool oldBeforeRefresh = false;       // old plane touched before the waveform (wrong)
+    int refreshX = -1, refreshY = -1, refreshW = -1, refreshH = -1;
+
+    int width() { return PANEL_W; }
+    int height() { return PANEL_H; }
+    void* getBuffer() { return fb.empty() ? nullptr : fb.data(); }
+    void setAddrWindow(int x, int y, int w, int h) { wx = x; wy = y; ww = w; wh = h; pos = 0; }
+    void startWrite(int p) { pos = 0; plane = p; }
+    void writeData(uint8_t* p, int n) {
+        int rowBytes = ww / 8;
+        for (int i = 0; i < n; i++, pos++) {
+            ram[plane][(wy + pos / rowBytes) * PITCH + wx / 8 + pos % rowBytes] = p[i];
+        }
+        sent += n;
+        if (refreshes == 0) {
+            if (plane == PANEL_PLANE_NEW) newBeforeRefresh = true;
+            else oldBeforeRefresh = true;
+        }
+    }
+    int refresh(int mode, bool) {
+        refreshes++;
+        refreshX = wx; refreshY = wy; refreshW = ww; refreshH = wh;
+        return mode;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_align_widens_to_bytes(void) {
+    PanelWindow w = alignPanelWindow(13, 40, 20, 10, PANEL_W, PANEL_H);
+    TEST_ASSERT_EQUAL(8, w.x);
+    TEST_ASSERT_EQUAL(32, w.w);    // 8..40 covers 13..33
+    TEST_ASSERT_EQUAL(40, w.y);
+    TEST_ASSERT_EQUAL(10, w.h);
+
+    PanelWindow a = alignPanelWindow(0, 0, 800, 28, PANEL_W, PANEL_H);
+    TEST_ASSERT_EQUAL(0, a.x);
+    TEST_ASSERT_EQUAL(800, a.w);
+}
+
+void test_align_clips(void) {
+    PanelWindow w = alignPanelWindow(790, 470, 40, 40, PANEL_W, PANEL_H);
+    TEST_ASSERT_EQUAL(784, w.x);
+    TEST_ASSERT_EQUAL(16, w.w);
+    TEST_ASSERT_EQUAL(10, w.h);
+
+    PanelWindow n = alignPanelWindow(-20, -5, 30, 10, PANEL_W, PANEL_H);
+    TEST_ASSERT_EQUAL(0, n.x);
+    TEST_ASSERT_EQUAL(0, n.y);
+    TEST_ASSERT_EQUAL(16, n.w);
+    TEST_ASSERT_EQUAL(5, n.h);
+
+    TEST_ASSERT_TRUE(alignPanelWindow(PANEL_W, 0, 8, 8, PANEL_W, PANEL_H).empty());
+    TEST_ASSERT_TRUE(alignPanelWindow(10, 10, 0, 8, PANEL_W, PANEL_H).empty());
+}
+
+void test_worth_it(void) {
+    TEST_ASSERT_TRUE(panelWindowWorthIt(alignPanelWindow(0, 0, 800, 28, PANEL_W, PANEL_H), PANEL_W, PANEL_H));
+    TEST_ASSERT_FALSE(panelWindowWorthIt(alignPanelWindow(0, 0, 800, 400, PANEL_W, PANEL_H), PANEL_W, PANEL_H));
+    TEST_ASSERT_FALSE(panelWindowWorthIt(PanelWindow{ 0, 0, 0, 0 }, PANEL_W, PANEL_H));
+}
+
+void test_framebuffer_sends_only_window(void) {
+    FakePanel panel;
+    panel.fb.resize(PITCH * PANEL_H);
+    srand(5);
+    for (auto& b : panel.fb) b = (uint8_t)rand();
+
+    PanelWindow win = alignPanelWindow(100, 200, 800, 28, PANEL_W, PANEL_H);
+    TEST_ASSERT_EQUAL(MODE_PARTIAL, refreshPanelWindow(&panel, win, MODE_PARTIAL));
+
+    // Differential update: new plane before the waveform, old plane after
+    TEST_ASSERT_EQUAL(2 * (win.w / 8) * win.h, panel.sent);
+    TEST_ASSERT_TRUE(panel.newBeforeRefresh);
+    TEST_ASSERT_FALSE(panel.oldBeforeRefresh);
+    TEST_ASSERT_EQUAL(1, panel.refreshes);
+    TEST_ASSERT_EQUAL(win.x, panel.refreshX);
+    TEST_ASSERT_EQUAL(win.y, panel.refreshY);
+    TEST_ASSERT_EQUAL(win.w, panel.refreshW);
+    TEST_ASSERT_EQUAL(win.h, panel.refreshH);
+
+    // Window rows match the framebuffer in both planes, the rest of panel
+    // RAM is untouched
+    for (int plane = 0; plane < 2; plane++) {
+        for (int y = 0; y < PANEL_H; y++) {
+            for (int xb = 0; xb < PITCH; xb++) {
+                bool inside = y >= win.y && y < win.y + win.h && xb >= win.x / 8 && xb < (win.x + win.w) / 8;
+                uint8_t want = inside ? panel.fb[y * PITCH + xb] : 0xFF;
+                if (panel.ram[plane][y * PITCH + xb] != want) {
+                    char msg[48];
+                    snprintf(msg, sizeof(msg), "plane %d byte %d,%d", plane, xb, y);
+                    TEST_FAIL_MESSAGE(msg);
+                }
+            }
+        }
+    }
+
+    // Full-screen window restored for later full refreshes
+    TEST_ASSERT_EQUAL(0, panel.wx);
+    TEST_ASSERT_EQUAL(PANEL_W, panel.ww);
+    TEST_ASSERT_EQUAL(PANEL_H, panel.wh);
+}
+
+void test_bufferless_sends_nothing(void) {
+    FakePanel panel;
+    PanelWindow win = alignPanelWindow(0, 90, 800, 28, PANEL_W, PANEL_H);
+    refreshPanelWindow(&panel, win, MODE_PARTIAL);
+    TEST_ASSERT_EQUAL(0, panel.sent);
+    TEST_ASSERT_EQUAL(90, panel.refreshY);
+    TEST_ASSERT_EQUAL(28, panel.refreshH);
+    TEST_ASSERT_EQUAL(PANEL_H, panel.wh);
+
+    TEST_ASSERT_EQUAL(-1, refreshPanelWindow(&panel, PanelWindow{ 0, 0, 0, 0 }, MODE_PARTIAL));
+    TEST_ASSERT_EQUAL(1, panel.refreshes);
+}
+
+void test_sync_old_plane(void) {
+    FakePanel panel;
+    panel.fb.assign(PITCH * PANEL_H, 0x5A);
+    syncPanelOldPlane(&panel);
+    TEST_ASSERT_TRUE(panel.ram[PANEL_PLANE_OLD] == panel.fb);
+    TEST_ASSERT_EQUAL(PITCH * PANEL_H, panel.sent);
+    TEST_ASSERT_EQUAL(0, panel.refreshes);
+
+    FakePanel bufferless;
+    syncPanelOldPlane(&bufferless);
+    TEST_ASSERT_EQUAL(0, bufferless.sent);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_align_widens_to_bytes);
+    RUN_TEST(test_align_clips);
+    RUN_TEST(test_worth_it);
+    RUN_TEST(test_framebuffer_sends_only_window);
+    RUN_TEST(test_bufferless_sends_nothing);
+    RUN_TEST(test_sync_old_plane);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+/**
+ * Host tests for refresh-planner.h
+ * Run with: pio test -e native -f test_refresh_planner
+ *
+ * Uses the main.cpp / main-v7 zone layout. Checks which dirty rectangles
+ * get merged, when the plan becomes one whole-panel refresh, and that
+ * execute() issues exactly the planned refreshes.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <vector>
+#include "refresh-planner.h"
+
+#define PANEL_W 800
+#define PANEL_H 480
+#define MODE_PARTIAL 2
+#define MODE_WHOLE 7
+
+struct Refresh { int mode, x, y, w, h; };
+
+struct FakePanel {
+    int wx = 0, wy = 0, ww = PANEL_W, wh = PANEL_H;
+    std::vector<Refresh> log;
+
+    int width() { return PANEL_W; }
+    int height() { return PANEL_H; }
+    void* getBuffer() { return nullptr; }
+    void setAddrWindow(int x, int y, int w, int h) { wx = x; wy = y; ww = w; wh = h; }
+    void startWrite(int) {}
+    void writeData(uint8_t*, int) {}
+    int refresh(int mode, bool) {
+        log.push_back(Refresh{ mode, wx, wy, ww, wh });
+        return 0;
+    }
+};
+
+static unsigned long fakeNow = 0;
+static unsigned long fakeClock() { return fakeNow += 250; }
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_empty_plan(void) {
+    RefreshPlanner plan(PANEL_W, PANEL_H);
+    TEST_ASSERT_EQUAL(RefreshPlanner::PLAN_NONE, plan.plan());
+    FakePanel panel;
+    TEST_ASSERT_EQUAL(0, plan.execute(&panel, MODE_PARTIAL, MODE_WHOLE));
+    TEST_ASSERT_EQUAL(0, (int)panel.log.size());
+
+    plan.add(900, 10, 20, 20);   // off screen
+    TEST_ASSERT_TRUE(plan.empty());
+}
+
+void test_adjacent_zones_merge(void) {
+    // header (0,0,800,94) and summary (0,96,800,28): a 2-row gap
+    RefreshPlanner plan(PANEL_W, PANEL_H);
+    plan.add(0, 0, 800, 94);
+    plan.add(0, 96, 800, 28);
+    TEST_ASSERT_EQUAL(RefreshPlanner::PLAN_WINDOWS, plan.plan());
+    TEST_ASSERT_EQUAL(1, plan.windowCount());
+    TEST_ASSERT_EQUAL(0, plan.window(0).y);
+    TEST_ASSERT_EQUAL(124, plan.window(0).h);
+}
+
+void test_overlapping_merge(void) {
+    RefreshPlanner plan(PANEL_W, PANEL_H);
+    plan.add(100, 100, 100, 50);
+    plan.add(150, 120, 100, 50);
+    plan.plan();
+    TEST_ASSERT_EQUAL(1, plan.windowCount());
+    TEST_ASSERT_EQUAL(96, plan.window(0).x);
+    TEST_ASSERT_EQUAL(160, plan.window(0).w);
+}
+
+void test_distant_small_zones_stay_apart(void) {
+    // Two digit-sized deltas in opposite corners: merging would waveform
+    // nearly the whole screen for two 48x24 changes
+    RefreshPlanner plan(PANEL_W, PANEL_H);
+    plan.add(16, 8, 48, 24);
+    plan.add(720, 440, 48, 24);
+    TEST_ASSERT_EQUAL(RefreshPlanner::PLAN_WINDOWS, plan.plan());
+    TEST_ASSERT_EQUAL(2, plan.windowCount());
+    TEST_ASSERT_EQUAL(2 * RefreshPlanner::costMs(plan.window(0)), plan.estimatedMs());
+}
+
+void test_large_change_goes_whole(void) {
+    // legs (0,132,800,316) plus summary: over 60% of the screen
+    RefreshPlanner plan(PANEL_W, PANEL_H);
+    plan.add(0, 96, 800, 28);
+    plan.add(0, 132, 800, 316);
+    TEST_ASSERT_EQUAL(RefreshPlanner::PLAN_WHOLE, plan.plan());
+
+    FakePanel panel;
+    TEST_ASSERT_EQUAL(1, plan.execute(&panel, MODE_PARTIAL, MODE_WHOLE));
+    TEST_ASSERT_EQUAL(1, (int)panel.log.size());
+    TEST_ASSERT_EQUAL(MODE_WHOLE, panel.log[0].mode);
+    TEST_ASSERT_EQUAL(PANEL_H, panel.log[0].h);
+    TEST_ASSERT_TRUE(plan.empty());
+}
+
+void test_execute_batches_windows(void) {
+    RefreshPlanner plan(PANEL_W, PANEL_H, fakeClock);
+    plan.add(16, 8, 48, 24);
+    plan.add(20, 10, 40, 20);       // inside the first
+    plan.add(720, 440, 48, 24);
+    FakePanel panel;
+    TEST_ASSERT_EQUAL(2, plan.execute(&panel, MODE_PARTIAL, MODE_WHOLE));
+    TEST_ASSERT_EQUAL(2, (int)panel.log.size());
+    for (const Refresh& r : panel.log) {
+        TEST_ASSERT_EQUAL(MODE_PARTIAL, r.mode);
+        TEST_ASSERT_EQUAL(24, r.h);
+    }
+    TEST_ASSERT_EQUAL(250, plan.busyMs());        // measured with the clock
+    TEST_ASSERT_EQUAL(RefreshPlanner::PLAN_WINDOWS, plan.lastPlan());
+    TEST_ASSERT_EQUAL(PANEL_H, panel.wh);          // full window restored
+}
+
+void test_overflow_folds_in(void) {
+    RefreshPlanner plan(PANEL_W, PANEL_H);
+    for (int i = 0; i < REFRESH_PLAN_MAX + 4; i++) plan.add(8 * i, 4 * i, 8, 4);
+    plan.plan();
+    int32_t covered = 0;
+    for (int i = 0; i < plan.windowCount(); i++) covered += plan.window(i).area();
+    TEST_ASSERT_TRUE(plan.windowCount() >= 1);
+    TEST_ASSERT_TRUE(covered >= (REFRESH_PLAN_MAX + 4) * 32);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_plan);
+    RUN_TEST(test_adjacent_zones_merge);
+    RUN_TEST(test_overlapping_merge);
+    RUN_TEST(test_distant_small_zones_stay_apart);
+    RUN_TEST(test_large_change_goes_whole);
+    RUN_TEST(test_execute_batches_windows);
+    RUN_TEST(test_overflow_folds_in);
+    return UNITY_END();
+}
@@ -0,0 +1,101 @@
+/**
+ * Host tests for sleep-cycle.h
+ * Run with: pio test -e native -f test_sleep_cycle
+ *
+ * Checks that RTC state is only trusted when it was sealed by this
+ * layout, the sleep length against the refresh period, and the charge
+ * arithmetic of the per-cycle report.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include "sleep-cycle.h"
+
+struct State {
+    uint32_t sinceFullMs;
+    int32_t partials;
+    uint8_t bssid[6];
+};
+
+struct BiggerState {
+    State s;
+    uint32_t extra;
+};
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_rtc_block_valid_only_after_seal(void) {
+    RtcBlock<State> rtc;
+    memset(&rtc, 0xA5, sizeof(rtc));          // power-on garbage
+    TEST_ASSERT_FALSE(rtc.valid());
+
+    rtc.clear();
+    TEST_ASSERT_FALSE(rtc.valid());
+
+    rtc.data.sinceFullMs = 123456;
+    rtc.data.partials = 7;
+    rtc.seal();
+    TEST_ASSERT_TRUE(rtc.valid());
+
+    // Any change after sealing (or a bit flip) is caught
+    rtc.data.partials = 8;
+    TEST_ASSERT_FALSE(rtc.valid());
+    rtc.seal();
+    rtc.data.bssid[3] ^= 0x10;
+    TEST_ASSERT_FALSE(rtc.valid());
+}
+
+void test_rtc_block_rejects_other_layout(void) {
+    RtcBlock<BiggerState> big;
+    big.clear();
+    big.seal();
+    TEST_ASSERT_TRUE(big.valid());
+
+    // Same bytes read back by a build with a different state struct
+    RtcBlock<State> small;
+    memcpy(&small, &big, sizeof(small));
+    TEST_ASSERT_FALSE(small.valid());
+}
+
+void test_sleep_remaining(void) {
+    TEST_ASSERT_EQUAL(57000, sleepCycleRemaining(3000, 60000));
+    TEST_ASSERT_EQUAL(SLEEP_MIN_MS, sleepCycleRemaining(60000 - SLEEP_MIN_MS, 60000));
+    TEST_ASSERT_EQUAL(0, sleepCycleRemaining(60000 - SLEEP_MIN_MS + 1, 60000));
+    TEST_ASSERT_EQUAL(0, sleepCycleRemaining(60000, 60000));
+    TEST_ASSERT_EQUAL(0, sleepCycleRemaining(90000, 60000));
+}
+
+void test_cycle_charge(void) {
+    SleepCycleTimes t = {};
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sleepCycleCharge(t));
+
+    // 1 s awake with nothing else on: SLEEP_UA_CPU µA for 1 s
+    t.awakeMs = 1000;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, SLEEP_UA_CPU / 1000.0f, sleepCycleCharge(t));
+
+    // A typical minute: asleep dominates the time, awake dominates the charge
+    t.sleptMs = 57000;
+    t.awakeMs = 3000;
+    t.radioMs = 2500;
+    t.panelMs = 700;
+    float expect = (57000.0f * SLEEP_UA_DEEP + 3000.0f * SLEEP_UA_CPU + 2500.0f * SLEEP_UA_RADIO
+                    + 700.0f * SLEEP_UA_PANEL) / 1000000.0f;
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, expect, sleepCycleCharge(t));
+
+    // The same minute awake throughout costs several times more
+    SleepCycleTimes awake = { 0, 60000, 60000, 700 };
+    TEST_ASSERT_TRUE(sleepCycleCharge(awake) > 10 * sleepCycleCharge(t));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rtc_block_valid_only_after_seal);
+    RUN_TEST(test_rtc_block_rejects_other_layout);
+    RUN_TEST(test_sleep_remaining);
+    RUN_TEST(test_cycle_charge);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+/**
+ * Host tests for spi-dma.h
+ * Run with: pio test -e native -f test_spi_dma
+ *
+ * A fake bus completes transactions only when wait() is called and checks
+ * that a queued chunk is not modified before it completes, so the tests
+ * can check the double buffering: byte order, at most two chunks in
+ * flight, and the clock calibration's choice of step.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include <deque>
+#include <vector>
+#include "spi-dma.h"
+
+struct Pending {
+    const uint8_t* data;
+    std::vector<uint8_t> copy;
+};
+
+struct FakeBus {
+    std::vector<uint8_t> wire;
+    std::deque<Pending> queued;
+    int selects = 0, releases = 0, maxInFlight = 0, transactions = 0;
+    bool selected = false, corrupted = false;
+
+    void select() { selects++; selected = true; }
+    void queue(const uint8_t* p, int n) {
+        TEST_ASSERT_TRUE(selected);
+        queued.push_back(Pending{ p, std::vector<uint8_t>(p, p + n) });
+        transactions++;
+        if ((int)queued.size() > maxInFlight) maxInFlight = queued.size();
+    }
+    void wait() {
+        TEST_ASSERT_FALSE(queued.empty());
+        Pending& t = queued.front();
+        if (memcmp(t.data, t.copy.data(), t.copy.size()) != 0) corrupted = true;
+        wire.insert(wire.end(), t.copy.begin(), t.copy.end());
+        queued.pop_front();
+    }
+    void release() { releases++; selected = false; }
+};
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_bytes_arrive_in_order(void) {
+    FakeBus bus;
+    static DoubleBufferedWriter<FakeBus> w(bus);
+    std::vector<uint8_t> sent;
+    srand(7);
+    // 100-byte rows like pushPanelWindow(), then 2 KB bands like PanelWindowSink
+    for (int r = 0; r < 300; r++) {
+        uint8_t row[100];
+        for (auto& b : row) b = (uint8_t)rand();
+        w.write(row, sizeof(row));
+        sent.insert(sent.end(), row, row + sizeof(row));
+    }
+    for (int band = 0; band < 5; band++) {
+        std::vector<uint8_t> data(2000 + band * 300);
+        for (auto& b : data) b = (uint8_t)rand();
+        w.write(data.data(), data.size());
+        w.send();
+        sent.insert(sent.end(), data.begin(), data.end());
+    }
+    w.flush();
+
+    TEST_ASSERT_TRUE(bus.wire == sent);
+    TEST_ASSERT_FALSE(bus.corrupted);
+    TEST_ASSERT_TRUE(bus.maxInFlight <= 2);
+    TEST_ASSERT_TRUE(bus.queued.empty());
+    TEST_ASSERT_EQUAL(1, bus.selects);
+    TEST_ASSERT_EQUAL(1, bus.releases);
+    TEST_ASSERT_EQUAL((int)sent.size(), (int)w.bytes);
+}
+
+void test_chunks_are_full_size(void) {
+    FakeBus bus;
+    static DoubleBufferedWriter<FakeBus> w(bus);
+    std::vector<uint8_t> plane(48000, 0x5A);
+    for (int r = 0; r < 480; r++) w.write(plane.data() + r * 100, 100);
+    w.flush();
+    // 48000 / 2048 -> 23 full chunks and a tail
+    TEST_ASSERT_EQUAL(24, bus.transactions);
+    TEST_ASSERT_EQUAL(48000, (int)bus.wire.size());
+}
+
+void test_flush_without_data_does_nothing(void) {
+    FakeBus bus;
+    static DoubleBufferedWriter<FakeBus> w(bus);
+    w.flush();
+    w.send();
+    TEST_ASSERT_EQUAL(0, bus.selects);
+    TEST_ASSERT_EQUAL(0, bus.releases);
+    TEST_ASSERT_EQUAL(0, bus.transactions);
+}
+
+static uint32_t failAbove;
+static int reads;
+
+static bool fakeRead(uint32_t hz, uint8_t* out) {
+    reads++;
+    out[0] = 0x0C;
+    out[1] = 0x01;
+    out[2] = 0x23;
+    if (hz > failAbove && (reads & 3) == 0) out[1] ^= 0x40;   // occasional bit error
+    return true;
+}
+
+void test_pick_spi_clock(void) {
+    static const uint32_t steps[] = SPI_CAL_STEPS;
+    const int n = sizeof(steps) / sizeof(steps[0]);
+
+    failAbove = 20000000;
+    TEST_ASSERT_EQUAL(20000000, pickSpiClock(steps, n, fakeRead));
+
+    failAbove = 100000000;
+    TEST_ASSERT_EQUAL(steps[0], pickSpiClock(steps, n, fakeRead));
+
+    failAbove = 0;
+    TEST_ASSERT_EQUAL(SPI_CAL_SAFE_HZ, pickSpiClock(steps, n, fakeRead));
+
+    // Nothing on the line: keep the old fixed clock
+    TEST_ASSERT_EQUAL(SPI_CAL_FALLBACK_HZ, pickSpiClock(steps, n, [](uint32_t, uint8_t* out) {
+        memset(out, 0xFF, SPI_CAL_LEN);
+        return true;
+    }));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bytes_arrive_in_order);
+    RUN_TEST(test_chunks_are_full_size);
+    RUN_TEST(test_flush_without_data_does_nothing);
+    RUN_TEST(test_pick_spi_clock);
+    return UNITY_END();
+}
@@ -0,0 +1,72 @@
+/**
+ * Host tests for wifi-fast.h
+ * Run with: pio test -e native -f test_wifi_fast
+ *
+ * Checks which connect path the saved AP and lease allow: the static-IP
+ * path only while the lease is young, never for another SSID or after
+ * power loss.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include "wifi-fast.h"
+
+static WifiFastState saved(uint64_t leaseAtMs) {
+    WifiFastState s;
+    memset(&s, 0, sizeof(s));
+    strcpy(s.ssid, "HomeNet");
+    const uint8_t bssid[6] = { 0x02, 0x11, 0x22, 0x33, 0x44, 0x55 };
+    memcpy(s.bssid, bssid, 6);
+    s.channel = 6;
+    s.ip = 0x0A01A8C0;
+    s.gateway = 0x0101A8C0;
+    s.mask = 0x00FFFFFF;
+    s.dns = 0x0101A8C0;
+    s.leaseAtMs = leaseAtMs;
+    return s;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_nothing_saved_scans(void) {
+    WifiFastState s = saved(1000);
+    TEST_ASSERT_EQUAL(WIFI_PATH_SCAN, wifiFastPlan(s, false, "HomeNet", 2000));
+    s.channel = 0;
+    TEST_ASSERT_EQUAL(WIFI_PATH_SCAN, wifiFastPlan(s, true, "HomeNet", 2000));
+}
+
+void test_other_ssid_scans(void) {
+    WifiFastState s = saved(1000);
+    TEST_ASSERT_EQUAL(WIFI_PATH_SCAN, wifiFastPlan(s, true, "Neighbour", 2000));
+}
+
+void test_young_lease_is_reused(void) {
+    WifiFastState s = saved(1000);
+    TEST_ASSERT_EQUAL(WIFI_PATH_STATIC, wifiFastPlan(s, true, "HomeNet", 1000));
+    TEST_ASSERT_EQUAL(WIFI_PATH_STATIC, wifiFastPlan(s, true, "HomeNet", 1000 + WIFI_LEASE_REUSE_MS - 1));
+    TEST_ASSERT_EQUAL(WIFI_PATH_BSSID, wifiFastPlan(s, true, "HomeNet", 1000 + WIFI_LEASE_REUSE_MS));
+}
+
+void test_no_lease_uses_cached_ap(void) {
+    // Cold boot: AP from NVS, lease dropped
+    WifiFastState s = saved(0);
+    s.ip = 0;
+    TEST_ASSERT_EQUAL(WIFI_PATH_BSSID, wifiFastPlan(s, true, "HomeNet", 5000));
+
+    // RTC clock reset below the lease time: not trusted
+    s = saved(900000);
+    TEST_ASSERT_EQUAL(WIFI_PATH_BSSID, wifiFastPlan(s, true, "HomeNet", 1000));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_saved_scans);
+    RUN_TEST(test_other_ssid_scans);
+    RUN_TEST(test_young_lease_is_reused);
+    RUN_TEST(test_no_lease_uses_cached_ap);
+    return UNITY_END();
+}
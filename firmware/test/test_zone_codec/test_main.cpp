@@ -0,0 +1,285 @@
+/**
+ * Host tests for zone-codec.h
+ * Run with: pio test -e native -f test_zone_codec
+ *
+ * The rle1 streams below were produced by the server's encoder
+ * (encodeRowsRle() in src/services/zone-codec.js) from the pattern in
+ * white(). They are decoded in random chunk sizes and with bands of a few
+ * rows, so PackBits runs cross row and band boundaries, and checked
+ * against golden rows. Truncated and corrupt streams must fail or wait
+ * without writing outside the image.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include <vector>
+#include "zone-codec.h"
+
+// ---------------------------------------------------------------------------
+// Server-encoded fixtures
+// ---------------------------------------------------------------------------
+
+// White margin, a black bar, rows repeated in fours (XOR runs of zeros
+// spanning rows), an all-black row, then noise (literal packets)
+static bool white(int x, int y) {
+    if (y < 3) return true;
+    if (y < 6) return !(x >= 4 && x < 60);
+    if (y < 20) return ((x / 3 + y / 4) % 5) != 0;
+    if (y == 20) return false;
+    return (x * 13 + y * 7) % 17 > 5;
+}
+
+// 21x24, 3 bytes per row
+static const uint8_t SMALL_RLE[] = {
+    0x5A, 0x31, 0x15, 0x00, 0x18, 0x00, 0x01, 0xF8, 0x00, 0x02, 0x0F, 0xFF,
+    0xF8, 0xFB, 0x00, 0x02, 0x0F, 0xF1, 0xF8, 0xFD, 0x00, 0x00, 0x7E, 0xF7,
+    0x00, 0x01, 0x03, 0xF0, 0xF7, 0x00, 0x02, 0x1F, 0x80, 0x38, 0xF8, 0x00,
+    0x0B, 0xE3, 0xFF, 0xC0, 0xDC, 0xCE, 0xE8, 0xAB, 0xBD, 0xD0, 0xEE, 0xAE,
+    0xF0
+};
+
+// SMALL_RLE decoded, top row first, pad bits white
+static const uint8_t SMALL_ROWS[] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x07,
+    0xF0, 0x00, 0x07, 0xF0, 0x00, 0x07, 0xFF, 0xF1, 0xFF, 0xFF, 0xF1, 0xFF,
+    0xFF, 0x8F, 0xFF, 0xFF, 0x8F, 0xFF, 0xFF, 0x8F, 0xFF, 0xFF, 0x8F, 0xFF,
+    0xFC, 0x7F, 0xFF, 0xFC, 0x7F, 0xFF, 0xFC, 0x7F, 0xFF, 0xFC, 0x7F, 0xFF,
+    0xE3, 0xFF, 0xC7, 0xE3, 0xFF, 0xC7, 0xE3, 0xFF, 0xC7, 0xE3, 0xFF, 0xC7,
+    0x00, 0x00, 0x07, 0xDC, 0xCE, 0xEF, 0x77, 0x73, 0x3F, 0x99, 0xDD, 0xCF
+};
+
+// 100x40, 13 bytes per row
+static const uint8_t ZONE_RLE[] = {
+    0x5A, 0x31, 0x64, 0x00, 0x28, 0x00, 0x01, 0xDA, 0x00, 0x00, 0x0F, 0xFB,
+    0xFF, 0x00, 0xF0, 0xE2, 0x00, 0x0B, 0x0F, 0xF1, 0xFF, 0xE3, 0xFF, 0xC7,
+    0xFF, 0x80, 0x00, 0xE0, 0x01, 0xC0, 0xF2, 0x00, 0x0B, 0x7E, 0x00, 0xFC,
+    0x01, 0xF8, 0x03, 0xF0, 0x07, 0xE0, 0x0F, 0xC0, 0x10, 0xDA, 0x00, 0x0C,
+    0x03, 0xF0, 0x07, 0xE0, 0x0F, 0xC0, 0x1F, 0x80, 0x3F, 0x00, 0x7E, 0x00,
+    0xF0, 0xDA, 0x00, 0x0C, 0x1F, 0x80, 0x3F, 0x00, 0x7E, 0x00, 0xFC, 0x01,
+    0xF8, 0x03, 0xF0, 0x07, 0xE0, 0xDA, 0x00, 0x7F, 0xE3, 0xFF, 0xC7, 0xFF,
+    0x8F, 0xFF, 0x1F, 0xFE, 0x3F, 0xFC, 0x7F, 0xF8, 0xF0, 0xDC, 0xCE, 0xEE,
+    0x67, 0x77, 0x33, 0xBB, 0x99, 0xDD, 0xCC, 0xEE, 0xE6, 0x70, 0xAB, 0xBD,
+    0xD5, 0xDE, 0xEA, 0xEF, 0x75, 0x77, 0xBA, 0xBB, 0xDD, 0x5D, 0xE0, 0xEE,
+    0xAE, 0xF7, 0x57, 0x7B, 0xAB, 0xBD, 0xD5, 0xDE, 0xEA, 0xEF, 0x75, 0x70,
+    0x77, 0xBA, 0xBB, 0xDD, 0x5D, 0xEE, 0xAE, 0xF7, 0x57, 0x7B, 0xAB, 0xBD,
+    0xD0, 0xD5, 0xDE, 0xEA, 0xEF, 0x75, 0x77, 0xBA, 0xBB, 0xDD, 0x5D, 0xEE,
+    0xAE, 0xF0, 0xF7, 0x57, 0x7B, 0xAB, 0xBD, 0xD5, 0xDE, 0xEA, 0xEF, 0x75,
+    0x77, 0xBA, 0xB0, 0xBB, 0xDD, 0x5D, 0xEE, 0xAE, 0xF7, 0x57, 0x7B, 0xAB,
+    0xBD, 0xD5, 0xDE, 0xE0, 0xEA, 0xEF, 0x75, 0x77, 0xBA, 0xBB, 0xDD, 0x5D,
+    0xEE, 0xAE, 0xF7, 0x57, 0x70, 0x7B, 0xAB, 0xBD, 0xD5, 0xDE, 0xEA, 0xEF,
+    0x75, 0x77, 0xBA, 0xBB, 0x7F, 0xDD, 0x50, 0x5D, 0xEE, 0xAE, 0xF7, 0x57,
+    0x7B, 0xAB, 0xBD, 0xD5, 0xDE, 0xEA, 0xEF, 0x70, 0x75, 0x77, 0xBA, 0xBB,
+    0xDD, 0x5D, 0xEE, 0xAE, 0xF7, 0x57, 0x7B, 0xAB, 0xB0, 0xBD, 0xD5, 0xDE,
+    0xEA, 0xEF, 0x75, 0x77, 0xBA, 0xBB, 0xDD, 0x5D, 0xEE, 0xA0, 0xAE, 0xF7,
+    0x57, 0x7B, 0xAB, 0xBD, 0xD5, 0xDE, 0xEA, 0xEF, 0x75, 0x77, 0xB0, 0xBA,
+    0xBB, 0xDD, 0x5D, 0xEE, 0xAE, 0xF7, 0x57, 0x7B, 0xAB, 0xBD, 0xD5, 0xD0,
+    0xDE, 0xEA, 0xEF, 0x75, 0x77, 0xBA, 0xBB, 0xDD, 0x5D, 0xEE, 0xAE, 0xF7,
+    0x50, 0x57, 0x7B, 0xAB, 0xBD, 0xD5, 0xDE, 0xEA, 0xEF, 0x75, 0x77, 0xBA,
+    0xBB, 0xD0, 0xDD, 0x5D, 0xEE, 0xAE, 0xF7, 0x57, 0x7B, 0xAB, 0xBD, 0xD5,
+    0xDE, 0xEA, 0xE0, 0xEF, 0x75, 0x77, 0xBA, 0xBB, 0xDD, 0x5D, 0xEE, 0xAE,
+    0xF7, 0x57, 0x7B, 0xA0, 0xAB, 0xBD, 0xD5, 0xDE, 0xEA, 0xEF, 0x75, 0x77,
+    0xBA, 0x03, 0xBB, 0xDD, 0x5D, 0xE0
+};
+
+// Unfiltered (flags 0): repeat AA x2, no-op 0x80, literal 01 02 03 04
+static const uint8_t PLAIN_RLE[] = {
+    0x5A, 0x31, 0x10, 0x00, 0x03, 0x00, 0x00, 0xFF, 0xAA, 0x80, 0x03, 0x01, 0x02, 0x03, 0x04
+};
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+// Keeps every row it is given, and checks they arrive whole and in range
+struct RowCollector : public BmpRowSink {
+    int w = 0, h = 0, rowBytes = 0, bands = 0, rowsSeen = 0, ends = 0;
+    std::vector<uint8_t> rows;
+
+    bool begin(int width, int height) override {
+        w = width;
+        h = height;
+        rowBytes = (w + 7) / 8;
+        rows.assign(rowBytes * h, 0x55);
+        return true;
+    }
+    bool writeRows(int y, int n, const uint8_t* data, int rb) override {
+        TEST_ASSERT_EQUAL(rowBytes, rb);
+        TEST_ASSERT_TRUE(y >= 0 && n > 0 && y + n <= h);
+        TEST_ASSERT_EQUAL(rowsSeen, y);                  // top to bottom, no gaps
+        memcpy(&rows[y * rowBytes], data, n * rowBytes);
+        bands++;
+        rowsSeen += n;
+        return true;
+    }
+    void end() override { ends++; }
+
+    bool pixel(int x, int y) const { return rows[y * rowBytes + (x >> 3)] & (0x80 >> (x & 7)); }
+};
+
+/** Feed in random pieces of 1..maxChunk bytes; the last result */
+template <class Decoder>
+static BmpStreamDecoder::Result feedChunked(Decoder& dec, const uint8_t* data, size_t len, int maxChunk) {
+    BmpStreamDecoder::Result r = BmpStreamDecoder::NEED_MORE;
+    for (size_t pos = 0; pos < len && r == BmpStreamDecoder::NEED_MORE;) {
+        size_t n = 1 + rand() % maxChunk;
+        if (n > len - pos) n = len - pos;
+        r = dec.feed(data + pos, n);
+        pos += n;
+    }
+    return r;
+}
+
+static void assertPattern(const RowCollector& sink, int w, int h) {
+    TEST_ASSERT_EQUAL(w, sink.w);
+    TEST_ASSERT_EQUAL(h, sink.h);
+    TEST_ASSERT_EQUAL(h, sink.rowsSeen);
+    TEST_ASSERT_EQUAL(1, sink.ends);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (sink.pixel(x, y) != white(x, y)) {
+                char msg[48];
+                snprintf(msg, sizeof(msg), "pixel %d,%d", x, y);
+                TEST_FAIL_MESSAGE(msg);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_golden_rows(void) {
+    uint8_t band[BMP_STREAM_BAND_SIZE];
+    RowCollector sink;
+    ZoneCodecDecoder dec(band, sizeof(band));
+    dec.reset(&sink);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, dec.feed(SMALL_RLE, sizeof(SMALL_RLE)));
+    TEST_ASSERT_EQUAL(21, dec.imageWidth());
+    TEST_ASSERT_EQUAL(24, dec.imageHeight());
+    TEST_ASSERT_EQUAL(1, sink.bands);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(SMALL_ROWS, sink.rows.data(), sizeof(SMALL_ROWS));
+    assertPattern(sink, 21, 24);
+}
+
+void test_runs_across_rows_and_bands(void) {
+    srand(1);
+    // 1 to 5 rows per band; the leading run of zeros alone spans 3 rows
+    for (int rowsPerBand = 1; rowsPerBand <= 5; rowsPerBand++) {
+        for (int iter = 0; iter < 20; iter++) {
+            uint8_t band[5 * 13];
+            RowCollector small, zone;
+            ZoneCodecDecoder dec(band, rowsPerBand * 3);
+            dec.reset(&small);
+            TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, feedChunked(dec, SMALL_RLE, sizeof(SMALL_RLE), 1 + iter));
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(SMALL_ROWS, small.rows.data(), sizeof(SMALL_ROWS));
+            TEST_ASSERT_EQUAL((24 + rowsPerBand - 1) / rowsPerBand, small.bands);
+
+            ZoneCodecDecoder wide(band, rowsPerBand * 13);
+            wide.reset(&zone);
+            TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, feedChunked(wide, ZONE_RLE, sizeof(ZONE_RLE), 1 + rand() % 64));
+            assertPattern(zone, 100, 40);
+        }
+    }
+}
+
+void test_unfiltered_stream(void) {
+    uint8_t band[64];
+    RowCollector sink;
+    ZoneCodecDecoder dec(band, sizeof(band));
+    dec.reset(&sink);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, feedChunked(dec, PLAIN_RLE, sizeof(PLAIN_RLE), 1));
+    const uint8_t want[] = { 0xAA, 0xAA, 0x01, 0x02, 0x03, 0x04 };
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(want, sink.rows.data(), sizeof(want));
+}
+
+void test_truncated_and_corrupt(void) {
+    uint8_t band[BMP_STREAM_BAND_SIZE];
+    RowCollector sink;
+    ZoneCodecDecoder dec(band, sizeof(band));
+
+    // Cut anywhere: waits for more, never done, never past the image
+    for (size_t cut = 0; cut < sizeof(ZONE_RLE); cut += 7) {
+        RowCollector part;
+        dec.reset(&part);
+        TEST_ASSERT_EQUAL(BmpStreamDecoder::NEED_MORE, dec.feed(ZONE_RLE, cut));
+        TEST_ASSERT_FALSE(dec.done());
+        TEST_ASSERT_EQUAL(0, part.ends);
+    }
+
+    std::vector<uint8_t> bad(SMALL_RLE, SMALL_RLE + sizeof(SMALL_RLE));
+    bad[1] = '2';                                          // magic
+    dec.reset(&sink);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, dec.feed(bad.data(), bad.size()));
+
+    bad.assign(SMALL_RLE, SMALL_RLE + sizeof(SMALL_RLE));
+    bad[2] = bad[3] = 0;                                   // width 0
+    dec.reset(&sink);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, dec.feed(bad.data(), bad.size()));
+
+    bad[2] = 0x40;                                         // 1600 px: wider than a row
+    bad[3] = 0x06;
+    dec.reset(&sink);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, dec.feed(bad.data(), bad.size()));
+
+    // Row wider than the band
+    ZoneCodecDecoder tiny(band, 2);
+    tiny.reset(&sink);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::FAILED, tiny.feed(SMALL_RLE, sizeof(SMALL_RLE)));
+
+    // Packets running past the last row stop at it; trailing bytes ignored
+    const uint8_t overrun[] = { 0x5A, 0x31, 0x08, 0x00, 0x02, 0x00, 0x00,
+                                0x81, 0x00,                  // 128 x 00 for 2 bytes
+                                0x7F, 0x11, 0x22 };          // literal cut short, after the end
+    RowCollector two;
+    dec.reset(&two);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, dec.feed(overrun, sizeof(overrun)));
+    TEST_ASSERT_EQUAL(2, two.rowsSeen);
+    TEST_ASSERT_EQUAL_HEX8(0x00, two.rows[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, two.rows[1]);
+}
+
+// A BMP or an rle1 stream, told apart by the first byte
+void test_image_decoder_picks_format(void) {
+    uint8_t band[BMP_STREAM_BAND_SIZE];
+    ZoneImageDecoder dec(band, sizeof(band));
+
+    RowCollector rle;
+    dec.reset(&rle);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, dec.feed(SMALL_RLE, sizeof(SMALL_RLE)));
+    TEST_ASSERT_TRUE(dec.isCompressed());
+    TEST_ASSERT_TRUE(dec.done());
+
+    // Same rows as a top-down BMP (what rowsToBmp() produces)
+    std::vector<uint8_t> bmp(62 + 4 * 24, 0);
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    bmp[10] = 62;
+    bmp[14] = 40;
+    bmp[18] = 21;
+    int32_t h = -24;
+    memcpy(&bmp[22], &h, 4);
+    bmp[26] = 1;
+    bmp[28] = 1;
+    bmp[58] = bmp[59] = bmp[60] = 0xFF;                  // index 1 white
+    for (int y = 0; y < 24; y++) memcpy(&bmp[62 + y * 4], SMALL_ROWS + y * 3, 3);
+
+    RowCollector plain;
+    dec.reset(&plain);
+    TEST_ASSERT_EQUAL(BmpStreamDecoder::DONE, dec.feed(bmp.data(), bmp.size()));
+    TEST_ASSERT_FALSE(dec.isCompressed());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(rle.rows.data(), plain.rows.data(), rle.rows.size());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_golden_rows);
+    RUN_TEST(test_runs_across_rows_and_bands);
+    RUN_TEST(test_unfiltered_stream);
+    RUN_TEST(test_truncated_and_corrupt);
+    RUN_TEST(test_image_decoder_picks_format);
+    return UNITY_END();
+}
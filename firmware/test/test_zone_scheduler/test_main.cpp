@@ -0,0 +1,146 @@
+/**
+ * Host tests for zone-scheduler.h
+ * Run with: pio test -e native -f test_zone_scheduler
+ *
+ * Checks deadline order (across a millis wrap), merging of nearly
+ * coincident deadlines, dynamic pull-ins, and the request count of an
+ * hour of the three refresh tiers against one request per tier.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+#include <unity.h>
+#include "zone-scheduler.h"
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+void test_earliest_first(void) {
+    ZoneScheduler s(0);
+    s.set("c", 1000, 300);
+    s.set("a", 1000, 100);
+    s.set("d", 1000, 400);
+    s.set("b", 1000, 200);
+    TEST_ASSERT_EQUAL(4, s.size());
+    TEST_ASSERT_EQUAL(100, (int)s.nextDue());
+
+    ZoneSchedEntry out[ZONE_SCHED_MAX];
+    TEST_ASSERT_EQUAL(0, s.takeDue(99, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_EQUAL(2, s.takeDue(250, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_EQUAL_STRING("a", out[0].id);
+    TEST_ASSERT_EQUAL_STRING("b", out[1].id);
+    TEST_ASSERT_EQUAL(300, (int)s.nextDue());
+
+    // Moving an entry keeps the heap ordered
+    s.set("d", 1000, 50);
+    TEST_ASSERT_EQUAL(50, (int)s.nextDue());
+    TEST_ASSERT_EQUAL(2, s.size());
+}
+
+void test_order_across_millis_wrap(void) {
+    ZoneScheduler s(0);
+    unsigned long nearWrap = (unsigned long)-1000;
+    s.set("after", 60000, nearWrap + 5000);        // wraps past zero
+    s.set("before", 60000, nearWrap + 500);
+    TEST_ASSERT_EQUAL(nearWrap + 500, s.nextDue());
+
+    ZoneSchedEntry out[ZONE_SCHED_MAX];
+    TEST_ASSERT_EQUAL(1, s.takeDue(nearWrap + 600, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_EQUAL(0, s.takeDue(nearWrap + 4999, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_EQUAL(1, s.takeDue(nearWrap + 5000, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_EQUAL_STRING("after", out[0].id);
+}
+
+void test_merge_window(void) {
+    ZoneScheduler s(10000);
+    s.set("time", 60000, 60000);
+    s.set("weather", 120000, 65000);               // due 5 s later: merged
+    s.set("location", 300000, 75000);              // 15 s later: not
+    ZoneSchedEntry out[ZONE_SCHED_MAX];
+    TEST_ASSERT_EQUAL(2, s.takeDue(60000, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_EQUAL(1, (int)s.stats().early);
+
+    // Rescheduled from the same instant, the two stay in step
+    s.reschedule(out, 2, 60500);
+    TEST_ASSERT_TRUE(s.contains("weather"));
+    TEST_ASSERT_EQUAL(75000, (int)s.nextDue());
+    TEST_ASSERT_EQUAL(1, s.takeDue(75000, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_EQUAL(120500, (int)s.nextDue());
+}
+
+void test_pull_in_and_retry(void) {
+    ZoneScheduler s(0);
+    s.set("a", 60000, 60000);
+    s.set("b", 120000, 120000);
+    TEST_ASSERT_TRUE(s.pullIn("b", 30000));
+    TEST_ASSERT_EQUAL(30000, (int)s.nextDue());
+    TEST_ASSERT_TRUE(s.pullIn("b", 90000));        // never later
+    TEST_ASSERT_EQUAL(30000, (int)s.nextDue());
+    TEST_ASSERT_FALSE(s.pullIn("zz", 0));
+
+    s.pullAllIn(1000);
+    ZoneSchedEntry out[ZONE_SCHED_MAX];
+    TEST_ASSERT_EQUAL(2, s.takeDue(1000, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_TRUE(s.empty());
+
+    s.retry(out, 2, 5000);
+    TEST_ASSERT_EQUAL(2, s.size());
+    TEST_ASSERT_EQUAL(5000, (int)s.nextDue());
+    TEST_ASSERT_EQUAL(2, s.takeDue(5000, out, ZONE_SCHED_MAX));
+    TEST_ASSERT_EQUAL(180000, (int)(out[0].periodMs + out[1].periodMs));   // periods kept
+}
+
+void test_full_heap(void) {
+    ZoneScheduler s;
+    char id[8];
+    for (int i = 0; i < ZONE_SCHED_MAX; i++) {
+        snprintf(id, sizeof(id), "z%d", i);
+        TEST_ASSERT_TRUE(s.set(id, 1000, 1000 + i));
+    }
+    TEST_ASSERT_FALSE(s.set("extra", 1000, 0));
+    TEST_ASSERT_TRUE(s.set("z3", 1000, 0));        // moving one still works
+    TEST_ASSERT_EQUAL(0, (int)s.nextDue());
+}
+
+// An hour of the tiered layout: 7 zones every minute, 8 every 2, 1 every 5
+void test_hour_of_tiers(void) {
+    ZoneScheduler s;
+    const char* t1[] = { "header.time", "status", "leg1.time", "leg2.time", "leg3.time", "leg4.time", "leg5.time" };
+    const char* t2[] = { "header.weather", "header.dayDate", "footer", "leg1", "leg2", "leg3", "leg4", "leg5" };
+    for (int i = 0; i < 7; i++) s.set(t1[i], 60000, 60000);
+    for (int i = 0; i < 8; i++) s.set(t2[i], 120000, 120000);
+    s.set("header.location", 300000, 300000);
+    TEST_ASSERT_EQUAL(16, s.size());
+
+    // The loop sleeps to the next deadline; zones are rescheduled from the
+    // start of the fetch, so its duration does not push the cadence back
+    ZoneSchedEntry out[ZONE_SCHED_MAX];
+    unsigned long now = 0;
+    int wakes = 0, zones = 0;
+    while (true) {
+        now = s.nextDue();
+        if (now > 3600000) break;
+        wakes++;
+        int n = s.takeDue(now, out, ZONE_SCHED_MAX);
+        zones += n;
+        s.reschedule(out, n, now);
+    }
+    // One request per tier would be 60 + 30 + 12 = 102
+    TEST_ASSERT_EQUAL(60, (int)s.stats().batches);
+    TEST_ASSERT_EQUAL(60, wakes);
+    TEST_ASSERT_EQUAL(60 * 7 + 30 * 8 + 12, zones);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 60.0f, ZoneScheduler::perHour(s.stats().batches, 3600000));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_earliest_first);
+    RUN_TEST(test_order_across_millis_wrap);
+    RUN_TEST(test_merge_window);
+    RUN_TEST(test_pull_in_and_retry);
+    RUN_TEST(test_full_heap);
+    RUN_TEST(test_hour_of_tiers);
+    return UNITY_END();
+}
@@ -30,7 +30,6 @@
 #define SCREEN_W 800
 #define SCREEN_H 480
 #define MAX_ZONES 10
-#define ZONE_BMP_MAX_SIZE 20000  // Max size for a single zone BMP
 
 BBEPAPER bbep(EP75_800x480);
 Preferences preferences;
@@ -62,8 +61,9 @@ struct Zone {
 Zone zones[MAX_ZONES];
 int zoneCount = 0;
 
-// Buffers
-uint8_t* zoneBmpBuffer = nullptr;
+// Parsed response. Zone bmpData points into it and is base64-decoded in
+// place, so it must outlive fetchZoneUpdates() and no BMP buffer is needed.
+JsonDocument zoneDoc;
 
 // Function declarations
 void initDisplay();
@@ -88,12 +88,6 @@ void setup() {
 
     Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
 
-    // Allocate zone BMP buffer
-    zoneBmpBuffer = (uint8_t*)malloc(ZONE_BMP_MAX_SIZE);
-    if (!zoneBmpBuffer) {
-        Serial.println("ERROR: Failed to allocate zone buffer");
-    }
-
     initDisplay();
     showBootScreen();
     
@@ -277,8 +271,8 @@ bool fetchZoneUpdates(bool forceAll) {
     Serial.printf("Received %d bytes\n", payload.length());
 
     // Parse JSON
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
+    zoneDoc.clear();
+    DeserializationError error = deserializeJson(zoneDoc, payload);
     
     if (error) {
         Serial.print("JSON error: ");
@@ -290,7 +284,7 @@ bool fetchZoneUpdates(bool forceAll) {
     zoneCount = 0;
 
     // Parse zones array
-    JsonArray zonesArray = doc["zones"].as<JsonArray>();
+    JsonArray zonesArray = zoneDoc["zones"].as<JsonArray>();
     
     for (JsonObject zoneObj : zonesArray) {
         if (zoneCount >= MAX_ZONES) break;
@@ -319,21 +313,16 @@ bool fetchZoneUpdates(bool forceAll) {
 }
 
 bool decodeAndDrawZone(Zone& zone, const char* base64Data) {
-    if (!base64Data || !zoneBmpBuffer) return false;
-    
-    // Decode base64
-    size_t base64Len = strlen(base64Data);
-    size_t decodedLen = decode_base64_length((unsigned char*)base64Data, base64Len);
-    
-    if (decodedLen > ZONE_BMP_MAX_SIZE) {
-        Serial.printf("Zone BMP too large: %d bytes\n", decodedLen);
-        return false;
-    }
+    if (!base64Data) return false;
     
-    decode_base64((unsigned char*)base64Data, base64Len, zoneBmpBuffer);
+    // Decode base64 in place - the document holds its own copy of the
+    // string, and the BMP is always shorter than its base64 text
+    uint8_t* bmp = (uint8_t*)base64Data;
+    zone.bmpSize = decode_base64(bmp, strlen(base64Data), bmp);
+    zone.bmpData = nullptr;   // no longer base64
     
     // Verify BMP header
-    if (zoneBmpBuffer[0] != 'B' || zoneBmpBuffer[1] != 'M') {
+    if (zone.bmpSize < 2 || bmp[0] != 'B' || bmp[1] != 'M') {
         Serial.println("Invalid BMP header");
         return false;
     }
@@ -341,7 +330,7 @@ bool decodeAndDrawZone(Zone& zone, const char* base64Data) {
     Serial.printf("Drawing zone '%s' at (%d,%d)\n", zone.id, zone.x, zone.y);
     
     // Use bb_epaper's loadBMP at the zone position
-    int result = bbep.loadBMP(zoneBmpBuffer, zone.x, zone.y, BBEP_BLACK, BBEP_WHITE);
+    int result = bbep.loadBMP(bmp, zone.x, zone.y, BBEP_BLACK, BBEP_WHITE);
     
     if (result != BBEP_SUCCESS) {
         Serial.printf("loadBMP failed: %d\n", result);
@@ -21,7 +21,8 @@ const KEYS = {
   API_KEY: 'cc:api:transit_key',
   GOOGLE_KEY: 'cc:api:google_key',
   PREFERENCES: 'cc:preferences',
-  STATE: 'cc:state'
+  STATE: 'cc:state',
+  ZONE_SYNC: 'cc:zones:sync'
 };
 
 // In-memory fallback for local development (no KV configured)
@@ -223,6 +224,25 @@ export async function setPreferences(preferences) {
   return await set(KEYS.PREFERENCES, preferences);
 }
 
+/**
+ * Get zone sync state (sequence numbers per zone, see zone-sync.js)
+ * @param {string} [scope] - Separate history, e.g. a demo scenario
+ * @returns {Promise<Object|null>}
+ */
+export async function getZoneSyncState(scope) {
+  return await get(scope ? `${KEYS.ZONE_SYNC}:${scope}` : KEYS.ZONE_SYNC);
+}
+
+/**
+ * Set zone sync state
+ * @param {Object} state - State from advanceZoneSync()
+ * @param {string} [scope] - Separate history, e.g. a demo scenario
+ * @returns {Promise<boolean>}
+ */
+export async function setZoneSyncState(state, scope) {
+  return await set(scope ? `${KEYS.ZONE_SYNC}:${scope}` : KEYS.ZONE_SYNC, state);
+}
+
 /**
  * Get storage status for debugging
  * @returns {Promise<Object>}
@@ -245,6 +265,8 @@ export default {
   setUserState,
   getPreferences,
   setPreferences,
+  getZoneSyncState,
+  setZoneSyncState,
   getStorageStatus,
   KEYS
 };
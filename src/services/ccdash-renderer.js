@@ -240,6 +240,16 @@ export function getZonesForTier(tier) {
   return TIER_CONFIG[tier]?.zones || [];
 }
 
+/**
+ * Refresh tier a zone belongs to (0 if not in any tier)
+ */
+export function getTierForZone(zoneId) {
+  for (const tier of [1, 2, 3]) {
+    if (TIER_CONFIG[tier].zones.includes(zoneId)) return tier;
+  }
+  return 0;
+}
+
 // =============================================================================
 // ZONE DEFINITIONS
 // =============================================================================
@@ -2495,6 +2505,7 @@ export default {
   getChangedZones,
   getZoneDefinition,
   getZonesForTier,
+  getTierForZone,
   clearCache,
   
   // Low-level utilities
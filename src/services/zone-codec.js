@@ -0,0 +1,197 @@
+/**
+ * Zone Codec - Compact 1-bit encoding for zone bitmaps
+ *
+ * Zone BMPs are mostly white and rows repeat, yet the raw 1-bit BMP costs
+ * ~100 bytes per 800px row on the wire. The "rle1" codec XORs each row
+ * with the row above and PackBits-encodes the result, so blank and
+ * repeated rows shrink to a few bytes.
+ *
+ * Negotiated per request: the device sends `X-Zone-Codec: rle1`; the
+ * server then answers with `X-Zone-Codec: rle1` and the encoded body
+ * (for bundles, every frame payload is encoded). Devices that do not ask
+ * keep getting BMPs.
+ *
+ * Stream layout (little-endian):
+ *   "Z1"  u16 width  u16 height  u8 flags (bit 0: rows XORed with row above)
+ *   PackBits body over height rows of ceil(width / 8) bytes
+ *     control n 0..127   -> n + 1 literal bytes follow
+ *     control n 129..255 -> next byte repeated 257 - n times
+ *     control 128        -> no-op
+ * Rows are MSB-first, 1 = white, unused trailing bits white. Row -1 is
+ * all white, so a blank first row is all zeros after the XOR. Runs may
+ * cross row boundaries.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+export const ZONE_CODEC = 'rle1';
+export const ZONE_CODEC_MAGIC = 'Z1';
+export const ZONE_CODEC_FLAG_XOR = 0x01;
+const HEADER_SIZE = 7;
+
+/**
+ * True if the request asked for the rle1 codec
+ */
+export function wantsZoneCodec(req) {
+  const header = req?.headers?.['x-zone-codec'];
+  if (!header) return false;
+  return String(header).split(',').map(s => s.trim().toLowerCase()).includes(ZONE_CODEC);
+}
+
+/**
+ * Unpack a 1-bit BMP into top-down rows (1 = white, pad bits white)
+ * @returns {{width: number, height: number, rowBytes: number, rows: Buffer}}
+ */
+export function bmpToRows(bmp) {
+  if (bmp.length < 62 || bmp.toString('ascii', 0, 2) !== 'BM') {
+    throw new Error('Not a BMP');
+  }
+  const dataOffset = bmp.readUInt32LE(10);
+  const infoSize = bmp.readUInt32LE(14);
+  const width = bmp.readInt32LE(18);
+  const rawHeight = bmp.readInt32LE(22);
+  const bpp = bmp.readUInt16LE(28);
+  if (bpp !== 1 || width <= 0 || rawHeight === 0) {
+    throw new Error(`Unsupported BMP: ${width}x${rawHeight} ${bpp}bpp`);
+  }
+
+  const height = Math.abs(rawHeight);
+  const bottomUp = rawHeight > 0;
+  const stride = Math.ceil(width / 32) * 4;
+  const rowBytes = Math.ceil(width / 8);
+  const padMask = width % 8 ? (0xFF >> (width % 8)) : 0;
+
+  // Palette index 0 lighter than index 1 means bits are 1 = dark
+  const pal = 14 + infoSize;
+  const luma0 = bmp[pal] + bmp[pal + 1] + bmp[pal + 2];
+  const luma1 = bmp[pal + 4] + bmp[pal + 5] + bmp[pal + 6];
+  const invert = luma0 > luma1;
+
+  const rows = Buffer.alloc(rowBytes * height);
+  for (let y = 0; y < height; y++) {
+    const src = dataOffset + (bottomUp ? height - 1 - y : y) * stride;
+    const dst = y * rowBytes;
+    for (let i = 0; i < rowBytes; i++) {
+      rows[dst + i] = invert ? ~bmp[src + i] & 0xFF : bmp[src + i];
+    }
+    if (padMask) rows[dst + rowBytes - 1] |= padMask;
+  }
+  return { width, height, rowBytes, rows };
+}
+
+/**
+ * PackBits-encode a buffer
+ */
+export function packBits(data) {
+  const out = [];
+  let i = 0;
+  while (i < data.length) {
+    // Run of 3+ identical bytes -> repeat packet
+    let run = 1;
+    while (i + run < data.length && run < 128 && data[i + run] === data[i]) run++;
+    if (run >= 3) {
+      out.push(257 - run, data[i]);
+      i += run;
+      continue;
+    }
+
+    // Literal packet up to the next run of 3
+    const start = i;
+    while (i < data.length && i - start < 128) {
+      if (i + 2 < data.length && data[i] === data[i + 1] && data[i] === data[i + 2]) break;
+      i++;
+    }
+    out.push(i - start - 1);
+    for (let k = start; k < i; k++) out.push(data[k]);
+  }
+  return Buffer.from(out);
+}
+
+/**
+ * Decode a PackBits buffer (reference for tests)
+ */
+export function unpackBits(data, expectedLength) {
+  const out = Buffer.alloc(expectedLength);
+  let o = 0;
+  let i = 0;
+  while (i < data.length && o < expectedLength) {
+    const n = data[i++];
+    if (n < 128) {
+      for (let k = 0; k <= n; k++) out[o++] = data[i++];
+    } else if (n > 128) {
+      const v = data[i++];
+      for (let k = 0; k < 257 - n; k++) out[o++] = v;
+    }
+  }
+  if (o !== expectedLength) throw new Error('PackBits stream truncated');
+  return out;
+}
+
+/**
+ * Pack top-down rows (1 = white) back into a top-down 1-bit BMP
+ */
+export function rowsToBmp({ width, height, rowBytes, rows }) {
+  const stride = Math.ceil(width / 32) * 4;
+  const bmp = Buffer.alloc(62 + stride * height);
+  bmp.write('BM', 0, 'ascii');
+  bmp.writeUInt32LE(bmp.length, 2);
+  bmp.writeUInt32LE(62, 10);
+  bmp.writeUInt32LE(40, 14);
+  bmp.writeInt32LE(width, 18);
+  bmp.writeInt32LE(-height, 22);
+  bmp.writeUInt16LE(1, 26);
+  bmp.writeUInt16LE(1, 28);
+  bmp.writeUInt32LE(stride * height, 34);
+  bmp.writeUInt32LE(2, 46);
+  bmp.writeUInt32LE(0x00000000, 54);   // index 0 black
+  bmp.writeUInt32LE(0x00FFFFFF, 58);   // index 1 white
+  for (let y = 0; y < height; y++) {
+    rows.copy(bmp, 62 + y * stride, y * rowBytes, (y + 1) * rowBytes);
+  }
+  return bmp;
+}
+
+/**
+ * Encode a 1-bit zone BMP as an rle1 stream
+ */
+export function encodeZoneRle(bmp) {
+  return encodeRowsRle(bmpToRows(bmp));
+}
+
+/**
+ * Encode top-down rows (as returned by bmpToRows) as an rle1 stream
+ */
+export function encodeRowsRle({ width, height, rowBytes, rows }) {
+  const xored = Buffer.alloc(rows.length);
+  for (let i = 0; i < rows.length; i++) {
+    const above = i >= rowBytes ? rows[i - rowBytes] : 0xFF;
+    xored[i] = rows[i] ^ above;
+  }
+
+  const header = Buffer.alloc(HEADER_SIZE);
+  header.write(ZONE_CODEC_MAGIC, 0, 'ascii');
+  header.writeUInt16LE(width, 2);
+  header.writeUInt16LE(height, 4);
+  header.writeUInt8(ZONE_CODEC_FLAG_XOR, 6);
+  return Buffer.concat([header, packBits(xored)]);
+}
+
+/**
+ * Decode an rle1 stream back to rows (reference for tests)
+ * @returns {{width: number, height: number, rowBytes: number, rows: Buffer}}
+ */
+export function decodeZoneRle(buf) {
+  if (buf.toString('ascii', 0, 2) !== ZONE_CODEC_MAGIC) throw new Error('Not an rle1 stream');
+  const width = buf.readUInt16LE(2);
+  const height = buf.readUInt16LE(4);
+  const flags = buf.readUInt8(6);
+  const rowBytes = Math.ceil(width / 8);
+  const rows = unpackBits(buf.subarray(HEADER_SIZE), rowBytes * height);
+  if (flags & ZONE_CODEC_FLAG_XOR) {
+    for (let i = 0; i < rows.length; i++) {
+      rows[i] ^= i >= rowBytes ? rows[i - rowBytes] : 0xFF;
+    }
+  }
+  return { width, height, rowBytes, rows };
+}
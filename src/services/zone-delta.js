@@ -0,0 +1,129 @@
+/**
+ * Zone Delta - Send only the changed rectangle of a zone
+ *
+ * The ETag a device already sends (If-None-Match / X-Zone-ETags) names
+ * the bitmap it currently shows. Recently rendered zones are kept here by
+ * ETag, so when that bitmap is still known the server can diff it against
+ * the new render and send just the bounding box of changed pixels. A
+ * minute tick in a leg zone then costs a few hundred bytes instead of the
+ * whole zone.
+ *
+ * The rectangle is byte aligned horizontally (x and w multiples of 8,
+ * except where it meets the zone's right edge), so the firmware can write
+ * it straight into panel RAM through an address window.
+ *
+ * Negotiated per request: the device sends `X-Zone-Delta: rect`. The
+ * history is per server instance and best effort; a cold instance or an
+ * evicted base just means the full zone is sent.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+import { bmpToRows } from './zone-codec.js';
+
+export const ZONE_DELTA = 'rect';
+
+// Largest delta worth sending, as a fraction of the zone area. Above this
+// the full zone is hardly bigger and needs no base.
+const MAX_DELTA_FRACTION = 0.6;
+const HISTORY_SIZE = 64;
+
+// etag -> BMP buffer, oldest first (Map keeps insertion order)
+const history = new Map();
+
+/**
+ * True if the request asked for rectangle deltas
+ */
+export function wantsZoneDelta(req) {
+  const header = req?.headers?.['x-zone-delta'];
+  if (!header) return false;
+  return String(header).split(',').map(s => s.trim().toLowerCase()).includes(ZONE_DELTA);
+}
+
+/**
+ * Remember a rendered zone so later requests can diff against it
+ */
+export function rememberZone(etag, bmp) {
+  if (!etag || !bmp) return;
+  history.delete(etag);
+  history.set(etag, bmp);
+  while (history.size > HISTORY_SIZE) {
+    history.delete(history.keys().next().value);
+  }
+}
+
+/**
+ * BMP previously remembered for an ETag, or undefined
+ */
+export function recallZone(etag) {
+  return etag ? history.get(etag) : undefined;
+}
+
+/**
+ * Forget every remembered zone (tests)
+ */
+export function clearZoneHistory() {
+  history.clear();
+}
+
+/**
+ * Bounding box of differing pixels between two row images of equal size,
+ * widened to whole bytes. Returns null if they are identical.
+ * @returns {{x: number, y: number, w: number, h: number}|null}
+ */
+export function diffZoneRows(base, next) {
+  const { width, height, rowBytes } = next;
+  let top = -1, bottom = -1, left = rowBytes, right = -1;
+
+  for (let y = 0; y < height; y++) {
+    const o = y * rowBytes;
+    if (base.rows.compare(next.rows, o, o + rowBytes, o, o + rowBytes) === 0) continue;
+    if (top < 0) top = y;
+    bottom = y;
+    for (let i = 0; i < left; i++) {
+      if (base.rows[o + i] !== next.rows[o + i]) { left = i; break; }
+    }
+    for (let i = rowBytes - 1; i > right; i--) {
+      if (base.rows[o + i] !== next.rows[o + i]) { right = i; break; }
+    }
+  }
+
+  if (top < 0) return null;
+  const x = left * 8;
+  return { x, y: top, w: Math.min((right + 1) * 8, width) - x, h: bottom - top + 1 };
+}
+
+/**
+ * Copy a byte-aligned rectangle out of a row image
+ */
+export function cropRows(img, rect) {
+  const rowBytes = Math.ceil(rect.w / 8);
+  const rows = Buffer.alloc(rowBytes * rect.h);
+  const first = rect.x / 8;
+  for (let y = 0; y < rect.h; y++) {
+    const src = (rect.y + y) * img.rowBytes + first;
+    img.rows.copy(rows, y * rowBytes, src, src + rowBytes);
+  }
+  return { width: rect.w, height: rect.h, rowBytes, rows };
+}
+
+/**
+ * Plan a delta from the bitmap named by baseEtag to bmp.
+ * Returns { rect, image } with the changed rectangle (zone relative) and
+ * its rows, or null if the full zone should be sent instead.
+ */
+export function planZoneDelta(baseEtag, bmp) {
+  const baseBmp = recallZone(baseEtag);
+  if (!baseBmp) return null;
+
+  const base = bmpToRows(baseBmp);
+  const next = bmpToRows(bmp);
+  if (base.width !== next.width || base.height !== next.height) return null;
+
+  const rect = diffZoneRows(base, next);
+  if (!rect) return null;   // identical: the ETag check already covers this
+  if (rect.w * rect.h > next.width * next.height * MAX_DELTA_FRACTION) return null;
+
+  return { rect, image: cropRows(next, rect) };
+}
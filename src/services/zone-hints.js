@@ -0,0 +1,126 @@
+/**
+ * Zone Change Hints - when each zone is next expected to look different
+ *
+ * Devices polled on a fixed cadence (60 s, or 20 s in some builds) even
+ * at 2 am with nothing departing for hours. With every zone response the
+ * server now says, per zone, how many seconds until that zone is next
+ * expected to change, and the device sleeps until the earliest:
+ *
+ * - clock and countdown zones (header, header.time, status, summary,
+ *   legs, leg*) change when the minute rolls over;
+ * - header.dayDate changes at midnight;
+ * - header.weather follows the weather refresh;
+ * - location, footer and divider only change with the configuration, so
+ *   they get the maximum.
+ *
+ * Quiet periods: when no departure is inside HINT_QUIET_LEAD_MIN (the
+ * departures feed only looks that far ahead) and the leave time is not
+ * either, minute rollovers are not worth a wake. Every zone is then given
+ * the time until the leave time comes inside the lead window, re-checked
+ * at least every HINT_QUIET_RECHECK_S so a new departure is seen at least
+ * that long before it leaves. The clock is allowed to lag meanwhile.
+ *
+ * Headers (seconds from the response, so the device needs no wall clock):
+ *   X-Next-Change: 42                     earliest over the listed zones
+ *   X-Zone-Next-Change: header=42,footer=3600
+ *
+ * Hints are advisory: the firmware clamps them to its own floor and
+ * ceiling, and a button press always fetches at once.
+ *
+ * Everything here is pure; `now` is a Date whose local fields are
+ * Melbourne time (as zone-bmp.js builds the dashboard data with).
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+export const HINT_MAX_S = 3600;
+export const HINT_QUIET_LEAD_MIN = 60;
+export const HINT_QUIET_RECHECK_S = 1800;
+export const HINT_WEATHER_S = 900;
+// Past the rollover, so the render the device fetches shows the new minute
+const HINT_SLACK_S = 2;
+
+const STATIC_ZONES = new Set(['header.location', 'footer', 'divider']);
+
+/**
+ * Nothing departs, and the leave time is not due, within the lead window
+ */
+export function isQuietPeriod(data) {
+  const next = data?.next_departure_minutes;
+  const leave = data?.leave_in_minutes;
+  if (next === undefined) return false;            // demo data: always live
+  if (next !== null && next <= HINT_QUIET_LEAD_MIN) return false;
+  if (leave !== null && leave !== undefined && leave <= HINT_QUIET_LEAD_MIN) return false;
+  return true;
+}
+
+function secondsToNextMinute(now) {
+  return 60 - now.getSeconds() + HINT_SLACK_S;
+}
+
+function secondsToMidnight(now) {
+  const midnight = new Date(now);
+  midnight.setHours(24, 0, 0, 0);
+  return Math.ceil((midnight - now) / 1000) + HINT_SLACK_S;
+}
+
+function quietSeconds(data, now) {
+  let s = HINT_QUIET_RECHECK_S;
+  const leave = data?.leave_in_minutes;
+  if (leave !== null && leave !== undefined) {
+    // Leave time enters the lead window at a minute boundary
+    const untilLead = (leave - HINT_QUIET_LEAD_MIN) * 60 - now.getSeconds() + HINT_SLACK_S;
+    s = Math.min(s, Math.max(untilLead, 0));
+  }
+  return s;
+}
+
+/**
+ * Seconds until zone `id` is next expected to change (1..HINT_MAX_S)
+ */
+export function zoneNextChangeS(id, data, now) {
+  let s;
+  if (STATIC_ZONES.has(id)) {
+    s = HINT_MAX_S;
+  } else if (id === 'header.dayDate') {
+    s = secondsToMidnight(now);
+  } else if (isQuietPeriod(data)) {
+    s = Math.min(quietSeconds(data, now), secondsToMidnight(now));
+  } else if (id === 'header.weather') {
+    s = HINT_WEATHER_S;
+  } else {
+    s = secondsToNextMinute(now);
+  }
+  return Math.max(1, Math.min(Math.round(s), HINT_MAX_S));
+}
+
+/**
+ * Hints for the listed zones: { zones: { [id]: seconds }, earliest }
+ */
+export function zoneHints(ids, data, now) {
+  const zones = {};
+  let earliest = HINT_MAX_S;
+  for (const id of ids) {
+    zones[id] = zoneNextChangeS(id, data, now);
+    earliest = Math.min(earliest, zones[id]);
+  }
+  return { zones, earliest };
+}
+
+/**
+ * X-Zone-Next-Change value: `id=s,id=s`
+ */
+export function formatZoneHints(zones) {
+  return Object.entries(zones).map(([id, s]) => `${id}=${s}`).join(',');
+}
+
+/**
+ * Set X-Next-Change and X-Zone-Next-Change for the listed zones
+ */
+export function setZoneHintHeaders(res, ids, data, now) {
+  const { zones, earliest } = zoneHints(ids, data, now);
+  res.setHeader('X-Next-Change', earliest);
+  res.setHeader('X-Zone-Next-Change', formatZoneHints(zones));
+  return earliest;
+}
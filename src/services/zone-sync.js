@@ -0,0 +1,70 @@
+/**
+ * Zone Sync - Sequence-numbered change tracking for zones
+ *
+ * The server keeps one monotonic sequence number for zone content and,
+ * per zone, the ETag it last rendered and the sequence at which that ETag
+ * appeared. Each sync request renders the zones, bumps the sequence once
+ * if any ETag moved, and answers with the zones whose change sequence is
+ * newer than the device's. A device that saw sequence N therefore learns
+ * everything that changed since N in one round trip, and an unchanged
+ * minute costs one request with an empty reply.
+ *
+ * The epoch identifies one history. If the stored state is lost (new KV,
+ * memory fallback on a fresh instance) a new epoch is drawn and every
+ * device with the old epoch is told to resync all zones.
+ *
+ * Everything here is pure; api/zones-sync.js loads and stores the state.
+ *
+ * State: { epoch, seq, zones: { [id]: { etag, seq } } }
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+import { randomInt } from 'crypto';
+
+/**
+ * Fresh state with a random non-zero 32-bit epoch
+ */
+export function createZoneSyncState() {
+  return { epoch: randomInt(1, 0xFFFFFFFF), seq: 0, zones: {} };
+}
+
+/**
+ * Record the current render. Returns { state, changed } where changed is
+ * true if the sequence advanced (the state needs saving).
+ * @param {object|null} state - Stored state (null to start a new epoch)
+ * @param {Array<{id: string, etag: string}>} rendered
+ */
+export function advanceZoneSync(state, rendered) {
+  const base = state && state.epoch ? state : createZoneSyncState();
+  const next = { epoch: base.epoch, seq: base.seq, zones: { ...base.zones } };
+  const moved = rendered.filter(({ id, etag }) => next.zones[id]?.etag !== etag);
+
+  if (moved.length > 0 || base !== state) {
+    next.seq++;
+    for (const { id, etag } of moved) next.zones[id] = { etag, seq: next.seq };
+  }
+  return { state: next, changed: next.seq !== base.seq || base !== state };
+}
+
+/**
+ * Zone ids the device must redraw to catch up from (epoch, since).
+ * A foreign epoch, since = 0, or a sequence from the future means the
+ * device's view is unknown, so every zone is returned.
+ */
+export function zonesChangedSince(state, ids, epoch, since) {
+  if (!since || epoch !== state.epoch || since > state.seq) return [...ids];
+  return ids.filter(id => !state.zones[id] || state.zones[id].seq > since);
+}
+
+/**
+ * Parse the since/epoch query params as unsigned integers (0 if absent)
+ */
+export function parseSyncCursor(query) {
+  const toU32 = v => {
+    const n = Number.parseInt(String(v ?? ''), 10);
+    return Number.isFinite(n) && n > 0 && n <= 0xFFFFFFFF ? n : 0;
+  };
+  return { since: toU32(query?.since), epoch: toU32(query?.epoch) };
+}
@@ -0,0 +1,170 @@
+/**
+ * Test Zone Codec (rle1)
+ *
+ * Round-trips synthetic 1-bit zone BMPs through the rle1 encoder and
+ * reports the size saving against the raw BMP. No canvas needed.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+import {
+  bmpToRows,
+  packBits,
+  unpackBits,
+  encodeZoneRle,
+  decodeZoneRle,
+  wantsZoneCodec
+} from '../src/services/zone-codec.js';
+
+console.log('═'.repeat(70));
+console.log('  ZONE CODEC (rle1) TEST SUITE');
+console.log('═'.repeat(70));
+console.log();
+
+let passed = 0;
+let failed = 0;
+
+function test(name, condition, details = '') {
+  if (condition) {
+    console.log(`   ✅ ${name}`);
+    passed++;
+  } else {
+    console.log(`   ❌ ${name} ${details ? `— ${details}` : ''}`);
+    failed++;
+  }
+}
+
+/**
+ * Build a 1-bit BMP like canvasToBMP() does. pixel(x, y) returns true for ink.
+ */
+function makeBmp(w, h, pixel, { bottomUp = false, inkIsOne = false } = {}) {
+  const stride = Math.ceil(w / 32) * 4;
+  const buf = Buffer.alloc(62 + stride * h);
+  buf.write('BM', 0);
+  buf.writeUInt32LE(buf.length, 2);
+  buf.writeUInt32LE(62, 10);
+  buf.writeUInt32LE(40, 14);
+  buf.writeInt32LE(w, 18);
+  buf.writeInt32LE(bottomUp ? h : -h, 22);
+  buf.writeUInt16LE(1, 26);
+  buf.writeUInt16LE(1, 28);
+  buf.writeUInt32LE(inkIsOne ? 0x00FFFFFF : 0x00000000, 54);
+  buf.writeUInt32LE(inkIsOne ? 0x00000000 : 0x00FFFFFF, 58);
+  for (let y = 0; y < h; y++) {
+    const row = 62 + (bottomUp ? h - 1 - y : y) * stride;
+    for (let x = 0; x < w; x++) {
+      const ink = pixel(x, y);
+      const bit = inkIsOne ? ink : !ink;
+      if (bit) buf[row + (x >> 3)] |= 0x80 >> (x & 7);
+    }
+  }
+  return buf;
+}
+
+/** Pixel at (x, y) from decoded rows, true = white */
+function rowPixel(rows, rowBytes, x, y) {
+  return (rows[y * rowBytes + (x >> 3)] & (0x80 >> (x & 7))) !== 0;
+}
+
+// Mostly-white UI content: a frame, a few text lines of glyph blocks, a bar
+function dashboardInk(w, h) {
+  let seed = 12345;
+  const rand = () => (seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff;
+  const glyphs = [];
+  for (let line = 0; line < Math.floor(h / 40); line++) {
+    for (let gx = 12; gx < w - 20; gx += 9) {
+      if (rand() < 0.7) glyphs.push({ x: gx, y: 12 + line * 40, bits: Math.floor(rand() * 0xFFFF) });
+    }
+  }
+  return (x, y) => {
+    if (x < 2 || y < 2 || x >= w - 2 || y >= h - 2) return true;        // border
+    if (y >= h - 14 && y < h - 8 && x < w * 0.6) return true;            // progress bar
+    for (const g of glyphs) {
+      if (x >= g.x && x < g.x + 8 && y >= g.y && y < g.y + 16) {
+        return ((g.bits >> ((x - g.x) + ((y - g.y) >> 3) * 8)) & 1) === 1;
+      }
+    }
+    return false;
+  };
+}
+
+// =============================================================================
+// TEST 1: PackBits
+// =============================================================================
+
+console.log('Test 1: PackBits');
+{
+  const cases = [
+    Buffer.alloc(0),
+    Buffer.from([1]),
+    Buffer.alloc(1000, 0),
+    Buffer.from([1, 2, 3, 3, 3, 3, 4, 5, 5, 6]),
+    Buffer.from(Array.from({ length: 700 }, (_, i) => (i * 7919) & 0xFF))
+  ];
+  for (const [i, c] of cases.entries()) {
+    const packed = packBits(c);
+    test(`case ${i} (${c.length} bytes -> ${packed.length})`, unpackBits(packed, c.length).equals(c));
+  }
+}
+console.log();
+
+// =============================================================================
+// TEST 2: Round trip, all BMP layouts
+// =============================================================================
+
+console.log('Test 2: rle1 round trip');
+for (const [w, h] of [[1, 1], [7, 3], [180, 70], [370, 150], [761, 33]]) {
+  for (const bottomUp of [false, true]) {
+    for (const inkIsOne of [false, true]) {
+      const ink = dashboardInk(w, h);
+      const bmp = makeBmp(w, h, ink, { bottomUp, inkIsOne });
+      const { rowBytes, rows } = decodeZoneRle(encodeZoneRle(bmp));
+      let ok = true;
+      for (let y = 0; y < h && ok; y++) {
+        for (let x = 0; x < w; x++) {
+          if (rowPixel(rows, rowBytes, x, y) === ink(x, y)) { ok = false; break; }
+        }
+        // Unused trailing bits must read as white
+        if (w % 8 && (rows[y * rowBytes + rowBytes - 1] | ((0xFF << (8 - (w % 8))) & 0xFF)) !== 0xFF) ok = false;
+      }
+      test(`${w}x${h} ${bottomUp ? 'bottom-up' : 'top-down'} ink=${inkIsOne ? 1 : 0}`, ok);
+    }
+  }
+}
+console.log();
+
+// =============================================================================
+// TEST 3: Size on realistic zones
+// =============================================================================
+
+console.log('Test 3: Compression');
+for (const [name, w, h] of [['header', 800, 94], ['summary', 800, 28], ['legs', 800, 316], ['footer', 800, 32]]) {
+  const bmp = makeBmp(w, h, dashboardInk(w, h));
+  const rle = encodeZoneRle(bmp);
+  const ratio = bmp.length / rle.length;
+  test(`${name}: ${bmp.length} -> ${rle.length} bytes (${ratio.toFixed(1)}x)`, ratio > 3);
+}
+{
+  const blank = makeBmp(800, 316, () => false);
+  const rle = encodeZoneRle(blank);
+  test(`blank legs: ${blank.length} -> ${rle.length} bytes`, rle.length < 1024);
+}
+console.log();
+
+// =============================================================================
+// TEST 4: Negotiation and input checks
+// =============================================================================
+
+console.log('Test 4: Negotiation');
+test('header rle1', wantsZoneCodec({ headers: { 'x-zone-codec': 'rle1' } }));
+test('header list', wantsZoneCodec({ headers: { 'x-zone-codec': 'g4, RLE1' } }));
+test('no header', !wantsZoneCodec({ headers: {} }));
+test('rejects non-BMP', (() => { try { bmpToRows(Buffer.alloc(100)); return false; } catch { return true; } })());
+console.log();
+
+console.log('═'.repeat(70));
+console.log(`   Passed: ${passed} ✅   Failed: ${failed} ❌`);
+console.log('═'.repeat(70));
+
+process.exit(failed > 0 ? 1 : 0);
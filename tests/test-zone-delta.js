@@ -0,0 +1,147 @@
+/**
+ * Test Zone Delta (changed-rectangle updates)
+ *
+ * Diffs synthetic zone bitmaps, checks that applying the delta rectangle
+ * over the base reproduces the new bitmap, and reports the payload size
+ * against a full zone. No canvas needed.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+import { bmpToRows, rowsToBmp, encodeZoneRle, encodeRowsRle } from '../src/services/zone-codec.js';
+import {
+  wantsZoneDelta,
+  rememberZone,
+  clearZoneHistory,
+  diffZoneRows,
+  planZoneDelta
+} from '../src/services/zone-delta.js';
+
+console.log('═'.repeat(70));
+console.log('  ZONE DELTA TEST SUITE');
+console.log('═'.repeat(70));
+console.log();
+
+let passed = 0;
+let failed = 0;
+
+function test(name, condition, details = '') {
+  if (condition) {
+    console.log(`   ✅ ${name}`);
+    passed++;
+  } else {
+    console.log(`   ❌ ${name} ${details ? `— ${details}` : ''}`);
+    failed++;
+  }
+}
+
+/**
+ * Top-down 1-bit BMP, pixel(x, y) true for ink
+ */
+function makeBmp(w, h, pixel) {
+  const rowBytes = Math.ceil(w / 8);
+  const rows = Buffer.alloc(rowBytes * h, 0xFF);
+  for (let y = 0; y < h; y++) {
+    for (let x = 0; x < w; x++) {
+      if (pixel(x, y)) rows[y * rowBytes + (x >> 3)] &= ~(0x80 >> (x & 7));
+    }
+  }
+  return rowsToBmp({ width: w, height: h, rowBytes, rows });
+}
+
+// A leg row: icon, stop name and a departure time whose minute digits change
+function legInk(minute) {
+  return (x, y) => {
+    if (y < 2 || y >= 52) return false;
+    if (x >= 8 && x < 48 && y >= 8 && y < 48) return (x + y) % 3 === 0;      // mode icon
+    if (x >= 64 && x < 400 && y >= 14 && y < 30) return (x * 7 + y) % 5 < 2;  // stop name
+    if (x >= 690 && x < 740 && y >= 14 && y < 40) return ((x ^ y) + minute) % 4 === 0;
+    return false;
+  };
+}
+
+/**
+ * Paste a rectangle of rows over a base image, as the firmware does
+ */
+function applyDelta(base, rect, img) {
+  const out = Buffer.from(base.rows);
+  for (let y = 0; y < rect.h; y++) {
+    for (let x = 0; x < rect.w; x++) {
+      const bit = img.rows[y * img.rowBytes + (x >> 3)] & (0x80 >> (x & 7));
+      const ox = rect.x + x;
+      const i = (rect.y + y) * base.rowBytes + (ox >> 3);
+      const m = 0x80 >> (ox & 7);
+      out[i] = bit ? out[i] | m : out[i] & ~m;
+    }
+  }
+  return out;
+}
+
+// =============================================================================
+// TEST 1: Diff
+// =============================================================================
+
+console.log('Test 1: Changed rectangle');
+{
+  const a = bmpToRows(makeBmp(784, 54, legInk(3)));
+  const b = bmpToRows(makeBmp(784, 54, legInk(4)));
+  test('identical images -> null', diffZoneRows(a, a) === null);
+
+  const rect = diffZoneRows(a, b);
+  test('rect found', rect !== null);
+  test(`rect byte aligned (${rect.x},${rect.y} ${rect.w}x${rect.h})`, rect.x % 8 === 0 && rect.w % 8 === 0);
+  test('rect covers the time only', rect.x >= 688 && rect.x + rect.w <= 744 && rect.y >= 14 && rect.y + rect.h <= 40);
+
+  const edgeA = bmpToRows(makeBmp(61, 5, () => false));
+  const edgeB = bmpToRows(makeBmp(61, 5, (x, y) => x === 60 && y === 2));
+  const edge = diffZoneRows(edgeA, edgeB);
+  test('rect clipped at the right edge', edge.x === 56 && edge.w === 5 && edge.y === 2 && edge.h === 1);
+}
+console.log();
+
+// =============================================================================
+// TEST 2: Plan and apply
+// =============================================================================
+
+console.log('Test 2: Plan and apply');
+{
+  clearZoneHistory();
+  const before = makeBmp(784, 54, legInk(3));
+  const after = makeBmp(784, 54, legInk(4));
+  test('unknown base -> full zone', planZoneDelta('"nope"', after) === null);
+
+  rememberZone('"v3"', before);
+  const plan = planZoneDelta('"v3"', after);
+  test('known base -> delta', plan !== null);
+
+  const applied = applyDelta(bmpToRows(before), plan.rect, plan.image);
+  test('base + delta == new bitmap', applied.equals(bmpToRows(after).rows));
+
+  const viaRle = bmpToRows(rowsToBmp(plan.image));
+  test('delta image survives BMP round trip', viaRle.rows.equals(plan.image.rows));
+
+  const full = encodeZoneRle(after).length;
+  const delta = encodeRowsRle(plan.image).length;
+  test(`payload: full ${after.length} B BMP / ${full} B rle1 -> delta ${delta} B rle1`, delta < full && delta < 1024);
+
+  const inverted = makeBmp(784, 54, (x, y) => !legInk(4)(x, y));
+  test('mostly changed -> full zone', planZoneDelta('"v3"', inverted) === null);
+  test('size mismatch -> full zone', planZoneDelta('"v3"', makeBmp(800, 54, legInk(4))) === null);
+}
+console.log();
+
+// =============================================================================
+// TEST 3: Negotiation
+// =============================================================================
+
+console.log('Test 3: Negotiation');
+test('header rect', wantsZoneDelta({ headers: { 'x-zone-delta': 'rect' } }));
+test('no header', !wantsZoneDelta({ headers: {} }));
+console.log();
+
+console.log('═'.repeat(70));
+console.log(`   Passed: ${passed} ✅   Failed: ${failed} ❌`);
+console.log('═'.repeat(70));
+
+process.exit(failed > 0 ? 1 : 0);
@@ -0,0 +1,100 @@
+/**
+ * Test Zone Change Hints
+ *
+ * Checks per-zone next-change seconds through a busy morning minute, a
+ * quiet night and the midnight rollover.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+import {
+  HINT_MAX_S,
+  HINT_QUIET_RECHECK_S,
+  HINT_WEATHER_S,
+  isQuietPeriod,
+  zoneNextChangeS,
+  zoneHints,
+  formatZoneHints
+} from '../src/services/zone-hints.js';
+
+console.log('═'.repeat(70));
+console.log('  ZONE HINTS TEST SUITE');
+console.log('═'.repeat(70));
+console.log();
+
+let passed = 0;
+let failed = 0;
+
+function test(name, condition, details = '') {
+  if (condition) {
+    console.log(`   ✅ ${name}`);
+    passed++;
+  } else {
+    console.log(`   ❌ ${name} ${details ? `— ${details}` : ''}`);
+    failed++;
+  }
+}
+
+const at = (h, m, s) => new Date(2026, 0, 28, h, m, s);
+const busy = { next_departure_minutes: 4, leave_in_minutes: 12 };
+const night = { next_departure_minutes: null, leave_in_minutes: 380 };
+
+// =============================================================================
+// TEST 1: Busy period
+// =============================================================================
+
+console.log('Test 1: Busy period');
+{
+  const now = at(7, 45, 20);
+  test('not quiet', !isQuietPeriod(busy));
+  test('clock -> next minute', zoneNextChangeS('header.time', busy, now) === 42);
+  test('legs -> next minute', zoneNextChangeS('leg2', busy, now) === 42);
+  test('weather -> weather refresh', zoneNextChangeS('header.weather', busy, now) === HINT_WEATHER_S);
+  test('footer -> max', zoneNextChangeS('footer', busy, now) === HINT_MAX_S);
+  test('demo data is never quiet', !isQuietPeriod({ leave_in_minutes: null }));
+
+  const { zones, earliest } = zoneHints(['header', 'footer'], busy, now);
+  test('earliest is the minute', earliest === 42);
+  test('header format', formatZoneHints(zones) === `header=42,footer=${HINT_MAX_S}`);
+}
+console.log();
+
+// =============================================================================
+// TEST 2: Quiet night
+// =============================================================================
+
+console.log('Test 2: Quiet night');
+{
+  const now = at(2, 0, 10);
+  test('quiet', isQuietPeriod(night));
+  test('clock waits for the recheck', zoneNextChangeS('header.time', night, now) === HINT_QUIET_RECHECK_S);
+  test('weather too', zoneNextChangeS('header.weather', night, now) === HINT_QUIET_RECHECK_S);
+
+  // Leave time 65 min away: wake when it enters the 60 min lead
+  const soon = { next_departure_minutes: null, leave_in_minutes: 65 };
+  test('wakes for the leave window', zoneNextChangeS('status', soon, now) === 5 * 60 - 10 + 2);
+
+  // A departure inside the feed window ends the quiet period
+  test('departure in 45 min -> busy', !isQuietPeriod({ next_departure_minutes: 45, leave_in_minutes: 380 }));
+}
+console.log();
+
+// =============================================================================
+// TEST 3: Midnight
+// =============================================================================
+
+console.log('Test 3: Midnight');
+{
+  const now = at(23, 50, 0);
+  test('date -> midnight', zoneNextChangeS('header.dayDate', night, now) === 600 + 2);
+  test('quiet zones wake for the new day', zoneNextChangeS('header.time', night, now) === 600 + 2);
+  test('capped at max', zoneNextChangeS('header.dayDate', busy, at(9, 0, 0)) === HINT_MAX_S);
+}
+console.log();
+
+console.log('═'.repeat(70));
+console.log(`   Passed: ${passed} ✅   Failed: ${failed} ❌`);
+console.log('═'.repeat(70));
+
+process.exit(failed > 0 ? 1 : 0);
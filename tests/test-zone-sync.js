@@ -0,0 +1,100 @@
+/**
+ * Test Zone Sync (sequence-numbered change tracking)
+ *
+ * Drives the pure sync state machine through a few refresh cycles and
+ * checks what a device with a given cursor is told to redraw.
+ *
+ * Copyright (c) 2026 Angus Bergman
+ * Licensed under CC BY-NC 4.0
+ */
+
+import {
+  advanceZoneSync,
+  zonesChangedSince,
+  parseSyncCursor
+} from '../src/services/zone-sync.js';
+
+console.log('═'.repeat(70));
+console.log('  ZONE SYNC TEST SUITE');
+console.log('═'.repeat(70));
+console.log();
+
+let passed = 0;
+let failed = 0;
+
+function test(name, condition, details = '') {
+  if (condition) {
+    console.log(`   ✅ ${name}`);
+    passed++;
+  } else {
+    console.log(`   ❌ ${name} ${details ? `— ${details}` : ''}`);
+    failed++;
+  }
+}
+
+const IDS = ['header', 'summary', 'legs', 'footer'];
+const render = etags => IDS.map(id => ({ id, etag: etags[id] || `"${id}-0"` }));
+const same = (a, b) => a.length === b.length && a.every((v, i) => v === b[i]);
+
+// =============================================================================
+// TEST 1: Sequence advances only on change
+// =============================================================================
+
+console.log('Test 1: Sequence');
+let state;
+{
+  const first = advanceZoneSync(null, render({}));
+  state = first.state;
+  test('new state gets an epoch', state.epoch > 0 && state.epoch <= 0xFFFFFFFF);
+  test('first render is seq 1', state.seq === 1 && first.changed);
+
+  const again = advanceZoneSync(state, render({}));
+  test('unchanged render keeps seq', again.state.seq === 1 && !again.changed);
+
+  const tick = advanceZoneSync(state, render({ header: '"header-1"' }));
+  test('one zone changed -> seq 2', tick.state.seq === 2 && tick.changed);
+  test('only that zone stamped', tick.state.zones.header.seq === 2 && tick.state.zones.legs.seq === 1);
+  test('input state not mutated', state.seq === 1 && state.zones.header.etag === '"header-0"');
+  state = tick.state;
+}
+console.log();
+
+// =============================================================================
+// TEST 2: What a device must redraw
+// =============================================================================
+
+console.log('Test 2: Changed since cursor');
+{
+  const { epoch } = state;
+  test('up to date -> nothing', zonesChangedSince(state, IDS, epoch, 2).length === 0);
+  test('one behind -> header', same(zonesChangedSince(state, IDS, epoch, 1), ['header']));
+  test('no cursor -> everything', same(zonesChangedSince(state, IDS, epoch, 0), IDS));
+  test('other epoch -> everything', same(zonesChangedSince(state, IDS, epoch ^ 1, 2), IDS));
+  test('future seq -> everything', same(zonesChangedSince(state, IDS, epoch, 9), IDS));
+  test('zone never seen -> included', same(zonesChangedSince(state, [...IDS, 'divider'], epoch, 2), ['divider']));
+
+  const s3 = advanceZoneSync(state, render({ header: '"header-1"', legs: '"legs-1"' })).state;
+  const s4 = advanceZoneSync(s3, render({ header: '"header-2"', legs: '"legs-1"' })).state;
+  test('two behind -> union of changes', same(zonesChangedSince(s4, IDS, epoch, 2), ['header', 'legs']));
+}
+console.log();
+
+// =============================================================================
+// TEST 3: Cursor parsing
+// =============================================================================
+
+console.log('Test 3: Cursor parsing');
+{
+  const c = parseSyncCursor({ since: '42', epoch: '3735928559' });
+  test('parses since/epoch', c.since === 42 && c.epoch === 3735928559);
+  const bad = parseSyncCursor({ since: '-1', epoch: 'zz' });
+  test('rejects junk', bad.since === 0 && bad.epoch === 0);
+  test('missing -> 0', parseSyncCursor(undefined).since === 0);
+}
+console.log();
+
+console.log('═'.repeat(70));
+console.log(`   Passed: ${passed} ✅   Failed: ${failed} ❌`);
+console.log('═'.repeat(70));
+
+process.exit(failed > 0 ? 1 : 0);